@@ -1,6 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -15,1219 +22,8838 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <pthread.h>
 #ifdef __linux__
 #include <linux/hdreg.h>
 #include <linux/fs.h>
 #include <scsi/sg.h>
 #include <scsi/scsi.h>
+#include <linux/nvme_ioctl.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <sys/uio.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <ftw.h>
+#include <linux/perf_event.h>
+#include <linux/loop.h>
+#include <sys/vfs.h>
+#include <sys/resource.h>
+#include <malloc.h>
+#include <linux/io_uring.h>
 #endif
 #endif
 
+// AVX2/AVX-512 keystream for the random wipe pattern, selected at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PATTERN_HAVE_X86_SIMD
+#endif
+
 // Function declarations
-void analyze_usb_device_details(const char* device);
-void analyze_mobile_device_type(const char* usb_device_path);
+struct device_profile;
+void analyze_usb_device_details(const struct device_profile* profile);
+void analyze_mobile_device_type(const struct usb_topology* topology, const struct usb_device_record* usb);
 void list_all_usb_devices(void);
 
-void check_hpa_dco_linux(const char* device) {
-    char device_path[256];
-    snprintf(device_path, sizeof(device_path), "/dev/%s", device);
-    
-    printf("=== HPA/DCO Analysis ===\n");
-    
-    int fd = open(device_path, O_RDONLY);
-    if (fd < 0) {
-        printf("Cannot open %s for HPA/DCO analysis (try running as root)\n", device_path);
+// Number of devices probed at the same time by list_available_devices() (--jobs)
+// 1 keeps the classic sequential scan, 0 means one worker per device
+static int scan_jobs = 1;
+
+// Output of device and USB scans (--format). The structured formats write one
+// self-contained record per device as soon as its probe finishes.
+enum output_format {
+    OUTPUT_TEXT,        // human readable report
+    OUTPUT_NDJSON,      // one JSON object per line
+    OUTPUT_BINARY       // JSON object prefixed with its 32-bit little-endian length
+};
+static enum output_format output_format = OUTPUT_TEXT;
+
+// Growable text buffer holding the report of a single device
+struct report_buffer {
+    char *data;
+    size_t len;
+    size_t cap;
+};
+
+// Report output of the calling thread. Scan workers point this at their own
+// buffer; when it is NULL the report goes straight to stdout.
+#ifdef _WIN32
+static __declspec(thread) struct report_buffer *current_report = NULL;
+#else
+static __thread struct report_buffer *current_report = NULL;
+#endif
+
+// Append formatted text to a growable buffer
+static void buffer_vprintf(struct report_buffer *buf, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int needed = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (needed < 0) {
         return;
     }
     
-    // Check if it's NVMe device
-    if (strncmp(device, "nvme", 4) == 0) {
-        printf("NVMe Device Detected - Checking security features...\n");
-        
-        unsigned long long size;
-        if (ioctl(fd, BLKGETSIZE64, &size) == 0) {
-            printf("Device Size: %llu bytes (%.2f GB)\n", 
-                   size, size / (1024.0 * 1024.0 * 1024.0));
+    if (buf->len + needed + 1 > buf->cap) {
+        size_t new_cap = buf->cap ? buf->cap : 4096;
+        while (buf->len + needed + 1 > new_cap) {
+            new_cap *= 2;
         }
-        
-        // Check NVMe namespace information
-        char cmd[512];
-        snprintf(cmd, sizeof(cmd), "nvme list | grep %s", device_path);
-        FILE *nvme_output = popen(cmd, "r");
-        if (nvme_output) {
-            char line[512];
-            if (fgets(line, sizeof(line), nvme_output)) {
-                printf("NVMe Info: %s", line);
-            }
-            pclose(nvme_output);
-        }
-        
-        // Check for NVMe security features
-        snprintf(cmd, sizeof(cmd), "nvme id-ctrl %s 2>/dev/null | grep -E 'ses|cfs|Format NVM|Crypto Erase'", device_path);
-        nvme_output = popen(cmd, "r");
-        if (nvme_output) {
-            char line[256];
-            int found_security = 0;
-            printf("NVMe Security Features:\n");
-            while (fgets(line, sizeof(line), nvme_output)) {
-                printf("  %s", line);
-                found_security = 1;
-            }
-            if (!found_security) {
-                printf("  Standard NVMe security features available\n");
-            }
-            pclose(nvme_output);
+        char *new_data = (char*)realloc(buf->data, new_cap);
+        if (!new_data) {
+            return;
         }
-        
-        printf("HPA/DCO Status: Not applicable for NVMe devices\n");
-        printf("Note: NVMe uses different security mechanisms than ATA devices\n");
-        
+        buf->data = new_data;
+        buf->cap = new_cap;
+    }
+    
+    vsnprintf(buf->data + buf->len, buf->cap - buf->len, format, args);
+    buf->len += needed;
+}
+
+static void buffer_printf(struct report_buffer *buf, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    buffer_vprintf(buf, format, args);
+    va_end(args);
+}
+
+static void report_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (current_report) {
+        buffer_vprintf(current_report, format, args);
     } else {
-        // Check if it's an ATA device
-        struct hd_driveid drive_id;
-        if (ioctl(fd, HDIO_GET_IDENTITY, &drive_id) == 0) {
-            printf("ATA Device Detected - Checking for HPA/DCO...\n");
-            
-            // Get accessible capacity
-            unsigned long long accessible_max = 0;
-            unsigned long long kernel_size = 0;
-            if (ioctl(fd, BLKGETSIZE64, &kernel_size) == 0) {
-                accessible_max = kernel_size / 512; // Convert bytes to sectors
-                printf("Accessible Capacity: %llu sectors (%.2f GB)\n", 
-                       accessible_max, (accessible_max * 512.0) / (1024.0 * 1024.0 * 1024.0));
-            }
-            
-            // Check for HPA (Host Protected Area)
-            printf("HPA Status: ");
-            if (drive_id.command_set_2 & 0x0400) { // HPA feature set supported
-                printf("HPA Feature Supported\n");
-                
-                // Try using hdparm to get more detailed info
-                char cmd[512];
-                snprintf(cmd, sizeof(cmd), "hdparm -N %s 2>/dev/null", device_path);
-                FILE *hdparm_output = popen(cmd, "r");
-                if (hdparm_output) {
-                    char line[256];
-                    printf("HPA Information:\n");
-                    while (fgets(line, sizeof(line), hdparm_output)) {
-                        if (strstr(line, "max sectors") || strstr(line, "HPA") || 
-                            strstr(line, "sectors") || strstr(line, "enabled")) {
-                            printf("  %s", line);
-                        }
-                    }
-                    pclose(hdparm_output);
+        vprintf(format, args);
+    }
+    va_end(args);
+}
+
+// ---------------------------------------------------------------------------
+// Structured records (--format ndjson / binary)
+// ---------------------------------------------------------------------------
+
+#define RECORD_MAX_DEPTH 8
+
+// A JSON object under construction. Every record carries its type and the
+// host name so collectors can merge streams from many machines.
+struct record {
+    struct report_buffer buf;
+    int depth;
+    int has_fields[RECORD_MAX_DEPTH];
+};
+
+static char record_host[256] = "";
+
+#ifndef _WIN32
+static pthread_mutex_t record_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void record_put_string(struct record* rec, const char* value) {
+    buffer_printf(&rec->buf, "\"");
+    for (const unsigned char *p = (const unsigned char*)value; *p; p++) {
+        switch (*p) {
+            case '"': buffer_printf(&rec->buf, "\\\""); break;
+            case '\\': buffer_printf(&rec->buf, "\\\\"); break;
+            case '\n': buffer_printf(&rec->buf, "\\n"); break;
+            case '\r': buffer_printf(&rec->buf, "\\r"); break;
+            case '\t': buffer_printf(&rec->buf, "\\t"); break;
+            default:
+                if (*p < 0x20) {
+                    buffer_printf(&rec->buf, "\\u%04x", *p);
                 } else {
-                    printf("  Unable to get detailed HPA info (hdparm not available)\n");
-                }
-            } else {
-                printf("HPA Feature Not Supported\n");
-            }
-            
-            // Check for DCO (Device Configuration Overlay)
-            printf("DCO Status: ");
-            if (drive_id.command_set_2 & 0x0800) { // DCO feature set supported
-                printf("DCO Feature Supported\n");
-                printf("  ⚠️  Warning: DCO may hide device capacity and features\n");
-                
-                // Try to get DCO information
-                char dco_cmd[512];
-                snprintf(dco_cmd, sizeof(dco_cmd), "hdparm --dco-identify %s 2>/dev/null", device_path);
-                FILE *dco_output = popen(dco_cmd, "r");
-                if (dco_output) {
-                    char line[256];
-                    printf("DCO Information:\n");
-                    while (fgets(line, sizeof(line), dco_output)) {
-                        if (strstr(line, "Real max sectors") || strstr(line, "DCO")) {
-                            printf("  %s", line);
-                        }
-                    }
-                    pclose(dco_output);
-                }
-            } else {
-                printf("DCO Feature Not Supported\n");
-            }
-            
-            // Additional security features
-            printf("\n=== ATA Security Features ===\n");
-            
-            // Security feature set
-            if (drive_id.command_set_1 & 0x0002) {
-                printf("Security Feature Set: ✓ Supported\n");
-                
-                // Get detailed security status
-                char sec_cmd[512];
-                snprintf(sec_cmd, sizeof(sec_cmd), "hdparm -I %s 2>/dev/null | grep -A5 -B5 -i security", device_path);
-                FILE *sec_output = popen(sec_cmd, "r");
-                if (sec_output) {
-                    char line[256];
-                    while (fgets(line, sizeof(line), sec_output)) {
-                        if (strstr(line, "Security") || strstr(line, "enabled") || 
-                            strstr(line, "locked") || strstr(line, "erase")) {
-                            printf("  %s", line);
-                        }
-                    }
-                    pclose(sec_output);
-                }
-            } else {
-                printf("Security Feature Set: ✗ Not Supported\n");
-            }
-            
-            // Sanitize feature set (ACS-2)
-            if (drive_id.command_set_2 & 0x1000) {
-                printf("Sanitize Feature: ✓ Supported\n");
-            } else {
-                printf("Sanitize Feature: ✗ Not Supported\n");
-            }
-            
-        } else {
-            printf("Not an ATA device or unable to get ATA identity\n");
-            
-            // For non-ATA devices, try alternative methods
-            printf("Attempting alternative capacity detection...\n");
-            
-            unsigned long long size;
-            if (ioctl(fd, BLKGETSIZE64, &size) == 0) {
-                printf("Device Size: %llu bytes (%.2f GB)\n", 
-                       size, size / (1024.0 * 1024.0 * 1024.0));
-            }
-            
-            // Check if it's a SCSI device
-            char scsi_path[256];
-            snprintf(scsi_path, sizeof(scsi_path), "/sys/block/%s/device/type", device);
-            FILE *type_file = fopen(scsi_path, "r");
-            if (type_file) {
-                int device_type;
-                if (fscanf(type_file, "%d", &device_type) == 1) {
-                    printf("SCSI Device Type: %d ", device_type);
-                    switch (device_type) {
-                        case 0: printf("(Direct Access - Disk)\n"); break;
-                        case 5: printf("(CD-ROM)\n"); break;
-                        case 7: printf("(Optical Memory)\n"); break;
-                        default: printf("(Other)\n"); break;
-                    }
+                    buffer_printf(&rec->buf, "%c", *p);
                 }
-                fclose(type_file);
-            }
-            
-            printf("HPA/DCO Status: Not applicable for this device type\n");
+                break;
         }
     }
-    
-    close(fd);
+    buffer_printf(&rec->buf, "\"");
+}
+
+static void record_key(struct record* rec, const char* name) {
+    if (rec->has_fields[rec->depth]) {
+        buffer_printf(&rec->buf, ",");
+    }
+    rec->has_fields[rec->depth] = 1;
+    record_put_string(rec, name);
+    buffer_printf(&rec->buf, ":");
+}
+
+static void record_begin(struct record* rec, const char* type) {
+    memset(rec, 0, sizeof(*rec));
+    buffer_printf(&rec->buf, "{");
+    record_key(rec, "type");
+    record_put_string(rec, type);
+    if (record_host[0]) {
+        record_key(rec, "host");
+        record_put_string(rec, record_host);
+    }
+}
+
+// Empty strings are left out, sysfs and identify data use them for "not reported"
+static void record_string(struct record* rec, const char* name, const char* value) {
+    if (!value || !value[0]) {
+        return;
+    }
+    record_key(rec, name);
+    record_put_string(rec, value);
+}
+
+static void record_int(struct record* rec, const char* name, long long value) {
+    record_key(rec, name);
+    buffer_printf(&rec->buf, "%lld", value);
+}
+
+// Counters that use -1 for "unknown" are left out instead
+static void record_known(struct record* rec, const char* name, long long value) {
+    if (value >= 0) {
+        record_int(rec, name, value);
+    }
+}
+
+static void record_uint(struct record* rec, const char* name, unsigned long long value) {
+    record_key(rec, name);
+    buffer_printf(&rec->buf, "%llu", value);
+}
+
+static void record_bool(struct record* rec, const char* name, int value) {
+    record_key(rec, name);
+    buffer_printf(&rec->buf, value ? "true" : "false");
 }
 
-void check_smart_info_linux(const char* device) {
-    printf("\n=== SMART Status ===\n");
+static void record_object_begin(struct record* rec, const char* name) {
+    record_key(rec, name);
+    buffer_printf(&rec->buf, "{");
+    if (rec->depth + 1 < RECORD_MAX_DEPTH) {
+        rec->depth++;
+        rec->has_fields[rec->depth] = 0;
+    }
+}
+
+static void record_object_end(struct record* rec) {
+    buffer_printf(&rec->buf, "}");
+    if (rec->depth > 0) {
+        rec->depth--;
+    }
+}
+
+// Close the record and write it to stdout as one unit, then release it.
+// Safe to call from scan workers; records never interleave.
+static void record_emit(struct record* rec) {
+    buffer_printf(&rec->buf, "}");
+    if (!rec->buf.data) {
+        return;
+    }
     
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd), "smartctl -H /dev/%s 2>/dev/null", device);
+#ifndef _WIN32
+    pthread_mutex_lock(&record_lock);
+#endif
+    if (output_format == OUTPUT_BINARY) {
+        uint32_t len = (uint32_t)rec->buf.len;
+        unsigned char prefix[4] = {
+            (unsigned char)(len & 0xff), (unsigned char)((len >> 8) & 0xff),
+            (unsigned char)((len >> 16) & 0xff), (unsigned char)((len >> 24) & 0xff)
+        };
+        fwrite(prefix, 1, sizeof(prefix), stdout);
+        fwrite(rec->buf.data, 1, rec->buf.len, stdout);
+    } else {
+        fwrite(rec->buf.data, 1, rec->buf.len, stdout);
+        fputc('\n', stdout);
+    }
+    fflush(stdout);
+#ifndef _WIN32
+    pthread_mutex_unlock(&record_lock);
+#endif
     
-    FILE *smart_output = popen(cmd, "r");
-    if (smart_output) {
-        char line[256];
-        int found_info = 0;
-        while (fgets(line, sizeof(line), smart_output)) {
-            if (strstr(line, "SMART overall-health") || 
-                strstr(line, "SMART Health Status") ||
-                strstr(line, "PASSED") || 
-                strstr(line, "FAILED")) {
-                printf("%s", line);
-                found_info = 1;
-            }
+    free(rec->buf.data);
+    rec->buf.data = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Probe tracing (--trace FILE, Chrome trace / Perfetto JSON)
+// ---------------------------------------------------------------------------
+//
+// Every probe stage records a span (stage, device, thread, start, duration,
+// status) into a buffer owned by the calling thread, so recording never takes
+// a lock. The buffers are written out as one trace file when the program exits.
+
+struct trace_span {
+    const char *stage;                  // string literal naming the stage
+    char device[32];
+    double start;                       // seconds since trace_origin
+    double duration;
+    int status;                         // return value, errno or exit status of the stage
+};
+
+struct trace_buffer {
+    struct trace_span *spans;
+    int count;
+    int cap;
+    long tid;
+    int index;                          // order in which the threads recorded their first span
+    struct trace_buffer *next;
+};
+
+static int trace_enabled = 0;
+static char trace_path[512] = "";
+static double trace_origin = 0.0;
+static struct trace_buffer *trace_buffers = NULL;
+static int trace_buffer_count = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct trace_buffer *trace_thread_buffer = NULL;
+static __thread const char *trace_device = NULL;       // device the calling thread is probing
+
+static double trace_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Start of a span; with tracing off the whole cost is this branch
+static double trace_begin(void) {
+    return trace_enabled ? trace_clock() : 0.0;
+}
+
+static void trace_end(const char* stage, double start, int status) {
+    if (!trace_enabled) {
+        return;
+    }
+    double end = trace_clock();
+    struct trace_buffer *buffer = trace_thread_buffer;
+    if (!buffer) {
+        // First span of this thread: the buffer is linked in once and kept until exit
+        buffer = (struct trace_buffer*)calloc(1, sizeof(struct trace_buffer));
+        if (!buffer) {
+            return;
         }
-        pclose(smart_output);
-        
-        if (!found_info) {
-            printf("SMART information not available (smartctl not installed or device doesn't support SMART)\n");
+        buffer->tid = (long)syscall(SYS_gettid);
+        pthread_mutex_lock(&trace_lock);
+        buffer->index = trace_buffer_count++;
+        buffer->next = trace_buffers;
+        trace_buffers = buffer;
+        pthread_mutex_unlock(&trace_lock);
+        trace_thread_buffer = buffer;
+    }
+    if (buffer->count == buffer->cap) {
+        int cap = buffer->cap ? buffer->cap * 2 : 256;
+        struct trace_span *spans = (struct trace_span*)realloc(buffer->spans, cap * sizeof(struct trace_span));
+        if (!spans) {
+            return;
         }
-    } else {
-        printf("Cannot check SMART status (smartctl not available)\n");
+        buffer->spans = spans;
+        buffer->cap = cap;
     }
+    struct trace_span *span = &buffer->spans[buffer->count++];
+    span->stage = stage;
+    snprintf(span->device, sizeof(span->device), "%s", trace_device ? trace_device : "");
+    span->start = start - trace_origin;
+    span->duration = end - start;
+    span->status = status;
 }
 
-void analyze_usb_device_details(const char* device) {
-    printf("\n=== USB Device Analysis ===\n");
-    
-    // Get USB device information from sysfs
-    char usb_path[512];
-    char sysfs_path[512];
-    snprintf(sysfs_path, sizeof(sysfs_path), "/sys/block/%s", device);
-    
-    // Follow symlink to find USB device path
-    char link_target[512];
-    ssize_t len = readlink(sysfs_path, link_target, sizeof(link_target) - 1);
-    if (len == -1) {
-        printf("Unable to analyze USB device path\n");
-        return;
+// Exit code of a popen()/system() child, -1 when it did not exit normally
+static int trace_exit_status(int wait_status) {
+    return wait_status != -1 && WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : -1;
+}
+
+// Device of the calling thread's spans; returns the previous one for nesting
+static const char* trace_set_device(const char* device) {
+    const char *previous = trace_device;
+    trace_device = device;
+    return previous;
+}
+
+static void trace_write_event(FILE* fp, struct record* event, int* first) {
+    buffer_printf(&event->buf, "}");
+    if (event->buf.data) {
+        fprintf(fp, "%s%s", *first ? "" : ",\n", event->buf.data);
+        *first = 0;
     }
-    link_target[len] = '\0';
-    
-    // Extract USB device information
-    char *usb_pos = strstr(link_target, "usb");
-    if (!usb_pos) {
-        printf("Not a USB device\n");
+    free(event->buf.data);
+    event->buf.data = NULL;
+}
+
+// Registered with atexit() by --trace; worker threads have finished by then
+static void trace_write(void) {
+    FILE *fp = fopen(trace_path, "w");
+    if (!fp) {
+        fprintf(stderr, "Cannot write trace %s: %s\n", trace_path, strerror(errno));
         return;
     }
+    long pid = (long)getpid();
+    int first = 1;
+    struct record event;
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
     
-    // Try to find the USB device directory
-    char usb_device_path[512] = {0};
-    char *path_part = strtok(link_target, "/");
-    char temp_path[512] = "/sys/devices";
+    memset(&event, 0, sizeof(event));
+    buffer_printf(&event.buf, "{");
+    record_string(&event, "name", "process_name");
+    record_string(&event, "ph", "M");
+    record_int(&event, "pid", pid);
+    record_object_begin(&event, "args");
+    record_string(&event, "name", "secure-data-wiping");
+    record_object_end(&event);
+    trace_write_event(fp, &event, &first);
     
-    while (path_part != NULL) {
-        strcat(temp_path, "/");
-        strcat(temp_path, path_part);
+    pthread_mutex_lock(&trace_lock);
+    for (struct trace_buffer *buffer = trace_buffers; buffer; buffer = buffer->next) {
+        char thread_name[32];
+        if (buffer->tid == pid) {
+            snprintf(thread_name, sizeof(thread_name), "main");
+        } else {
+            snprintf(thread_name, sizeof(thread_name), "worker %d", buffer->index);
+        }
+        memset(&event, 0, sizeof(event));
+        buffer_printf(&event.buf, "{");
+        record_string(&event, "name", "thread_name");
+        record_string(&event, "ph", "M");
+        record_int(&event, "pid", pid);
+        record_int(&event, "tid", buffer->tid);
+        record_object_begin(&event, "args");
+        record_string(&event, "name", thread_name);
+        record_object_end(&event);
+        trace_write_event(fp, &event, &first);
         
-        // Check if this is a USB device directory (contains idVendor and idProduct)
-        char vendor_path[512];
-        snprintf(vendor_path, sizeof(vendor_path), "%s/idVendor", temp_path);
-        if (access(vendor_path, R_OK) == 0) {
-            strcpy(usb_device_path, temp_path);
-            break;
+        for (int i = 0; i < buffer->count; i++) {
+            const struct trace_span *span = &buffer->spans[i];
+            memset(&event, 0, sizeof(event));
+            buffer_printf(&event.buf, "{");
+            record_string(&event, "name", span->stage);
+            record_string(&event, "cat", "probe");
+            record_string(&event, "ph", "X");
+            record_key(&event, "ts");
+            buffer_printf(&event.buf, "%.3f", span->start * 1e6);
+            record_key(&event, "dur");
+            buffer_printf(&event.buf, "%.3f", span->duration * 1e6);
+            record_int(&event, "pid", pid);
+            record_int(&event, "tid", buffer->tid);
+            record_object_begin(&event, "args");
+            record_string(&event, "device", span->device);
+            record_int(&event, "status", span->status);
+            record_object_end(&event);
+            trace_write_event(fp, &event, &first);
         }
-        path_part = strtok(NULL, "/");
     }
-    
-    if (strlen(usb_device_path) == 0) {
-        printf("Unable to locate USB device information\n");
-        return;
+    pthread_mutex_unlock(&trace_lock);
+    fprintf(fp, "\n]}\n");
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Cannot write trace %s: %s\n", trace_path, strerror(errno));
+    }
+}
+
+// --trace FILE: start the clock and write the spans at exit
+static void trace_start(const char* path) {
+    snprintf(trace_path, sizeof(trace_path), "%s", path);
+    trace_origin = trace_clock();
+    if (!trace_enabled) {
+        trace_enabled = 1;
+        atexit(trace_write);
     }
+}
+
+// ---------------------------------------------------------------------------
+// ATA pass-through (SG_IO + ATA PASS-THROUGH(16))
+// ---------------------------------------------------------------------------
+
+#define ATA_PASSTHROUGH_16      0x85
+#define ATA_PROTOCOL_NON_DATA   3
+#define ATA_PROTOCOL_PIO_IN     4
+
+#define ATA_CMD_IDENTIFY            0xEC
+#define ATA_CMD_READ_NATIVE_MAX     0xF8
+#define ATA_CMD_READ_NATIVE_MAX_EXT 0x27
+#define ATA_CMD_DCO                 0xB1
+#define ATA_DCO_IDENTIFY            0xC2
+
+#define ATA_SECTOR_SIZE 512
+
+// Task file registers returned by the drive (ATA Status Return sense descriptor)
+struct ata_taskfile {
+    uint8_t error;
+    uint8_t status;
+    uint8_t device;
+    uint16_t count;
+    uint64_t lba;
+};
+
+// Decoded IDENTIFY DEVICE, READ NATIVE MAX and DCO IDENTIFY data of one drive
+struct ata_identify_info {
+    int valid;
+    char model[41];
+    char serial[21];
+    char firmware[9];
     
-    printf("USB Device Path: %s\n", usb_device_path);
+    int lba48;
+    unsigned long long user_max_sectors;    // words 60-61 / 100-103
     
-    // Read USB device details
-    char file_path[512];
-    FILE *fp;
-    char buffer[256];
+    int hpa_supported;                      // word 82 bit 10
+    int hpa_enabled;                        // word 85 bit 10
+    int native_max_valid;
+    unsigned long long native_max_sectors;  // READ NATIVE MAX ADDRESS (+1)
     
-    // Vendor ID
-    snprintf(file_path, sizeof(file_path), "%s/idVendor", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Vendor ID: %s\n", buffer);
-        }
-        fclose(fp);
-    }
+    int dco_supported;                      // word 83 bit 11
+    int dco_valid;
+    unsigned long long dco_real_max_sectors; // DCO words 3-6 (+1)
     
-    // Product ID
-    snprintf(file_path, sizeof(file_path), "%s/idProduct", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Product ID: %s\n", buffer);
-        }
-        fclose(fp);
-    }
+    int security_supported;                 // word 82 bit 1 / word 128 bit 0
+    int security_enabled;                   // word 128 bit 1
+    int security_locked;                    // word 128 bit 2
+    int security_frozen;                    // word 128 bit 3
+    int security_count_expired;             // word 128 bit 4
+    int enhanced_erase_supported;           // word 128 bit 5
+    int security_level_maximum;             // word 128 bit 8
+    int erase_time_minutes;                 // word 89
+    int enhanced_erase_time_minutes;        // word 90
     
-    // Manufacturer
-    snprintf(file_path, sizeof(file_path), "%s/manufacturer", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Manufacturer: %s\n", buffer);
-        }
-        fclose(fp);
-    }
+    int sanitize_supported;                 // word 59 bit 12
+    int crypto_scramble_supported;          // word 59 bit 13
+    int overwrite_supported;                // word 59 bit 14
+    int block_erase_supported;              // word 59 bit 15
+    int trim_supported;                     // word 169 bit 0
     
-    // Product name
-    snprintf(file_path, sizeof(file_path), "%s/product", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Product: %s\n", buffer);
-        }
-        fclose(fp);
+    uint16_t words[256];                    // raw IDENTIFY DEVICE data
+};
+
+// Issue one ATA command through SG_IO. data may be NULL for non-data commands.
+// When tf is given the drive's result registers are requested (CK_COND) and
+// decoded from the descriptor sense data.
+static int ata_pass_through(int fd, uint8_t command, uint16_t features, uint16_t count,
+                            uint64_t lba, uint8_t device, int extend,
+                            void* data, unsigned int data_len, struct ata_taskfile* tf) {
+    unsigned char cdb[16];
+    unsigned char sense[32];
+    sg_io_hdr_t io;
+    
+    memset(cdb, 0, sizeof(cdb));
+    memset(sense, 0, sizeof(sense));
+    memset(&io, 0, sizeof(io));
+    
+    int protocol = data ? ATA_PROTOCOL_PIO_IN : ATA_PROTOCOL_NON_DATA;
+    cdb[0] = ATA_PASSTHROUGH_16;
+    cdb[1] = (protocol << 1) | (extend ? 1 : 0);
+    if (data) {
+        // T_DIR=in, BYT_BLOK=blocks, T_LENGTH=sector count field
+        cdb[2] = 0x0e;
+    }
+    if (tf) {
+        cdb[2] |= 0x20; // CK_COND: always return the task file
     }
+    cdb[3] = (features >> 8) & 0xff;
+    cdb[4] = features & 0xff;
+    cdb[5] = (count >> 8) & 0xff;
+    cdb[6] = count & 0xff;
+    cdb[7] = (lba >> 24) & 0xff;
+    cdb[8] = lba & 0xff;
+    cdb[9] = (lba >> 32) & 0xff;
+    cdb[10] = (lba >> 8) & 0xff;
+    cdb[11] = (lba >> 40) & 0xff;
+    cdb[12] = (lba >> 16) & 0xff;
+    cdb[13] = device;
+    cdb[14] = command;
     
-    // Serial number
-    snprintf(file_path, sizeof(file_path), "%s/serial", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Serial Number: %s\n", buffer);
-        }
-        fclose(fp);
+    io.interface_id = 'S';
+    io.cmdp = cdb;
+    io.cmd_len = sizeof(cdb);
+    io.sbp = sense;
+    io.mx_sb_len = sizeof(sense);
+    io.dxfer_direction = data ? SG_DXFER_FROM_DEV : SG_DXFER_NONE;
+    io.dxferp = data;
+    io.dxfer_len = data ? data_len : 0;
+    io.timeout = 15000;
+    
+    if (ioctl(fd, SG_IO, &io) != 0) {
+        return -1;
     }
     
-    // USB version
-    snprintf(file_path, sizeof(file_path), "%s/version", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("USB Version: %s\n", buffer);
+    // Locate the ATA Status Return descriptor (code 0x09) in descriptor sense
+    const unsigned char *desc = NULL;
+    if (io.sb_len_wr >= 8 && (sense[0] & 0x7f) == 0x72) {
+        int add_len = sense[7];
+        for (int pos = 8; pos + 14 <= 8 + add_len && pos + 14 <= (int)sizeof(sense); pos += 2 + sense[pos + 1]) {
+            if (sense[pos] == 0x09) {
+                desc = &sense[pos];
+                break;
+            }
         }
-        fclose(fp);
     }
     
-    // Speed
-    snprintf(file_path, sizeof(file_path), "%s/speed", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Speed: %s Mbps\n", buffer);
+    if (desc) {
+        uint8_t status = desc[13];
+        if (tf) {
+            tf->error = desc[3];
+            tf->status = status;
+            tf->device = desc[12];
+            tf->count = (uint16_t)((desc[4] << 8) | desc[5]);
+            tf->lba = ((uint64_t)desc[10] << 40) | ((uint64_t)desc[8] << 32) |
+                      ((uint64_t)desc[6] << 24) | ((uint64_t)desc[11] << 16) |
+                      ((uint64_t)desc[9] << 8) | desc[7];
         }
-        fclose(fp);
+        // ERR or DF set: the drive rejected the command
+        return (status & 0x21) ? -1 : 0;
     }
     
-    // Device class
-    snprintf(file_path, sizeof(file_path), "%s/bDeviceClass", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            int device_class = strtol(buffer, NULL, 16);
-            printf("Device Class: 0x%02x ", device_class);
-            switch (device_class) {
-                case 0x00: printf("(Defined at Interface Level)\n"); break;
-                case 0x01: printf("(Audio)\n"); break;
-                case 0x02: printf("(Communications)\n"); break;
-                case 0x03: printf("(HID - Human Interface Device)\n"); break;
-                case 0x06: printf("(Still Image)\n"); break;
-                case 0x07: printf("(Printer)\n"); break;
-                case 0x08: printf("(Mass Storage)\n"); break;
-                case 0x09: printf("(Hub)\n"); break;
-                case 0x0A: printf("(CDC-Data)\n"); break;
-                case 0x0E: printf("(Video)\n"); break;
-                case 0xEF: printf("(Miscellaneous)\n"); break;
-                case 0xFF: printf("(Vendor Specific)\n"); break;
-                default: printf("(Unknown)\n"); break;
-            }
-        }
-        fclose(fp);
+    if (tf) {
+        // Result registers were requested but not returned
+        return -1;
     }
-    
-    // Check if it's likely a mobile phone
-    analyze_mobile_device_type(usb_device_path);
+    if (io.status != 0 || io.host_status != 0 || (io.driver_status & 0x0f) != 0) {
+        return -1;
+    }
+    return 0;
 }
 
-void analyze_mobile_device_type(const char* usb_device_path) {
-    printf("\n=== Mobile Device Detection ===\n");
-    
-    char file_path[512];
-    FILE *fp;
-    char buffer[256];
-    
-    // Read vendor and product IDs for mobile device detection
-    char vendor_id[16] = {0};
-    char product_id[16] = {0};
-    char manufacturer[256] = {0};
-    char product[256] = {0};
-    
-    snprintf(file_path, sizeof(file_path), "%s/idVendor", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(vendor_id, sizeof(vendor_id), fp)) {
-            vendor_id[strcspn(vendor_id, "\n")] = 0;
-        }
-        fclose(fp);
+// ATA strings are stored as big-endian byte pairs, padded with spaces
+static void ata_copy_string(char* out, const uint16_t* words, int word_count) {
+    int len = 0;
+    for (int i = 0; i < word_count; i++) {
+        out[len++] = (char)(words[i] >> 8);
+        out[len++] = (char)(words[i] & 0xff);
     }
-    
-    snprintf(file_path, sizeof(file_path), "%s/idProduct", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(product_id, sizeof(product_id), fp)) {
-            product_id[strcspn(product_id, "\n")] = 0;
-        }
-        fclose(fp);
+    out[len] = '\0';
+    while (len > 0 && (out[len - 1] == ' ' || out[len - 1] == '\0')) {
+        out[--len] = '\0';
     }
-    
-    snprintf(file_path, sizeof(file_path), "%s/manufacturer", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(manufacturer, sizeof(manufacturer), fp)) {
-            manufacturer[strcspn(manufacturer, "\n")] = 0;
-        }
-        fclose(fp);
+    int start = 0;
+    while (out[start] == ' ') {
+        start++;
     }
+    if (start > 0) {
+        memmove(out, out + start, len - start + 1);
+    }
+}
+
+// Fill the decoded fields of info from its raw IDENTIFY DEVICE words
+static void ata_decode_identify(struct ata_identify_info* info) {
+    const uint16_t *w = info->words;
     
-    snprintf(file_path, sizeof(file_path), "%s/product", usb_device_path);
-    fp = fopen(file_path, "r");
-    if (fp) {
-        if (fgets(product, sizeof(product), fp)) {
-            product[strcspn(product, "\n")] = 0;
-        }
-        fclose(fp);
+    ata_copy_string(info->serial, &w[10], 10);
+    ata_copy_string(info->firmware, &w[23], 4);
+    ata_copy_string(info->model, &w[27], 20);
+    
+    info->lba48 = (w[83] & 0xc000) == 0x4000 && (w[83] & 0x0400);
+    if (info->lba48) {
+        info->user_max_sectors = (unsigned long long)w[100] | ((unsigned long long)w[101] << 16) |
+                                 ((unsigned long long)w[102] << 32) | ((unsigned long long)w[103] << 48);
+    } else {
+        info->user_max_sectors = (unsigned long long)w[60] | ((unsigned long long)w[61] << 16);
     }
     
-    // Check for known mobile device vendors
-    int is_mobile = 0;
-    printf("Device Type Analysis:\n");
+    // Words 82/83/85 are only meaningful when they are neither 0x0000 nor 0xffff
+    int w82_valid = w[82] != 0 && w[82] != 0xffff;
+    int w83_valid = (w[83] & 0xc000) == 0x4000;
+    int w85_valid = w[85] != 0 && w[85] != 0xffff;
     
-    // Common mobile device vendor IDs
-    if (strcmp(vendor_id, "04e8") == 0) {
-        printf("  ✓ Samsung Mobile Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "05ac") == 0) {
-        printf("  ✓ Apple Device Detected (iPhone/iPad)\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "18d1") == 0) {
-        printf("  ✓ Google/Android Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "0bb4") == 0) {
-        printf("  ✓ HTC Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "22b8") == 0) {
-        printf("  ✓ Motorola Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "0fce") == 0) {
-        printf("  ✓ Sony Ericsson Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "19d2") == 0) {
-        printf("  ✓ ZTE Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "12d1") == 0) {
-        printf("  ✓ Huawei Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "2717") == 0) {
-        printf("  ✓ Xiaomi Device Detected\n");
-        is_mobile = 1;
-    } else if (strcmp(vendor_id, "2a70") == 0) {
-        printf("  ✓ OnePlus Device Detected\n");
-        is_mobile = 1;
+    info->hpa_supported = w82_valid && (w[82] & 0x0400);
+    info->hpa_enabled = info->hpa_supported && w85_valid && (w[85] & 0x0400);
+    info->dco_supported = w83_valid && (w[83] & 0x0800);
+    
+    info->security_supported = (w82_valid && (w[82] & 0x0002)) || (w[128] & 0x0001);
+    info->security_enabled = (w[128] & 0x0002) != 0;
+    info->security_locked = (w[128] & 0x0004) != 0;
+    info->security_frozen = (w[128] & 0x0008) != 0;
+    info->security_count_expired = (w[128] & 0x0010) != 0;
+    info->enhanced_erase_supported = (w[128] & 0x0020) != 0;
+    info->security_level_maximum = (w[128] & 0x0100) != 0;
+    info->erase_time_minutes = (w[89] & 0x8000) ? (w[89] & 0x7fff) * 2 : (w[89] & 0xff) * 2;
+    info->enhanced_erase_time_minutes = (w[90] & 0x8000) ? (w[90] & 0x7fff) * 2 : (w[90] & 0xff) * 2;
+    
+    info->sanitize_supported = (w[59] & 0x1000) != 0;
+    info->crypto_scramble_supported = info->sanitize_supported && (w[59] & 0x2000);
+    info->overwrite_supported = info->sanitize_supported && (w[59] & 0x4000);
+    info->block_erase_supported = info->sanitize_supported && (w[59] & 0x8000);
+    info->trim_supported = (w[169] & 0x0001) != 0;
+}
+
+// libata's HDIO_GET_IDENTITY has already turned the serial (words 10-19),
+// firmware (23-26) and model (27-46) into plain strings; put them back into
+// the byte pairs ata_copy_string expects
+static void ata_restore_string_words(uint16_t* words, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        const unsigned char *bytes = (const unsigned char*)&words[i];
+        words[i] = (uint16_t)((bytes[0] << 8) | bytes[1]);
+    }
+}
+
+// Read IDENTIFY DEVICE through SG_IO, falling back to the kernel's cached copy
+// (SG_IO refuses ATA pass-through without CAP_SYS_RAWIO)
+static int ata_identify_device(int fd, uint16_t* words) {
+    if (ata_pass_through(fd, ATA_CMD_IDENTIFY, 0, 1, 0, 0, 0, words, ATA_SECTOR_SIZE, NULL) == 0) {
+        return 0;
     }
     
-    // Check manufacturer and product strings for mobile indicators
-    if (!is_mobile) {
-        if (strstr(manufacturer, "Samsung") || strstr(manufacturer, "SAMSUNG") ||
-            strstr(product, "Galaxy") || strstr(product, "GALAXY")) {
-            printf("  ✓ Samsung Mobile Device (by name)\n");
-            is_mobile = 1;
-        } else if (strstr(manufacturer, "Apple") || strstr(product, "iPhone") || 
-                   strstr(product, "iPad") || strstr(product, "iPod")) {
-            printf("  ✓ Apple Mobile Device (by name)\n");
-            is_mobile = 1;
-        } else if (strstr(manufacturer, "Google") || strstr(product, "Android") ||
-                   strstr(product, "Pixel")) {
-            printf("  ✓ Android Device (by name)\n");
-            is_mobile = 1;
-        } else if (strstr(product, "Phone") || strstr(product, "PHONE") ||
-                   strstr(product, "Mobile") || strstr(product, "MOBILE")) {
-            printf("  ✓ Mobile Device (by description)\n");
-            is_mobile = 1;
-        }
+    struct hd_driveid drive_id;
+    if (ioctl(fd, HDIO_GET_IDENTITY, &drive_id) == 0) {
+        memcpy(words, &drive_id, ATA_SECTOR_SIZE);
+        ata_restore_string_words(words, 10, 10);
+        ata_restore_string_words(words, 23, 4);
+        ata_restore_string_words(words, 27, 20);
+        return 0;
     }
+    return -1;
+}
+
+// READ NATIVE MAX ADDRESS (EXT): number of sectors the drive really has
+static int ata_read_native_max(int fd, int lba48, unsigned long long* sectors) {
+    struct ata_taskfile tf;
+    memset(&tf, 0, sizeof(tf));
     
-    if (!is_mobile) {
-        printf("  - Not identified as a mobile device\n");
-        printf("  - May be a USB storage device, hub, or other peripheral\n");
-    } else {
-        printf("\n=== Mobile Device Features ===\n");
-        
-        // Check for MTP (Media Transfer Protocol)
-        char interface_path[512];
-        snprintf(interface_path, sizeof(interface_path), "%s/*/bInterfaceClass", usb_device_path);
-        
-        if (system("ls /sys/bus/usb/devices/*/bInterfaceClass 2>/dev/null | head -1") == 0) {
-            printf("Transfer Protocols:\n");
-            
-            // Check for common mobile protocols
-            FILE *mtp_check = popen("lsusb -v 2>/dev/null | grep -A5 -B5 'MTP\\|PTP\\|Android\\|iPhone'", "r");
-            if (mtp_check) {
-                char line[512];
-                int found_protocol = 0;
-                while (fgets(line, sizeof(line), mtp_check)) {
-                    if (strstr(line, "MTP") || strstr(line, "PTP") || 
-                        strstr(line, "Android") || strstr(line, "iPhone")) {
-                        printf("  %s", line);
-                        found_protocol = 1;
-                    }
-                }
-                pclose(mtp_check);
-                if (!found_protocol) {
-                    printf("  Standard USB protocols detected\n");
-                }
-            }
+    if (lba48) {
+        if (ata_pass_through(fd, ATA_CMD_READ_NATIVE_MAX_EXT, 0, 0, 0, 0x40, 1, NULL, 0, &tf) != 0) {
+            return -1;
         }
-        
-        // Check for ADB (Android Debug Bridge) if available
-        if (system("which adb > /dev/null 2>&1") == 0) {
-            printf("\nADB Device Check:\n");
-            FILE *adb_output = popen("adb devices 2>/dev/null", "r");
-            if (adb_output) {
-                char line[256];
-                int device_found = 0;
-                while (fgets(line, sizeof(line), adb_output)) {
-                    if (strstr(line, "device") && !strstr(line, "List of devices")) {
-                        printf("  ADB Device: %s", line);
-                        device_found = 1;
-                    }
-                }
-                pclose(adb_output);
-                if (!device_found) {
-                    printf("  No ADB devices detected (may need USB debugging enabled)\n");
-                }
-            }
-        } else {
-            printf("\nADB not available (install with: sudo pacman -S android-tools)\n");
+        *sectors = tf.lba + 1;
+    } else {
+        if (ata_pass_through(fd, ATA_CMD_READ_NATIVE_MAX, 0, 0, 0, 0x40, 0, NULL, 0, &tf) != 0) {
+            return -1;
         }
+        *sectors = ((tf.lba & 0xffffff) | ((unsigned long long)(tf.device & 0x0f) << 24)) + 1;
     }
+    return 0;
 }
 
-void list_all_usb_devices(void) {
-    printf("\n=== All Connected USB Devices ===\n");
+// DEVICE CONFIGURATION IDENTIFY: real maximum LBA before any DCO restriction
+static int ata_dco_identify(int fd, unsigned long long* sectors) {
+    uint16_t dco[256];
+    memset(dco, 0, sizeof(dco));
     
-    // Use lsusb if available for comprehensive USB device listing
-    if (system("which lsusb > /dev/null 2>&1") == 0) {
-        printf("USB Device Overview (via lsusb):\n");
-        FILE *lsusb_output = popen("lsusb", "r");
-        if (lsusb_output) {
-            char line[512];
-            while (fgets(line, sizeof(line), lsusb_output)) {
-                printf("  %s", line);
-            }
-            pclose(lsusb_output);
-        }
-        printf("\n");
+    if (ata_pass_through(fd, ATA_CMD_DCO, ATA_DCO_IDENTIFY, 0, 0, 0x40, 0, dco, sizeof(dco), NULL) != 0) {
+        return -1;
+    }
+    // Word 0 holds the DCO data structure revision (0x0001/0x0002)
+    if (dco[0] == 0 || dco[0] == 0xffff) {
+        return -1;
     }
+    *sectors = ((unsigned long long)dco[3] | ((unsigned long long)dco[4] << 16) |
+                ((unsigned long long)dco[5] << 32) | ((unsigned long long)dco[6] << 48)) + 1;
+    return 0;
+}
+
+// Collect IDENTIFY and native max data of an open ATA device. SET MAX
+// ADDRESS, a password change or a freeze at boot change both, so they are
+// read again on every probe.
+static int ata_probe_identify(int fd, struct ata_identify_info* info) {
+    memset(info, 0, sizeof(*info));
     
-    // Scan /sys/bus/usb/devices for detailed information
-    printf("Detailed USB Device Analysis:\n");
-    DIR *usb_dir = opendir("/sys/bus/usb/devices");
-    if (usb_dir) {
-        struct dirent *entry;
-        int usb_count = 0;
-        
-        while ((entry = readdir(usb_dir)) != NULL) {
-            // Skip . and .. and USB hubs (look for device entries like 1-1, 2-1.1, etc.)
-            if (entry->d_name[0] == '.' || !strchr(entry->d_name, '-')) {
-                continue;
-            }
+    if (ata_identify_device(fd, info->words) != 0) {
+        return -1;
+    }
+    ata_decode_identify(info);
+    info->valid = 1;
+    
+    if (info->hpa_supported &&
+        ata_read_native_max(fd, info->lba48, &info->native_max_sectors) == 0) {
+        info->native_max_valid = 1;
+    }
+    return 0;
+}
+
+// Collect IDENTIFY, native max and DCO data of an open ATA device
+static int ata_probe(int fd, struct ata_identify_info* info) {
+    if (ata_probe_identify(fd, info) != 0) {
+        return -1;
+    }
+    if (info->dco_supported &&
+        ata_dco_identify(fd, &info->dco_real_max_sectors) == 0) {
+        info->dco_valid = 1;
+    }
+    return 0;
+}
+
+// Print the ATA security state from IDENTIFY word 128 the way hdparm -I does
+static void report_ata_security_state(const struct ata_identify_info* info, const char* indent) {
+    report_printf("%s%s enabled\n", indent, info->security_enabled ? "   " : "not");
+    report_printf("%s%s locked\n", indent, info->security_locked ? "   " : "not");
+    report_printf("%s%s frozen\n", indent, info->security_frozen ? "   " : "not");
+    report_printf("%s%s expired: security count\n", indent, info->security_count_expired ? "   " : "not");
+    report_printf("%s%s supported: enhanced erase\n", indent, info->enhanced_erase_supported ? "   " : "not");
+    if (info->security_enabled) {
+        report_printf("%sSecurity level %s\n", indent, info->security_level_maximum ? "maximum" : "high");
+    }
+    if (info->erase_time_minutes) {
+        report_printf("%s%dmin for SECURITY ERASE UNIT", indent, info->erase_time_minutes);
+        if (info->enhanced_erase_time_minutes) {
+            report_printf(". %dmin for ENHANCED SECURITY ERASE UNIT", info->enhanced_erase_time_minutes);
+        }
+        report_printf("\n");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// NVMe admin pass-through (NVME_IOCTL_ADMIN_CMD)
+// ---------------------------------------------------------------------------
+
+#define NVME_ADMIN_GET_LOG_PAGE 0x02
+#define NVME_ADMIN_IDENTIFY     0x06
+
+#define NVME_CNS_NAMESPACE      0x00
+#define NVME_CNS_CONTROLLER     0x01
+#define NVME_CNS_ACTIVE_NS_LIST 0x02
+
+#define NVME_LOG_SMART_HEALTH   0x02
+#define NVME_LOG_FIRMWARE_SLOT  0x03
+
+#define NVME_IDENTIFY_SIZE 4096
+#define NVME_MAX_ACTIVE_NS 1024
+
+// Identify Controller fields used by the reports
+struct nvme_ctrl_info {
+    int valid;
+    uint16_t vendor_id;
+    char serial[21];
+    char model[41];
+    char firmware[9];
+    uint16_t oacs;            // optional admin command support
+    uint8_t frmw;             // firmware updates (slot count / slot 1 read-only)
+    uint8_t lpa;              // log page attributes
+    unsigned long long tnvmcap; // total NVM capacity in bytes (low 64 bits)
+    unsigned long long unvmcap; // unallocated NVM capacity in bytes (low 64 bits)
+    uint32_t sanicap;         // sanitize capabilities
+    uint32_t nn;              // number of namespaces
+    uint16_t oncs;            // optional NVM command support
+    uint8_t fna;              // format NVM attributes
+};
+
+struct nvme_lba_format {
+    uint16_t metadata_size;
+    uint8_t data_size_shift;  // LBA data size is 2^shift bytes
+    uint8_t relative_performance;
+};
+
+// Identify Namespace fields used by the reports
+struct nvme_ns_info {
+    int valid;
+    uint32_t nsid;
+    unsigned long long nsze;  // namespace size in logical blocks
+    unsigned long long ncap;  // namespace capacity in logical blocks
+    unsigned long long nuse;  // namespace utilization in logical blocks
+    uint8_t nlbaf;            // number of LBA formats (zero based)
+    uint8_t flbas;            // formatted LBA size
+    uint8_t dps;              // end-to-end data protection settings
+    struct nvme_lba_format lbaf[16];
+};
+
+// Firmware Slot Information log page
+struct nvme_fw_slot_log {
+    uint8_t active_slot;
+    uint8_t next_slot;
+    char revision[7][9];
+};
+
+static uint16_t get_le16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static unsigned long long get_le64(const unsigned char* p) {
+    return (unsigned long long)get_le32(p) | ((unsigned long long)get_le32(p + 4) << 32);
+}
+
+// Copy a space padded ASCII field and trim it
+static void nvme_copy_string(char* out, const unsigned char* field, int len) {
+    memcpy(out, field, len);
+    out[len] = '\0';
+    while (len > 0 && (out[len - 1] == ' ' || out[len - 1] == '\0')) {
+        out[--len] = '\0';
+    }
+}
+
+static int nvme_admin_command(int fd, uint8_t opcode, uint32_t nsid, uint32_t cdw10,
+                              uint32_t cdw11, void* data, uint32_t data_len) {
+    struct nvme_admin_cmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = opcode;
+    cmd.nsid = nsid;
+    cmd.addr = (uint64_t)(uintptr_t)data;
+    cmd.data_len = data_len;
+    cmd.cdw10 = cdw10;
+    cmd.cdw11 = cdw11;
+    cmd.timeout_ms = 5000;
+    
+    // A positive return value is an NVMe status code
+    return ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd) == 0 ? 0 : -1;
+}
+
+// Namespace ID of an NVMe namespace block device (0 for a controller node)
+static uint32_t nvme_namespace_id(int fd) {
+    int nsid = ioctl(fd, NVME_IOCTL_ID);
+    return nsid > 0 ? (uint32_t)nsid : 0;
+}
+
+static int nvme_identify_controller(int fd, struct nvme_ctrl_info* info) {
+    unsigned char *data = (unsigned char*)calloc(1, NVME_IDENTIFY_SIZE);
+    memset(info, 0, sizeof(*info));
+    if (!data) {
+        return -1;
+    }
+    if (nvme_admin_command(fd, NVME_ADMIN_IDENTIFY, 0, NVME_CNS_CONTROLLER, 0, data, NVME_IDENTIFY_SIZE) != 0) {
+        free(data);
+        return -1;
+    }
+    
+    info->vendor_id = get_le16(&data[0]);
+    nvme_copy_string(info->serial, &data[4], 20);
+    nvme_copy_string(info->model, &data[24], 40);
+    nvme_copy_string(info->firmware, &data[64], 8);
+    info->oacs = get_le16(&data[256]);
+    info->frmw = data[260];
+    info->lpa = data[261];
+    info->tnvmcap = get_le64(&data[280]);
+    info->unvmcap = get_le64(&data[296]);
+    info->sanicap = get_le32(&data[328]);
+    info->nn = get_le32(&data[516]);
+    info->oncs = get_le16(&data[520]);
+    info->fna = data[524];
+    info->valid = 1;
+    
+    free(data);
+    return 0;
+}
+
+static int nvme_identify_namespace(int fd, uint32_t nsid, struct nvme_ns_info* info) {
+    unsigned char *data = (unsigned char*)calloc(1, NVME_IDENTIFY_SIZE);
+    memset(info, 0, sizeof(*info));
+    if (!data) {
+        return -1;
+    }
+    if (nvme_admin_command(fd, NVME_ADMIN_IDENTIFY, nsid, NVME_CNS_NAMESPACE, 0, data, NVME_IDENTIFY_SIZE) != 0) {
+        free(data);
+        return -1;
+    }
+    
+    info->nsid = nsid;
+    info->nsze = get_le64(&data[0]);
+    info->ncap = get_le64(&data[8]);
+    info->nuse = get_le64(&data[16]);
+    info->nlbaf = data[25] & 0x0f;
+    info->flbas = data[26];
+    info->dps = data[29];
+    for (int i = 0; i <= info->nlbaf; i++) {
+        uint32_t lbaf = get_le32(&data[128 + 4 * i]);
+        info->lbaf[i].metadata_size = lbaf & 0xffff;
+        info->lbaf[i].data_size_shift = (lbaf >> 16) & 0xff;
+        info->lbaf[i].relative_performance = (lbaf >> 24) & 0x03;
+    }
+    info->valid = 1;
+    
+    free(data);
+    return 0;
+}
+
+// Fill list with the active namespace IDs, returns the count or -1
+static int nvme_active_namespaces(int fd, uint32_t* list, int max) {
+    unsigned char *data = (unsigned char*)calloc(1, NVME_IDENTIFY_SIZE);
+    if (!data) {
+        return -1;
+    }
+    if (nvme_admin_command(fd, NVME_ADMIN_IDENTIFY, 0, NVME_CNS_ACTIVE_NS_LIST, 0, data, NVME_IDENTIFY_SIZE) != 0) {
+        free(data);
+        return -1;
+    }
+    
+    int count = 0;
+    for (int i = 0; i < NVME_MAX_ACTIVE_NS && count < max; i++) {
+        uint32_t nsid = get_le32(&data[4 * i]);
+        if (nsid == 0) {
+            break;
+        }
+        list[count++] = nsid;
+    }
+    free(data);
+    return count;
+}
+
+// Get Log Page; len must be a multiple of 4
+static int nvme_get_log_page(int fd, uint8_t log_id, uint32_t nsid, void* data, uint32_t len) {
+    uint32_t numd = len / 4 - 1;
+    uint32_t cdw10 = log_id | ((numd & 0xffff) << 16);
+    uint32_t cdw11 = numd >> 16;
+    return nvme_admin_command(fd, NVME_ADMIN_GET_LOG_PAGE, nsid, cdw10, cdw11, data, len);
+}
+
+static int nvme_read_fw_slot_log(int fd, struct nvme_fw_slot_log* log) {
+    unsigned char data[512];
+    memset(log, 0, sizeof(*log));
+    memset(data, 0, sizeof(data));
+    if (nvme_get_log_page(fd, NVME_LOG_FIRMWARE_SLOT, 0xffffffff, data, sizeof(data)) != 0) {
+        return -1;
+    }
+    log->active_slot = data[0] & 0x07;
+    log->next_slot = (data[0] >> 4) & 0x07;
+    for (int i = 0; i < 7; i++) {
+        nvme_copy_string(log->revision[i], &data[8 + 8 * i], 8);
+    }
+    return 0;
+}
+
+// Print the security-relevant admin capabilities of a controller
+static void report_nvme_security_caps(const struct nvme_ctrl_info* ctrl, const char* indent) {
+    report_printf("%sSecurity Send/Receive: %s\n", indent, (ctrl->oacs & 0x0001) ? "✓ Supported" : "✗ Not Supported");
+    report_printf("%sFormat NVM: %s\n", indent, (ctrl->oacs & 0x0002) ? "✓ Supported" : "✗ Not Supported");
+    if (ctrl->oacs & 0x0002) {
+        report_printf("%s  Crypto Erase (Format SES=2): %s\n", indent, (ctrl->fna & 0x04) ? "✓ Supported" : "✗ Not Supported");
+        report_printf("%s  Format applies to: %s\n", indent, (ctrl->fna & 0x01) ? "all namespaces" : "single namespace");
+        report_printf("%s  Secure erase applies to: %s\n", indent, (ctrl->fna & 0x02) ? "all namespaces" : "single namespace");
+    }
+    report_printf("%sNamespace Management: %s\n", indent, (ctrl->oacs & 0x0008) ? "✓ Supported" : "✗ Not Supported");
+    if (ctrl->sanicap & 0x07) {
+        report_printf("%sSanitize: ✓ Supported (crypto erase: %s, block erase: %s, overwrite: %s)\n", indent,
+               (ctrl->sanicap & 0x01) ? "yes" : "no",
+               (ctrl->sanicap & 0x02) ? "yes" : "no",
+               (ctrl->sanicap & 0x04) ? "yes" : "no");
+    } else {
+        report_printf("%sSanitize: ✗ Not Supported\n", indent);
+    }
+    report_printf("%sDataset Management (Deallocate): %s\n", indent, (ctrl->oncs & 0x0004) ? "✓ Supported" : "✗ Not Supported");
+    report_printf("%sWrite Zeroes: %s\n", indent, (ctrl->oncs & 0x0008) ? "✓ Supported" : "✗ Not Supported");
+}
+
+// ---------------------------------------------------------------------------
+// SCSI block commands (SG_IO: INQUIRY VPD, READ CAPACITY(16), WRITE SAME, UNMAP)
+// ---------------------------------------------------------------------------
+
+#define SCSI_INQUIRY            0x12
+#define SCSI_UNMAP              0x42
+#define SCSI_WRITE_SAME_16      0x93
+#define SCSI_SERVICE_ACTION_IN  0x9e
+#define SCSI_READ_CAPACITY_16   0x10    // service action of SERVICE ACTION IN(16)
+
+#define SCSI_VPD_SUPPORTED      0x00
+#define SCSI_VPD_UNIT_SERIAL    0x80
+#define SCSI_VPD_BLOCK_LIMITS   0xb0
+#define SCSI_VPD_PROVISIONING   0xb2
+
+#define SCSI_SENSE_ILLEGAL_REQUEST  0x05
+#define SCSI_TIMEOUT                15000
+#define SCSI_WRITE_SAME_TIMEOUT     120000  // per command, large ranges take a while
+#define SCSI_DEFAULT_WRITE_SAME_BLOCKS 0xffff   // when Block Limits does not say
+#define SCSI_MAX_WRITE_SAME_BLOCKS  0x7fffff    // the kernel's SD_MAX_WS16_BLOCKS
+#define SCSI_MAX_UNMAP_DESCRIPTORS  64
+
+// READ CAPACITY(16) and the Block Limits / Logical Block Provisioning VPD pages
+struct scsi_block_limits {
+    int valid;                              // READ CAPACITY(16) answered
+    unsigned long long blocks;              // last LBA + 1
+    uint32_t block_size;
+    int lbpme;                              // logical block provisioning (thin) enabled
+    int lbprz;                              // unmapped blocks read back as zeroes
+    
+    int block_limits_valid;                 // VPD page 0xB0
+    uint32_t max_transfer_blocks;
+    uint32_t optimal_transfer_blocks;
+    uint32_t max_unmap_blocks;              // per UNMAP block descriptor
+    uint32_t max_unmap_descriptors;
+    uint32_t unmap_granularity;             // in blocks, 0 if not reported
+    unsigned long long max_write_same_blocks;
+    
+    int provisioning_valid;                 // VPD page 0xB2
+    int lbpu;                               // UNMAP supported
+    int lbpws;                              // WRITE SAME(16) with the UNMAP bit supported
+    int provisioning_type;                  // 0 full, 1 resource, 2 thin
+    
+    char unit_serial[64];                   // Unit Serial Number VPD page 0x80
+};
+
+static uint32_t get_be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static unsigned long long get_be64(const unsigned char* p) {
+    return ((unsigned long long)get_be32(p) << 32) | get_be32(p + 4);
+}
+
+static void put_be32(unsigned char* p, uint32_t value) {
+    p[0] = (value >> 24) & 0xff;
+    p[1] = (value >> 16) & 0xff;
+    p[2] = (value >> 8) & 0xff;
+    p[3] = value & 0xff;
+}
+
+static void put_be64(unsigned char* p, unsigned long long value) {
+    put_be32(p, (uint32_t)(value >> 32));
+    put_be32(p + 4, (uint32_t)value);
+}
+
+// Issue one SCSI command through SG_IO. Returns 0, EOPNOTSUPP when the device
+// rejects the command as an illegal request, or another errno on failure.
+static int scsi_command(int fd, unsigned char* cdb, int cdb_len, int direction,
+                        void* data, unsigned int data_len, unsigned int timeout) {
+    unsigned char sense[32];
+    sg_io_hdr_t io;
+    
+    memset(sense, 0, sizeof(sense));
+    memset(&io, 0, sizeof(io));
+    io.interface_id = 'S';
+    io.cmdp = cdb;
+    io.cmd_len = cdb_len;
+    io.sbp = sense;
+    io.mx_sb_len = sizeof(sense);
+    io.dxfer_direction = data ? direction : SG_DXFER_NONE;
+    io.dxferp = data;
+    io.dxfer_len = data ? data_len : 0;
+    io.timeout = timeout;
+    
+    if (ioctl(fd, SG_IO, &io) != 0) {
+        return errno;
+    }
+    if (io.status == 0 && io.host_status == 0 && (io.driver_status & 0x0f) == 0) {
+        return 0;
+    }
+    // Sense key from fixed (0x70/0x71) or descriptor (0x72/0x73) format sense data
+    int sense_key = -1;
+    if (io.sb_len_wr >= 3 && ((sense[0] & 0x7e) == 0x70)) {
+        sense_key = sense[2] & 0x0f;
+    } else if (io.sb_len_wr >= 2 && ((sense[0] & 0x7e) == 0x72)) {
+        sense_key = sense[1] & 0x0f;
+    }
+    return sense_key == SCSI_SENSE_ILLEGAL_REQUEST ? EOPNOTSUPP : EIO;
+}
+
+static int scsi_inquiry_vpd(int fd, uint8_t page, unsigned char* data, uint16_t len) {
+    unsigned char cdb[6] = { SCSI_INQUIRY, 0x01, page, (unsigned char)(len >> 8), (unsigned char)len, 0 };
+    memset(data, 0, len);
+    int ret = scsi_command(fd, cdb, sizeof(cdb), SG_DXFER_FROM_DEV, data, len, SCSI_TIMEOUT);
+    // The page code is echoed back, anything else is a confused bridge
+    return ret == 0 && data[1] == page ? 0 : -1;
+}
+
+static int scsi_read_capacity16(int fd, struct scsi_block_limits* info) {
+    unsigned char cdb[16];
+    unsigned char data[32];
+    memset(cdb, 0, sizeof(cdb));
+    memset(data, 0, sizeof(data));
+    cdb[0] = SCSI_SERVICE_ACTION_IN;
+    cdb[1] = SCSI_READ_CAPACITY_16;
+    put_be32(&cdb[10], sizeof(data));
+    if (scsi_command(fd, cdb, sizeof(cdb), SG_DXFER_FROM_DEV, data, sizeof(data), SCSI_TIMEOUT) != 0) {
+        return -1;
+    }
+    info->blocks = get_be64(&data[0]) + 1;
+    info->block_size = get_be32(&data[8]);
+    info->lbpme = (data[14] >> 7) & 0x1;
+    info->lbprz = (data[14] >> 6) & 0x1;
+    return info->block_size ? 0 : -1;
+}
+
+// Read the capacity and the thin provisioning limits the sanitize methods need
+static int scsi_probe(int fd, struct scsi_block_limits* info) {
+    memset(info, 0, sizeof(*info));
+    
+    // Only ask for pages the device lists, some USB bridges hang on the
+    // others; a device without the list is not sent READ CAPACITY(16) either
+    unsigned char pages[255];
+    if (scsi_inquiry_vpd(fd, SCSI_VPD_SUPPORTED, pages, sizeof(pages)) != 0) {
+        return -1;
+    }
+    if (scsi_read_capacity16(fd, info) != 0) {
+        return -1;
+    }
+    info->valid = 1;
+
+    int has_unit_serial = 0;
+    int has_block_limits = 0;
+    int has_provisioning = 0;
+    int count = pages[3];
+    for (int i = 0; i < count && 4 + i < (int)sizeof(pages); i++) {
+        has_unit_serial |= pages[4 + i] == SCSI_VPD_UNIT_SERIAL;
+        has_block_limits |= pages[4 + i] == SCSI_VPD_BLOCK_LIMITS;
+        has_provisioning |= pages[4 + i] == SCSI_VPD_PROVISIONING;
+    }
+    
+    unsigned char page[64];
+    if (has_unit_serial && scsi_inquiry_vpd(fd, SCSI_VPD_UNIT_SERIAL, page, sizeof(page)) == 0) {
+        int len = page[3] < (int)sizeof(info->unit_serial) - 1 ? page[3] : (int)sizeof(info->unit_serial) - 1;
+        if (len > (int)sizeof(page) - 4) {
+            len = (int)sizeof(page) - 4;
+        }
+        // The serial number is right aligned and padded with leading spaces
+        int start = 4;
+        while (len > 0 && page[start] == ' ') {
+            start++;
+            len--;
+        }
+        nvme_copy_string(info->unit_serial, &page[start], len);
+    }
+    if (has_block_limits && scsi_inquiry_vpd(fd, SCSI_VPD_BLOCK_LIMITS, page, sizeof(page)) == 0) {
+        int page_len = (page[2] << 8) | page[3];
+        info->block_limits_valid = 1;
+        info->max_transfer_blocks = get_be32(&page[8]);
+        info->optimal_transfer_blocks = get_be32(&page[12]);
+        // Fields past MAXIMUM PREFETCH LENGTH only exist in the 0x3c byte page
+        if (page_len >= 0x3c) {
+            info->max_unmap_blocks = get_be32(&page[20]);
+            info->max_unmap_descriptors = get_be32(&page[24]);
+            info->unmap_granularity = get_be32(&page[28]);
+            info->max_write_same_blocks = get_be64(&page[36]);
+        }
+    }
+    if (has_provisioning && scsi_inquiry_vpd(fd, SCSI_VPD_PROVISIONING, page, sizeof(page)) == 0) {
+        info->provisioning_valid = 1;
+        info->lbpu = (page[5] >> 7) & 0x1;
+        info->lbpws = (page[5] >> 6) & 0x1;
+        info->provisioning_type = page[6] & 0x7;
+        if ((page[5] >> 2) & 0x7) {
+            info->lbprz = 1;
+        }
+    }
+    return 0;
+}
+
+// Set by --sanitize write-same/unmap. Only then are USB bridges sent READ
+// CAPACITY(16) and VPD INQUIRYs: the kernel sends neither to usb-storage
+// devices because some bridges do not survive them.
+static int scsi_probe_usb = 0;
+
+// WRITE SAME(16) of one zeroed block over [lba, lba + blocks), optionally
+// asking the device to unmap the range instead of writing it
+static int scsi_write_same16(int fd, unsigned long long lba, uint32_t blocks,
+                             const unsigned char* zero_block, uint32_t block_size, int unmap) {
+    unsigned char cdb[16];
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = SCSI_WRITE_SAME_16;
+    cdb[1] = unmap ? 0x08 : 0x00;
+    put_be64(&cdb[2], lba);
+    put_be32(&cdb[10], blocks);
+    return scsi_command(fd, cdb, sizeof(cdb), SG_DXFER_TO_DEV, (void*)zero_block, block_size,
+                        SCSI_WRITE_SAME_TIMEOUT);
+}
+
+// UNMAP [lba, lba + blocks) with as many block descriptors as the device takes
+static int scsi_unmap(int fd, unsigned long long lba, unsigned long long blocks,
+                      const struct scsi_block_limits* info) {
+    unsigned char params[8 + 16 * SCSI_MAX_UNMAP_DESCRIPTORS];
+    int max_descriptors = SCSI_MAX_UNMAP_DESCRIPTORS;
+    if (info->max_unmap_descriptors && info->max_unmap_descriptors < (uint32_t)max_descriptors) {
+        max_descriptors = (int)info->max_unmap_descriptors;
+    }
+    memset(params, 0, sizeof(params));
+    int descriptors = 0;
+    while (blocks > 0 && descriptors < max_descriptors) {
+        uint32_t count = blocks < info->max_unmap_blocks ? (uint32_t)blocks : info->max_unmap_blocks;
+        unsigned char *desc = &params[8 + 16 * descriptors++];
+        put_be64(&desc[0], lba);
+        put_be32(&desc[8], count);
+        lba += count;
+        blocks -= count;
+    }
+    if (blocks > 0) {
+        return EINVAL;
+    }
+    unsigned int len = 8 + 16 * descriptors;
+    params[0] = ((len - 2) >> 8) & 0xff;
+    params[1] = (len - 2) & 0xff;
+    params[2] = ((16 * descriptors) >> 8) & 0xff;
+    params[3] = (16 * descriptors) & 0xff;
+    
+    unsigned char cdb[10];
+    memset(cdb, 0, sizeof(cdb));
+    cdb[0] = SCSI_UNMAP;
+    cdb[7] = (len >> 8) & 0xff;
+    cdb[8] = len & 0xff;
+    return scsi_command(fd, cdb, sizeof(cdb), SG_DXFER_TO_DEV, params, len, SCSI_WRITE_SAME_TIMEOUT);
+}
+
+static void report_scsi_block_limits(const struct scsi_block_limits* info, const char* indent) {
+    report_printf("%sCapacity: %llu blocks of %u bytes (READ CAPACITY(16))\n", indent, info->blocks, info->block_size);
+    report_printf("%sThin Provisioning: %s, unmapped blocks read back %s\n", indent,
+           info->lbpme ? "enabled" : "disabled", info->lbprz ? "as zeroes" : "unspecified");
+    if (!info->block_limits_valid) {
+        report_printf("%sBlock Limits VPD page: not available\n", indent);
+    } else {
+        if (info->max_transfer_blocks) {
+            report_printf("%sMaximum Transfer: %u blocks\n", indent, info->max_transfer_blocks);
+        }
+        if (info->max_write_same_blocks) {
+            report_printf("%sWRITE SAME(16): up to %llu blocks per command\n", indent, info->max_write_same_blocks);
+        } else {
+            report_printf("%sWRITE SAME(16): length limit not reported\n", indent);
+        }
+        if (info->max_unmap_blocks && info->max_unmap_descriptors) {
+            report_printf("%sUNMAP: up to %u blocks in %u descriptors, granularity %u blocks\n", indent,
+                   info->max_unmap_blocks, info->max_unmap_descriptors, info->unmap_granularity);
+        } else {
+            report_printf("%sUNMAP: not supported\n", indent);
+        }
+    }
+    if (info->provisioning_valid) {
+        report_printf("%sProvisioning: %s (UNMAP %s, WRITE SAME with unmap %s)\n", indent,
+               info->provisioning_type == 2 ? "thin" : info->provisioning_type == 1 ? "resource" : "full",
+               info->lbpu ? "yes" : "no", info->lbpws ? "yes" : "no");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SMART health (ATA SMART READ DATA / RETURN STATUS, NVMe log page 0x02)
+// ---------------------------------------------------------------------------
+
+#define ATA_CMD_SMART               0xB0
+#define ATA_SMART_READ_DATA         0xD0
+#define ATA_SMART_RETURN_STATUS     0xDA
+#define ATA_SMART_LBA_SIGNATURE     0xC24F00ULL  // LBA mid 0x4F, LBA high 0xC2
+
+#define SMART_ATTR_REALLOCATED      5
+#define SMART_ATTR_POWER_ON_HOURS   9
+#define SMART_ATTR_AIRFLOW_TEMP     190
+#define SMART_ATTR_TEMPERATURE      194
+#define SMART_ATTR_PENDING          197
+#define SMART_ATTR_UNCORRECTABLE    198
+
+// Health counters of one drive. Counters the drive does not report are -1.
+struct smart_health_info {
+    int valid;
+    int is_nvme;
+    int passed;                     // overall assessment: 1 passed, 0 failed, -1 unknown
+    int temperature_c;
+    long long power_on_hours;
+    
+    // ATA attributes
+    long long reallocated_sectors;
+    long long pending_sectors;
+    long long offline_uncorrectable;
+    
+    // NVMe SMART / Health Information log
+    int critical_warning;
+    int available_spare;
+    int percentage_used;
+    long long media_errors;
+    long long unsafe_shutdowns;
+};
+
+static void smart_health_init(struct smart_health_info* info) {
+    memset(info, 0, sizeof(*info));
+    info->passed = -1;
+    info->temperature_c = -1;
+    info->power_on_hours = -1;
+    info->reallocated_sectors = -1;
+    info->pending_sectors = -1;
+    info->offline_uncorrectable = -1;
+    info->critical_warning = -1;
+    info->available_spare = -1;
+    info->percentage_used = -1;
+    info->media_errors = -1;
+    info->unsafe_shutdowns = -1;
+}
+
+// SMART READ DATA + RETURN STATUS on an ATA drive
+static int ata_read_smart(int fd, struct smart_health_info* info) {
+    unsigned char data[ATA_SECTOR_SIZE];
+    struct ata_taskfile tf;
+    
+    smart_health_init(info);
+    memset(data, 0, sizeof(data));
+    memset(&tf, 0, sizeof(tf));
+    
+    if (ata_pass_through(fd, ATA_CMD_SMART, ATA_SMART_RETURN_STATUS, 0, ATA_SMART_LBA_SIGNATURE,
+                         0, 0, NULL, 0, &tf) == 0) {
+        unsigned int signature = (unsigned int)((tf.lba >> 8) & 0xffff);
+        if (signature == 0xc24f) {
+            info->passed = 1;
+        } else if (signature == 0x2cf4) {
+            info->passed = 0;
+        }
+        info->valid = 1;
+    }
+    
+    if (ata_pass_through(fd, ATA_CMD_SMART, ATA_SMART_READ_DATA, 1, ATA_SMART_LBA_SIGNATURE,
+                         0, 0, data, sizeof(data), NULL) == 0) {
+        // 30 attribute entries of 12 bytes: id, flags(2), value, worst, raw(6), reserved
+        for (int i = 0; i < 30; i++) {
+            const unsigned char *attr = &data[2 + i * 12];
+            if (attr[0] == 0) {
+                continue;
+            }
+            long long raw = (long long)get_le32(&attr[5]) | ((long long)get_le16(&attr[9]) << 32);
+            switch (attr[0]) {
+                case SMART_ATTR_REALLOCATED: info->reallocated_sectors = raw; break;
+                case SMART_ATTR_POWER_ON_HOURS: info->power_on_hours = raw & 0xffffffff; break;
+                case SMART_ATTR_PENDING: info->pending_sectors = raw; break;
+                case SMART_ATTR_UNCORRECTABLE: info->offline_uncorrectable = raw; break;
+                case SMART_ATTR_TEMPERATURE: info->temperature_c = (int)(raw & 0xff); break;
+                case SMART_ATTR_AIRFLOW_TEMP:
+                    if (info->temperature_c < 0) {
+                        info->temperature_c = (int)(raw & 0xff);
+                    }
+                    break;
+            }
+        }
+        info->valid = 1;
+    }
+    
+    return info->valid ? 0 : -1;
+}
+
+// SMART / Health Information log page of an NVMe controller
+static int nvme_read_smart(int fd, struct smart_health_info* info) {
+    unsigned char data[512];
+    
+    smart_health_init(info);
+    memset(data, 0, sizeof(data));
+    if (nvme_get_log_page(fd, NVME_LOG_SMART_HEALTH, 0xffffffff, data, sizeof(data)) != 0) {
+        return -1;
+    }
+    
+    info->valid = 1;
+    info->is_nvme = 1;
+    info->critical_warning = data[0];
+    info->passed = data[0] == 0;
+    int kelvin = get_le16(&data[1]);
+    if (kelvin > 0) {
+        info->temperature_c = kelvin - 273;
+    }
+    info->available_spare = data[3];
+    info->percentage_used = data[5];
+    // 128-bit counters, the low 64 bits are plenty
+    info->power_on_hours = (long long)get_le64(&data[128]);
+    info->unsafe_shutdowns = (long long)get_le64(&data[144]);
+    info->media_errors = (long long)get_le64(&data[160]);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// sysfs access
+// ---------------------------------------------------------------------------
+//
+// Each device directory is opened once; attributes are then read relative to
+// it with openat() and a single read() into the caller's buffer, and numbers
+// are parsed without stdio.
+
+// Root of the sysfs tree (--sysfs-root), so captured or synthetic trees can be scanned
+static char sysfs_root[512] = "/sys";
+// Directory of the device nodes opened by the probes (moved by --bench-scan)
+static char dev_root[192] = "/dev";
+
+// Open a directory below the sysfs root, e.g. "block/sda"
+static int sysfs_open_dir(const char* relative) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", sysfs_root, relative);
+    return open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+static int sysfs_open_subdir(int dir_fd, const char* relative) {
+    return openat(dir_fd, relative, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+// Read the first line of an attribute without its newline; returns its length or -1
+static int sysfs_read_attr(int dir_fd, const char* name, char* buffer, size_t size) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t len;
+    do {
+        len = read(fd, buffer, size - 1);
+    } while (len < 0 && errno == EINTR);
+    close(fd);
+    if (len < 0) {
+        return -1;
+    }
+    buffer[len] = '\0';
+    char *newline = (char*)memchr(buffer, '\n', len);
+    if (newline) {
+        *newline = '\0';
+        len = newline - buffer;
+    }
+    return (int)len;
+}
+
+// Parse a decimal or hexadecimal attribute value, -1 when it is not a number
+static long long sysfs_parse_number(const char* text, int base) {
+    long long value = 0;
+    int digits = 0;
+    int negative = 0;
+    
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    if (*text == '-') {
+        negative = 1;
+        text++;
+    }
+    for (;; text++, digits++) {
+        int digit;
+        if (*text >= '0' && *text <= '9') {
+            digit = *text - '0';
+        } else if (base == 16 && *text >= 'a' && *text <= 'f') {
+            digit = *text - 'a' + 10;
+        } else if (base == 16 && *text >= 'A' && *text <= 'F') {
+            digit = *text - 'A' + 10;
+        } else {
+            break;
+        }
+        value = value * base + digit;
+    }
+    if (digits == 0) {
+        return -1;
+    }
+    return negative ? -value : value;
+}
+
+static long long sysfs_read_number(int dir_fd, const char* name) {
+    char buffer[64];
+    if (sysfs_read_attr(dir_fd, name, buffer, sizeof(buffer)) < 0) {
+        return -1;
+    }
+    return sysfs_parse_number(buffer, 10);
+}
+
+static long long sysfs_read_hex(int dir_fd, const char* name) {
+    char buffer[64];
+    if (sysfs_read_attr(dir_fd, name, buffer, sizeof(buffer)) < 0) {
+        return -1;
+    }
+    return sysfs_parse_number(buffer, 16);
+}
+
+static int sysfs_attr_exists(int dir_fd, const char* name) {
+    return faccessat(dir_fd, name, R_OK, 0) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Device probe profile
+// ---------------------------------------------------------------------------
+
+// Bus the block device is attached through, taken from its /sys/block link
+enum device_interface {
+    IFACE_UNKNOWN,
+    IFACE_NVME,
+    IFACE_SATA,
+    IFACE_USB,
+    IFACE_MMC,
+    IFACE_VIRTIO
+};
+
+#define NVME_MAX_PROFILE_NS 32
+
+// Capacity of one active NVMe namespace
+struct nvme_ns_summary {
+    uint32_t nsid;
+    unsigned long long nsze;
+    unsigned long long block_size;
+};
+
+// Everything the report sections show about one block device. It is filled
+// by a single probe_device_profile() pass; the report functions only format it.
+// Numeric fields the device does not provide are -1, strings are left empty.
+struct device_profile {
+    char name[256];
+    char dev_path[256];
+    
+    // /sys/block/<name> attributes
+    int rotational;
+    char model[256];
+    char vendor[256];
+    char serial[64];                    // sysfs serial attribute or Unit Serial Number VPD page
+    char sysfs_firmware[64];
+    long long sectors;
+    int physical_block_size;
+    int logical_block_size;
+    int removable;
+    int read_only;
+    long long discard_max_bytes;        // 0 when the queue cannot discard
+    long long discard_granularity;
+    long long write_zeroes_max_bytes;   // 0 when BLKZEROOUT falls back to writing zeroes
+    int scsi_type;
+    struct scsi_block_limits scsi;      // READ CAPACITY(16) and VPD pages of non-ATA disks
+    int link_valid;
+    char sysfs_link[512];
+    enum device_interface interface;
+    char usb_device_path[512];
+    char usb_bus_id[32];                // the USB device in the topology snapshot, e.g. "1-1.2"
+    
+    // Data read through the device node
+    int open_failed;
+    int kernel_size_valid;
+    unsigned long long kernel_size;
+    int is_nvme;
+    struct ata_identify_info ata;
+    struct nvme_ctrl_info nvme_ctrl;
+    uint32_t nvme_nsid;
+    struct nvme_ns_info nvme_ns;
+    int nvme_ns_count;                  // active namespaces, -1 if the list is unavailable
+    struct nvme_ns_summary nvme_namespaces[NVME_MAX_PROFILE_NS];
+    unsigned long long nvme_allocated_bytes;
+    int nvme_fw_log_valid;
+    struct nvme_fw_slot_log nvme_fw_log;
+    struct smart_health_info smart;
+    int smartctl_available;             // smartctl fallback ran (native SMART failed)
+    char smartctl_status[512];          // matching lines of smartctl -H
+    int from_cache;                     // identify data came from the inventory cache
+};
+
+// ---------------------------------------------------------------------------
+// USB topology snapshot
+// ---------------------------------------------------------------------------
+//
+// One walk of /sys/bus/usb/devices reads every attribute the USB reports use,
+// once per run. Devices sit in a flat array sorted by bus ID ("1-1.2") with
+// the index of the hub they hang off. Interfaces and the block devices below a
+// device are kept in their own arrays, grouped per device. The snapshot is
+// built on first use and then shared read-only by the scan workers. The
+// monitor drops it when a uevent arrives, while no worker is running.
+
+#define USB_ATTR_PRODUCT_ID     0x01
+#define USB_ATTR_MANUFACTURER   0x02
+#define USB_ATTR_PRODUCT        0x04
+#define USB_ATTR_SERIAL         0x08
+#define USB_ATTR_VERSION        0x10
+#define USB_ATTR_SPEED          0x20
+
+struct usb_interface_record {
+    char name[32];                      // "1-1:1.0"
+    int device;                         // index of the device it belongs to
+    long long number;                   // bInterfaceNumber, -1 if unknown
+    long long interface_class;          // bInterfaceClass/SubClass/Protocol, -1 if unknown
+    long long subclass;
+    long long protocol;
+    char label[128];                    // interface string descriptor, e.g. "MTP"
+};
+
+struct usb_block_record {
+    char name[32];                      // "sdb"
+    int device;
+};
+
+struct usb_device_record {
+    char name[32];                      // bus ID, "usbN" for root hubs
+    char path[512];                     // relative to the sysfs root, "devices/pci.../usb1/1-1"
+    int parent;                         // hub it is plugged into, -1 for root hubs
+    unsigned present;                   // USB_ATTR_* read successfully
+    char vendor_id[16];
+    char product_id[16];
+    char manufacturer[256];
+    char product[256];
+    char serial[256];
+    char version[16];
+    char speed[32];                     // Mbit/s
+    long long device_class;             // bDeviceClass, -1 if unknown
+    long long busnum;
+    long long devnum;
+    int first_interface;
+    int interface_count;
+    int first_block;
+    int block_count;
+};
+
+struct usb_topology {
+    int valid;                          // /sys/bus/usb/devices could be read
+    struct usb_device_record *devices;
+    int count;
+    struct usb_interface_record *interfaces;
+    int interface_count;
+    struct usb_block_record *blocks;
+    int block_count;
+};
+
+static struct usb_topology *usb_topology_current = NULL;
+static pthread_mutex_t usb_topology_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int usb_device_compare(const void* a, const void* b) {
+    return strcmp(((const struct usb_device_record*)a)->name, ((const struct usb_device_record*)b)->name);
+}
+
+// Index of the device with bus ID name, -1 if there is none
+static int usb_topology_find(const struct usb_topology* topology, const char* name) {
+    int lo = 0, hi = topology->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(topology->devices[mid].name, name);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+// The USB device nearest the end of a sysfs path, e.g. the disk's own device
+// and not the hubs above it; -1 if the path does not go through one
+static int usb_topology_device_for_path(const struct usb_topology* topology, const char* path) {
+    int found = -1;
+    const char *part = path;
+    while (*part) {
+        const char *slash = strchr(part, '/');
+        size_t len = slash ? (size_t)(slash - part) : strlen(part);
+        char name[32];
+        if (len > 0 && len < sizeof(name) && !memchr(part, ':', len)) {
+            memcpy(name, part, len);
+            name[len] = '\0';
+            int index = usb_topology_find(topology, name);
+            if (index >= 0) {
+                found = index;
+            }
+        }
+        if (!slash) {
+            break;
+        }
+        part = slash + 1;
+    }
+    return found;
+}
+
+// "1-1.2" hangs off "1-1", "1-1" off the root hub "usb1"
+static void usb_parent_name(const char* name, char* parent, size_t size) {
+    parent[0] = '\0';
+    const char *dash = strchr(name, '-');
+    if (!dash) {
+        return;
+    }
+    const char *dot = strrchr(name, '.');
+    if (dot && dot > dash) {
+        snprintf(parent, size, "%.*s", (int)(dot - name), name);
+    } else {
+        snprintf(parent, size, "usb%.*s", (int)(dash - name), name);
+    }
+}
+
+static void usb_read_device(int usb_dir_fd, const char* name, struct usb_device_record* device) {
+    memset(device, 0, sizeof(*device));
+    snprintf(device->name, sizeof(device->name), "%.31s", name);
+    device->parent = -1;
+    device->device_class = device->busnum = device->devnum = -1;
+    
+    int usb_fd = sysfs_open_subdir(usb_dir_fd, name);
+    if (usb_fd < 0) {
+        return;
+    }
+    static const struct {
+        const char *attr;
+        size_t offset;
+        size_t size;
+        unsigned flag;
+    } attrs[] = {
+        { "idVendor", offsetof(struct usb_device_record, vendor_id), sizeof(device->vendor_id), 0 },
+        { "idProduct", offsetof(struct usb_device_record, product_id), sizeof(device->product_id), USB_ATTR_PRODUCT_ID },
+        { "manufacturer", offsetof(struct usb_device_record, manufacturer), sizeof(device->manufacturer), USB_ATTR_MANUFACTURER },
+        { "product", offsetof(struct usb_device_record, product), sizeof(device->product), USB_ATTR_PRODUCT },
+        { "serial", offsetof(struct usb_device_record, serial), sizeof(device->serial), USB_ATTR_SERIAL },
+        { "version", offsetof(struct usb_device_record, version), sizeof(device->version), USB_ATTR_VERSION },
+        { "speed", offsetof(struct usb_device_record, speed), sizeof(device->speed), USB_ATTR_SPEED },
+    };
+    for (size_t i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++) {
+        if (sysfs_read_attr(usb_fd, attrs[i].attr, (char*)device + attrs[i].offset, attrs[i].size) >= 0) {
+            device->present |= attrs[i].flag;
+        }
+    }
+    // Without idVendor the remaining reads are skipped, the entry is dropped
+    if (device->vendor_id[0]) {
+        device->device_class = sysfs_read_hex(usb_fd, "bDeviceClass");
+        device->busnum = sysfs_read_number(usb_fd, "busnum");
+        device->devnum = sysfs_read_number(usb_fd, "devnum");
+    }
+    close(usb_fd);
+    
+    char link[512];
+    ssize_t len = readlinkat(usb_dir_fd, name, link, sizeof(link) - 1);
+    if (len > 0) {
+        link[len] = '\0';
+        const char *rel = link;
+        while (strncmp(rel, "../", 3) == 0) {
+            rel += 3;
+        }
+        snprintf(device->path, sizeof(device->path), "%s", rel);
+    }
+}
+
+static void usb_read_interface(int usb_dir_fd, const char* name, struct usb_interface_record* interface) {
+    memset(interface, 0, sizeof(*interface));
+    snprintf(interface->name, sizeof(interface->name), "%.31s", name);
+    interface->device = -1;
+    interface->number = interface->interface_class = interface->subclass = interface->protocol = -1;
+    int fd = sysfs_open_subdir(usb_dir_fd, name);
+    if (fd < 0) {
+        return;
+    }
+    interface->number = sysfs_read_hex(fd, "bInterfaceNumber");
+    interface->interface_class = sysfs_read_hex(fd, "bInterfaceClass");
+    interface->subclass = sysfs_read_hex(fd, "bInterfaceSubClass");
+    interface->protocol = sysfs_read_hex(fd, "bInterfaceProtocol");
+    sysfs_read_attr(fd, "interface", interface->label, sizeof(interface->label));
+    close(fd);
+}
+
+static void usb_topology_free(struct usb_topology* topology) {
+    if (topology) {
+        free(topology->devices);
+        free(topology->interfaces);
+        free(topology->blocks);
+        free(topology);
+    }
+}
+
+static int usb_interface_compare(const void* a, const void* b) {
+    const struct usb_interface_record *x = (const struct usb_interface_record*)a;
+    const struct usb_interface_record *y = (const struct usb_interface_record*)b;
+    if (x->device != y->device) {
+        return x->device < y->device ? -1 : 1;
+    }
+    return x->number < y->number ? -1 : x->number > y->number;
+}
+
+static int usb_block_compare(const void* a, const void* b) {
+    const struct usb_block_record *x = (const struct usb_block_record*)a;
+    const struct usb_block_record *y = (const struct usb_block_record*)b;
+    if (x->device != y->device) {
+        return x->device < y->device ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+// Grow a flat array by one element; NULL when out of memory
+static void* usb_array_push(void** items, int* count, int* capacity, size_t item_size) {
+    if (*count == *capacity) {
+        int new_cap = *capacity ? *capacity * 2 : 16;
+        void *grown = realloc(*items, (size_t)new_cap * item_size);
+        if (!grown) {
+            return NULL;
+        }
+        *items = grown;
+        *capacity = new_cap;
+    }
+    return (char*)*items + (size_t)(*count)++ * item_size;
+}
+
+static struct usb_topology* usb_topology_build(void) {
+    struct usb_topology *topology = (struct usb_topology*)calloc(1, sizeof(struct usb_topology));
+    if (!topology) {
+        return NULL;
+    }
+    int usb_dir_fd = sysfs_open_dir("bus/usb/devices");
+    DIR *usb_dir = usb_dir_fd >= 0 ? fdopendir(usb_dir_fd) : NULL;
+    if (!usb_dir) {
+        if (usb_dir_fd >= 0) {
+            close(usb_dir_fd);
+        }
+        return topology;
+    }
+    topology->valid = 1;
+    
+    int device_cap = 0, interface_cap = 0, block_cap = 0;
+    struct dirent *entry;
+    while ((entry = readdir(usb_dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        if (strchr(entry->d_name, ':')) {
+            struct usb_interface_record *interface = (struct usb_interface_record*)usb_array_push(
+                (void**)&topology->interfaces, &topology->interface_count, &interface_cap, sizeof(*interface));
+            if (interface) {
+                usb_read_interface(usb_dir_fd, entry->d_name, interface);
+            }
+            continue;
+        }
+        struct usb_device_record *device = (struct usb_device_record*)usb_array_push(
+            (void**)&topology->devices, &topology->count, &device_cap, sizeof(*device));
+        if (!device) {
+            continue;
+        }
+        usb_read_device(usb_dir_fd, entry->d_name, device);
+        if (!device->vendor_id[0]) {
+            topology->count--;
+        }
+    }
+    closedir(usb_dir);
+    
+    qsort(topology->devices, topology->count, sizeof(struct usb_device_record), usb_device_compare);
+    for (int i = 0; i < topology->count; i++) {
+        char parent[32];
+        usb_parent_name(topology->devices[i].name, parent, sizeof(parent));
+        topology->devices[i].parent = parent[0] ? usb_topology_find(topology, parent) : -1;
+    }
+    
+    // "1-1:1.0" belongs to "1-1"
+    for (int i = 0; i < topology->interface_count; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s", topology->interfaces[i].name);
+        *strchr(name, ':') = '\0';
+        topology->interfaces[i].device = usb_topology_find(topology, name);
+    }
+    
+    // Block devices whose /sys/block link passes through a USB device
+    int blocks_fd = sysfs_open_dir("block");
+    DIR *blocks_dir = blocks_fd >= 0 ? fdopendir(blocks_fd) : NULL;
+    if (blocks_dir) {
+        while ((entry = readdir(blocks_dir)) != NULL) {
+            char link[512];
+            ssize_t len = entry->d_name[0] == '.' ? -1 : readlinkat(blocks_fd, entry->d_name, link, sizeof(link) - 1);
+            if (len <= 0) {
+                continue;
+            }
+            link[len] = '\0';
+            int device = strstr(link, "/usb") ? usb_topology_device_for_path(topology, link) : -1;
+            if (device < 0) {
+                continue;
+            }
+            struct usb_block_record *block = (struct usb_block_record*)usb_array_push(
+                (void**)&topology->blocks, &topology->block_count, &block_cap, sizeof(*block));
+            if (block) {
+                snprintf(block->name, sizeof(block->name), "%.31s", entry->d_name);
+                block->device = device;
+            }
+        }
+        closedir(blocks_dir);
+    } else if (blocks_fd >= 0) {
+        close(blocks_fd);
+    }
+    
+    // Group interfaces and block devices per device
+    qsort(topology->interfaces, topology->interface_count, sizeof(struct usb_interface_record), usb_interface_compare);
+    qsort(topology->blocks, topology->block_count, sizeof(struct usb_block_record), usb_block_compare);
+    for (int i = topology->interface_count - 1; i >= 0; i--) {
+        int device = topology->interfaces[i].device;
+        if (device >= 0) {
+            topology->devices[device].first_interface = i;
+            topology->devices[device].interface_count++;
+        }
+    }
+    for (int i = topology->block_count - 1; i >= 0; i--) {
+        topology->devices[topology->blocks[i].device].first_block = i;
+        topology->devices[topology->blocks[i].device].block_count++;
+    }
+    return topology;
+}
+
+// The current snapshot, built on first use; NULL only when out of memory
+static const struct usb_topology* usb_topology_get(void) {
+    pthread_mutex_lock(&usb_topology_lock);
+    if (!usb_topology_current) {
+        double span = trace_begin();
+        usb_topology_current = usb_topology_build();
+        trace_end("usb_topology", span, usb_topology_current ? usb_topology_current->count : -1);
+    }
+    pthread_mutex_unlock(&usb_topology_lock);
+    return usb_topology_current;
+}
+
+// Forget the snapshot so the next user sees the bus as it is now. Only
+// called while nothing holds the old one (between monitor events and
+// benchmark runs).
+static void usb_topology_invalidate(void) {
+    pthread_mutex_lock(&usb_topology_lock);
+    usb_topology_free(usb_topology_current);
+    usb_topology_current = NULL;
+    pthread_mutex_unlock(&usb_topology_lock);
+}
+
+// ---------------------------------------------------------------------------
+// Persistent inventory cache
+// ---------------------------------------------------------------------------
+//
+// Identify data that only changes with a firmware update (the ATA DCO real
+// maximum, the NVMe firmware slot log) is kept in
+// <state dir>/inventory.cache keyed by serial number, firmware revision and
+// namespace. The file is a header followed by fixed-size entries and is read
+// through mmap. Volatile data is always probed again: SMART counters,
+// removable/ro flags, capacity, ATA IDENTIFY and native max (HPA and security
+// state), NVMe Identify Controller (unallocated capacity changes with the
+// namespaces) and the NVMe namespaces with their usage.
+
+#define INVENTORY_CACHE_MAGIC   "SDWINV\r\n"
+#define INVENTORY_CACHE_VERSION 4
+#define INVENTORY_CACHE_FILE    "inventory.cache"
+
+struct inventory_key {
+    char serial[64];
+    char firmware[16];
+    uint32_t nsid;
+};
+
+struct inventory_cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;    // sizeof(struct inventory_entry) of the writer
+    uint32_t entry_count;
+    uint32_t reserved;
+};
+
+struct inventory_entry {
+    struct inventory_key key;
+    int64_t probed_at;
+    char ata_firmware[9];               // full IDENTIFY firmware; sysfs rev keeps only 4 characters
+    int32_t ata_dco_valid;
+    unsigned long long ata_dco_real_max_sectors;
+    int32_t nvme_fw_log_valid;
+    struct nvme_fw_slot_log nvme_fw_log;
+};
+
+struct inventory_cache {
+    int enabled;
+    int refresh;                        // --refresh: ignore cached entries, re-probe and rewrite
+    char path[1024];
+    void *map;
+    size_t map_size;
+    const struct inventory_entry *entries;
+    uint32_t count;
+    struct inventory_entry *updates;    // entries probed during this run
+    int update_count;
+    int update_cap;
+    int dirty;
+    pthread_mutex_t lock;
+};
+
+// State directory for the cache (--state-dir), empty selects the default
+static char state_dir[512] = "";
+static struct inventory_cache inventory = { 0, 0, "", NULL, 0, NULL, 0, NULL, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+// mkdir -p
+static int make_directories(const char* path) {
+    char partial[512];
+    snprintf(partial, sizeof(partial), "%s", path);
+    for (char *p = partial + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(partial, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(partial, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+static void default_state_dir(char* out, size_t size) {
+    const char *xdg = getenv("XDG_STATE_HOME");
+    const char *home = getenv("HOME");
+    if (geteuid() == 0) {
+        snprintf(out, size, "/var/lib/secure-data-wiping");
+    } else if (xdg && xdg[0]) {
+        snprintf(out, size, "%s/secure-data-wiping", xdg);
+    } else if (home && home[0]) {
+        snprintf(out, size, "%s/.local/state/secure-data-wiping", home);
+    } else {
+        out[0] = '\0';
+    }
+}
+
+// --state-dir or the default, created if missing; fails when there is none
+static int state_dir_path(char* dir, size_t size) {
+    if (state_dir[0]) {
+        snprintf(dir, size, "%s", state_dir);
+    } else {
+        default_state_dir(dir, size);
+    }
+    if (!dir[0] || make_directories(dir) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Map the cache file of the state directory; a missing or stale file just
+// leaves the cache empty
+static void inventory_cache_open(int refresh) {
+    char dir[512];
+    if (state_dir_path(dir, sizeof(dir)) != 0) {
+        return;
+    }
+    
+    snprintf(inventory.path, sizeof(inventory.path), "%s/%s", dir, INVENTORY_CACHE_FILE);
+    inventory.enabled = 1;
+    inventory.refresh = refresh;
+    
+    int fd = open(inventory.path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(struct inventory_cache_header)) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            const struct inventory_cache_header *header = (const struct inventory_cache_header*)map;
+            size_t needed = sizeof(*header) + (size_t)header->entry_count * sizeof(struct inventory_entry);
+            if (memcmp(header->magic, INVENTORY_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+                header->version == INVENTORY_CACHE_VERSION &&
+                header->entry_size == sizeof(struct inventory_entry) &&
+                needed <= (size_t)st.st_size) {
+                inventory.map = map;
+                inventory.map_size = st.st_size;
+                inventory.entries = (const struct inventory_entry*)((const char*)map + sizeof(*header));
+                inventory.count = header->entry_count;
+            } else {
+                munmap(map, st.st_size);
+            }
+        }
+    }
+    close(fd);
+}
+
+static int inventory_key_equal(const struct inventory_key* a, const struct inventory_key* b) {
+    return a->nsid == b->nsid && strcmp(a->serial, b->serial) == 0 && strcmp(a->firmware, b->firmware) == 0;
+}
+
+// Copy the cached entry for key into out; fails when absent or on --refresh
+static int inventory_lookup(const struct inventory_key* key, struct inventory_entry* out) {
+    int found = 0;
+    if (!inventory.enabled || inventory.refresh) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&inventory.lock);
+    for (int i = 0; i < inventory.update_count && !found; i++) {
+        if (inventory_key_equal(&inventory.updates[i].key, key)) {
+            *out = inventory.updates[i];
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&inventory.lock);
+    
+    for (uint32_t i = 0; i < inventory.count && !found; i++) {
+        if (inventory_key_equal(&inventory.entries[i].key, key)) {
+            *out = inventory.entries[i];
+            found = 1;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+static void inventory_store(const struct inventory_key* key, const struct device_profile* profile) {
+    if (!inventory.enabled) {
+        return;
+    }
+    
+    struct inventory_entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.key = *key;
+    entry.probed_at = (int64_t)time(NULL);
+    memcpy(entry.ata_firmware, profile->ata.firmware, sizeof(entry.ata_firmware));
+    entry.ata_dco_valid = profile->ata.dco_valid;
+    entry.ata_dco_real_max_sectors = profile->ata.dco_real_max_sectors;
+    entry.nvme_fw_log_valid = profile->nvme_fw_log_valid;
+    entry.nvme_fw_log = profile->nvme_fw_log;
+    
+    pthread_mutex_lock(&inventory.lock);
+    int slot = -1;
+    for (int i = 0; i < inventory.update_count; i++) {
+        if (inventory_key_equal(&inventory.updates[i].key, key)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0 && inventory.update_count == inventory.update_cap) {
+        int new_cap = inventory.update_cap ? inventory.update_cap * 2 : 16;
+        struct inventory_entry *grown = (struct inventory_entry*)realloc(inventory.updates, new_cap * sizeof(*grown));
+        if (grown) {
+            inventory.updates = grown;
+            inventory.update_cap = new_cap;
+        }
+    }
+    if (slot < 0 && inventory.update_count < inventory.update_cap) {
+        slot = inventory.update_count++;
+    }
+    if (slot >= 0) {
+        inventory.updates[slot] = entry;
+        inventory.dirty = 1;
+    }
+    pthread_mutex_unlock(&inventory.lock);
+}
+
+// The key only holds the 4 character INQUIRY revision of a SATA disk; the
+// live IDENTIFY must also report the 8 character firmware the entry was made with
+static int inventory_entry_current(const struct inventory_entry* entry, const struct device_profile* profile) {
+    return profile->is_nvme || strncmp(entry->ata_firmware, profile->ata.firmware, sizeof(entry->ata_firmware)) == 0;
+}
+
+// Copy the cached stable identify data into a profile whose volatile identify
+// data (probe_live_identify) has already been read
+static void inventory_apply(const struct inventory_entry* entry, struct device_profile* profile) {
+    if (profile->ata.valid && profile->ata.dco_supported) {
+        profile->ata.dco_valid = entry->ata_dco_valid;
+        profile->ata.dco_real_max_sectors = entry->ata_dco_real_max_sectors;
+    }
+    profile->nvme_fw_log_valid = entry->nvme_fw_log_valid;
+    profile->nvme_fw_log = entry->nvme_fw_log;
+    profile->from_cache = 1;
+}
+
+// Write the entries probed in this run plus the untouched old ones to a
+// temporary file and rename it over the cache
+static void inventory_cache_save(void) {
+    pthread_mutex_lock(&inventory.lock);
+    if (!inventory.enabled || !inventory.dirty) {
+        pthread_mutex_unlock(&inventory.lock);
+        return;
+    }
+    
+    char tmp_path[1100];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", inventory.path, (int)getpid());
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        pthread_mutex_unlock(&inventory.lock);
+        return;
+    }
+    
+    struct inventory_cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INVENTORY_CACHE_MAGIC, sizeof(header.magic));
+    header.version = INVENTORY_CACHE_VERSION;
+    header.entry_size = sizeof(struct inventory_entry);
+    header.entry_count = inventory.update_count;
+    for (uint32_t i = 0; i < inventory.count; i++) {
+        int replaced = 0;
+        for (int j = 0; j < inventory.update_count && !replaced; j++) {
+            replaced = inventory_key_equal(&inventory.entries[i].key, &inventory.updates[j].key);
+        }
+        if (!replaced) {
+            header.entry_count++;
+        }
+    }
+    
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (inventory.update_count > 0) {
+        ok = ok && fwrite(inventory.updates, sizeof(struct inventory_entry), inventory.update_count, fp) ==
+                   (size_t)inventory.update_count;
+    }
+    for (uint32_t i = 0; i < inventory.count && ok; i++) {
+        int replaced = 0;
+        for (int j = 0; j < inventory.update_count && !replaced; j++) {
+            replaced = inventory_key_equal(&inventory.entries[i].key, &inventory.updates[j].key);
+        }
+        if (!replaced) {
+            ok = fwrite(&inventory.entries[i], sizeof(struct inventory_entry), 1, fp) == 1;
+        }
+    }
+    ok = (fflush(fp) == 0) && ok;
+    ok = (fsync(fileno(fp)) == 0) && ok;
+    ok = (fclose(fp) == 0) && ok;
+    
+    if (ok && rename(tmp_path, inventory.path) == 0) {
+        inventory.dirty = 0;
+    } else {
+        unlink(tmp_path);
+    }
+    pthread_mutex_unlock(&inventory.lock);
+}
+
+static void trim_trailing_spaces(char* text) {
+    size_t len = strlen(text);
+    while (len > 0 && text[len - 1] == ' ') {
+        text[--len] = '\0';
+    }
+}
+
+// Serial number and firmware revision of a device, read from sysfs so the
+// cache can be consulted before any command is sent to the drive
+static int inventory_device_key(int block_fd, const struct device_profile* profile, struct inventory_key* key) {
+    memset(key, 0, sizeof(*key));
+    if (profile->is_nvme) {
+        sysfs_read_attr(block_fd, "device/serial", key->serial, sizeof(key->serial));
+        sysfs_read_attr(block_fd, "device/firmware_rev", key->firmware, sizeof(key->firmware));
+        long long nsid = sysfs_read_number(block_fd, "nsid");
+        key->nsid = nsid > 0 ? (uint32_t)nsid : 0;
+    } else {
+        // Unit Serial Number VPD page: 4 byte header, then the serial
+        unsigned char page[256];
+        int fd = openat(block_fd, "device/vpd_pg80", O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            ssize_t len = read(fd, page, sizeof(page));
+            close(fd);
+            if (len > 4) {
+                int serial_len = page[3];
+                if (serial_len > len - 4) {
+                    serial_len = (int)len - 4;
+                }
+                if (serial_len > (int)sizeof(key->serial) - 1) {
+                    serial_len = sizeof(key->serial) - 1;
+                }
+                int start = 0;
+                while (start < serial_len && page[4 + start] == ' ') {
+                    start++;
+                }
+                memcpy(key->serial, &page[4 + start], serial_len - start);
+                key->serial[serial_len - start] = '\0';
+            }
+        }
+        sysfs_read_attr(block_fd, "device/rev", key->firmware, sizeof(key->firmware));
+    }
+    
+    // Trim the space padding sysfs keeps from the identify strings
+    trim_trailing_spaces(key->serial);
+    trim_trailing_spaces(key->firmware);
+    return (key->serial[0] && key->firmware[0]) ? 0 : -1;
+}
+
+// Identify this namespace and sum the capacity of all active ones; usage
+// changes with every write or trim, so this is never cached
+static void nvme_probe_namespaces(int fd, struct device_profile* profile) {
+    profile->nvme_allocated_bytes = 0;
+    profile->nvme_nsid = nvme_namespace_id(fd);
+    if (profile->nvme_nsid) {
+        nvme_identify_namespace(fd, profile->nvme_nsid, &profile->nvme_ns);
+    }
+    
+    uint32_t namespaces[NVME_MAX_ACTIVE_NS];
+    profile->nvme_ns_count = nvme_active_namespaces(fd, namespaces, NVME_MAX_ACTIVE_NS);
+    for (int i = 0; i < profile->nvme_ns_count; i++) {
+        struct nvme_ns_info ns;
+        if (nvme_identify_namespace(fd, namespaces[i], &ns) != 0) {
+            ns.nsze = ns.ncap = 0;
+            ns.flbas = 0;
+            ns.lbaf[0].data_size_shift = 9;
+        }
+        unsigned long long block_size = 1ULL << ns.lbaf[ns.flbas & 0x0f].data_size_shift;
+        profile->nvme_allocated_bytes += ns.ncap * block_size;
+        if (i < NVME_MAX_PROFILE_NS) {
+            profile->nvme_namespaces[i].nsid = namespaces[i];
+            profile->nvme_namespaces[i].nsze = ns.nsze;
+            profile->nvme_namespaces[i].block_size = block_size;
+        }
+    }
+}
+
+// Send the identify commands; the firmware slots and DCO results are stable
+// for a given firmware and go to the inventory cache
+static void probe_identify_data(int fd, struct device_profile* profile) {
+    if (profile->is_nvme) {
+        if (nvme_identify_controller(fd, &profile->nvme_ctrl) != 0) {
+            return;
+        }
+        nvme_probe_namespaces(fd, profile);
+        profile->nvme_fw_log_valid = nvme_read_fw_slot_log(fd, &profile->nvme_fw_log) == 0;
+    } else {
+        ata_probe(fd, &profile->ata);
+    }
+}
+
+// On an inventory cache hit: re-read what a drive changes without a firmware
+// update (ATA HPA and security state, NVMe unallocated capacity and
+// namespace usage)
+static int probe_live_identify(int fd, struct device_profile* profile) {
+    if (profile->is_nvme) {
+        if (nvme_identify_controller(fd, &profile->nvme_ctrl) != 0) {
+            return -1;
+        }
+        nvme_probe_namespaces(fd, profile);
+        return 0;
+    }
+    return ata_probe_identify(fd, &profile->ata);
+}
+
+// Collect the sysfs attributes, identify data and SMART counters of a device
+static void probe_device_profile(const char* device, struct device_profile* profile) {
+    memset(profile, 0, sizeof(*profile));
+    snprintf(profile->name, sizeof(profile->name), "%s", device);
+    snprintf(profile->dev_path, sizeof(profile->dev_path), "%s/%.63s", dev_root, device);
+    profile->is_nvme = strncmp(device, "nvme", 4) == 0;
+    profile->nvme_ns_count = -1;
+    smart_health_init(&profile->smart);
+    const char *outer_device = trace_set_device(profile->name);
+    double probe_span = trace_begin();
+    double span = probe_span;
+    
+    // All attributes are read relative to /sys/block/<device>
+    int blocks_fd = sysfs_open_dir("block");
+    int block_fd = sysfs_open_subdir(blocks_fd, device);
+    
+    profile->rotational = (int)sysfs_read_number(block_fd, "queue/rotational");
+    sysfs_read_attr(block_fd, "device/model", profile->model, sizeof(profile->model));
+    sysfs_read_attr(block_fd, "device/vendor", profile->vendor, sizeof(profile->vendor));
+    if (sysfs_read_attr(block_fd, "serial", profile->serial, sizeof(profile->serial)) <= 0) {
+        sysfs_read_attr(block_fd, "device/serial", profile->serial, sizeof(profile->serial));
+    }
+    profile->sectors = sysfs_read_number(block_fd, "size");
+    profile->physical_block_size = (int)sysfs_read_number(block_fd, "queue/physical_block_size");
+    profile->logical_block_size = (int)sysfs_read_number(block_fd, "queue/logical_block_size");
+    profile->removable = (int)sysfs_read_number(block_fd, "removable");
+    profile->read_only = (int)sysfs_read_number(block_fd, "ro");
+    profile->discard_max_bytes = sysfs_read_number(block_fd, "queue/discard_max_bytes");
+    profile->discard_granularity = sysfs_read_number(block_fd, "queue/discard_granularity");
+    profile->write_zeroes_max_bytes = sysfs_read_number(block_fd, "queue/write_zeroes_max_bytes");
+    
+    // Check for NVMe and interface type
+    ssize_t len = readlinkat(blocks_fd, device, profile->sysfs_link, sizeof(profile->sysfs_link) - 1);
+    if (blocks_fd >= 0) {
+        close(blocks_fd);
+    }
+    if (len != -1) {
+        profile->sysfs_link[len] = '\0';
+        profile->link_valid = 1;
+        if (strstr(profile->sysfs_link, "nvme")) {
+            profile->interface = IFACE_NVME;
+        } else if (strstr(profile->sysfs_link, "ata")) {
+            profile->interface = IFACE_SATA;
+        } else if (strstr(profile->sysfs_link, "usb")) {
+            profile->interface = IFACE_USB;
+        } else if (strstr(profile->sysfs_link, "mmc")) {
+            profile->interface = IFACE_MMC;
+        } else if (strstr(profile->sysfs_link, "virtio")) {
+            profile->interface = IFACE_VIRTIO;
+        }
+        if (strstr(profile->sysfs_link, "usb")) {
+            const struct usb_topology *topology = usb_topology_get();
+            int index = topology ? usb_topology_device_for_path(topology, profile->sysfs_link) : -1;
+            if (index >= 0) {
+                const struct usb_device_record *usb = &topology->devices[index];
+                snprintf(profile->usb_bus_id, sizeof(profile->usb_bus_id), "%s", usb->name);
+                snprintf(profile->usb_device_path, sizeof(profile->usb_device_path), "%.250s/%.255s", sysfs_root, usb->path);
+            }
+        }
+    }
+    trace_end("sysfs_attributes", span, block_fd >= 0 ? 0 : -1);
+    
+    span = trace_begin();
+    int fd = open(profile->dev_path, O_RDONLY | O_NONBLOCK);
+    trace_end("open", span, fd < 0 ? errno : 0);
+    if (fd < 0) {
+        profile->open_failed = 1;
+    } else {
+        unsigned long long size;
+        if (ioctl(fd, BLKGETSIZE64, &size) == 0) {
+            profile->kernel_size = size;
+            profile->kernel_size_valid = 1;
+        }
+        
+        // Stable identify data is reused from the inventory cache when the
+        // drive reports the same serial number and firmware revision
+        struct inventory_key key;
+        struct inventory_entry cached;
+        span = trace_begin();
+        int have_key = inventory.enabled && inventory_device_key(block_fd, profile, &key) == 0;
+        if (have_key && inventory_lookup(&key, &cached) == 0 && probe_live_identify(fd, profile) == 0 &&
+            inventory_entry_current(&cached, profile)) {
+            inventory_apply(&cached, profile);
+            trace_end("inventory_cache", span, 0);
+        } else {
+            probe_identify_data(fd, profile);
+            trace_end(profile->is_nvme ? "nvme_identify" : "ata_identify", span,
+                      profile->ata.valid || profile->nvme_ctrl.valid ? 0 : -1);
+            if (have_key && (profile->ata.valid || profile->nvme_ctrl.valid)) {
+                inventory_store(&key, profile);
+            }
+        }
+        
+        // SMART counters are volatile and always read from the drive
+        span = trace_begin();
+        if (profile->is_nvme) {
+            trace_end("nvme_smart", span, nvme_read_smart(fd, &profile->smart));
+        } else if (profile->ata.valid) {
+            trace_end("ata_smart", span, ata_read_smart(fd, &profile->smart));
+        }
+        
+        // SAS disks and USB bridges: limits of the WRITE SAME / UNMAP sanitize
+        // methods. zram, virtio-blk and MMC have no SCSI device to ask.
+        if (!profile->is_nvme && !profile->ata.valid && faccessat(block_fd, "device/scsi_level", F_OK, 0) == 0 &&
+            (profile->interface != IFACE_USB || scsi_probe_usb)) {
+            span = trace_begin();
+            trace_end("scsi_vpd", span, scsi_probe(fd, &profile->scsi));
+            if (!profile->serial[0]) {
+                snprintf(profile->serial, sizeof(profile->serial), "%s", profile->scsi.unit_serial);
+            }
+        }
+        close(fd);
+    }
+    
+    if (profile->is_nvme && !profile->nvme_ctrl.valid) {
+        sysfs_read_attr(block_fd, "device/firmware_rev", profile->sysfs_firmware, sizeof(profile->sysfs_firmware));
+    }
+    if (!profile->is_nvme && !profile->ata.valid) {
+        profile->scsi_type = (int)sysfs_read_number(block_fd, "device/type");
+    } else {
+        profile->scsi_type = -1;
+    }
+    if (block_fd >= 0) {
+        close(block_fd);
+    }
+    
+    // Neither ATA nor NVMe SMART answered (e.g. SAS or unsupported bridge)
+    if (!profile->smart.valid) {
+        char cmd[512];
+        snprintf(cmd, sizeof(cmd), "smartctl -H %s 2>/dev/null", profile->dev_path);
+        span = trace_begin();
+        FILE *smart_output = popen(cmd, "r");
+        if (smart_output) {
+            char line[256];
+            size_t used = 0;
+            profile->smartctl_available = 1;
+            while (fgets(line, sizeof(line), smart_output)) {
+                if (strstr(line, "SMART overall-health") || 
+                    strstr(line, "SMART Health Status") ||
+                    strstr(line, "PASSED") || 
+                    strstr(line, "FAILED")) {
+                    int written = snprintf(profile->smartctl_status + used,
+                                           sizeof(profile->smartctl_status) - used, "%s", line);
+                    if (written > 0 && used + written < sizeof(profile->smartctl_status)) {
+                        used += written;
+                    }
+                }
+            }
+            trace_end("smartctl", span, trace_exit_status(pclose(smart_output)));
+        }
+    }
+    trace_end("probe_device_profile", probe_span, profile->open_failed);
+    trace_set_device(outer_device);
+}
+
+void check_hpa_dco_linux(const struct device_profile* profile) {
+    report_printf("=== HPA/DCO Analysis ===\n");
+    
+    if (profile->open_failed) {
+        report_printf("Cannot open %s for HPA/DCO analysis (try running as root)\n", profile->dev_path);
+        return;
+    }
+    
+    // Check if it's NVMe device
+    if (profile->is_nvme) {
+        report_printf("NVMe Device Detected - Checking security features...\n");
+        
+        if (profile->kernel_size_valid) {
+            report_printf("Device Size: %llu bytes (%.2f GB)\n", 
+                   profile->kernel_size, profile->kernel_size / (1024.0 * 1024.0 * 1024.0));
+        }
+        
+        // Check NVMe controller identity and security features
+        const struct nvme_ctrl_info *ctrl = &profile->nvme_ctrl;
+        report_printf("NVMe Security Features:\n");
+        if (ctrl->valid) {
+            report_printf("  Controller: %s (SN %s, FW %s, NSID %u)\n",
+                   ctrl->model, ctrl->serial, ctrl->firmware, profile->nvme_nsid);
+            report_nvme_security_caps(ctrl, "  ");
+        } else {
+            report_printf("  Unable to query NVMe controller (admin commands require root)\n");
+        }
+        
+        report_printf("HPA/DCO Status: Not applicable for NVMe devices\n");
+        report_printf("Note: NVMe uses different security mechanisms than ATA devices\n");
+        
+    } else {
+        // Check if it's an ATA device
+        const struct ata_identify_info *ata = &profile->ata;
+        if (ata->valid) {
+            report_printf("ATA Device Detected - Checking for HPA/DCO...\n");
+            
+            // Get accessible capacity
+            if (profile->kernel_size_valid) {
+                unsigned long long accessible_max = profile->kernel_size / 512; // Convert bytes to sectors
+                report_printf("Accessible Capacity: %llu sectors (%.2f GB)\n", 
+                       accessible_max, (accessible_max * 512.0) / (1024.0 * 1024.0 * 1024.0));
+            }
+            
+            // Check for HPA (Host Protected Area)
+            report_printf("HPA Status: ");
+            if (ata->hpa_supported) {
+                report_printf("HPA Feature Supported\n");
+                report_printf("HPA Information:\n");
+                if (ata->native_max_valid) {
+                    int hpa_active = ata->native_max_sectors > ata->user_max_sectors;
+                    report_printf("  max sectors   = %llu/%llu, HPA is %s\n",
+                           ata->user_max_sectors, ata->native_max_sectors,
+                           hpa_active ? "enabled" : "disabled");
+                    if (hpa_active) {
+                        unsigned long long hidden = ata->native_max_sectors - ata->user_max_sectors;
+                        report_printf("  ⚠️  %llu sectors (%.2f GB) hidden by HPA\n",
+                               hidden, (hidden * 512.0) / (1024.0 * 1024.0 * 1024.0));
+                    }
+                } else {
+                    report_printf("  Unable to read native max address (drive rejected READ NATIVE MAX)\n");
+                }
+            } else {
+                report_printf("HPA Feature Not Supported\n");
+            }
+            
+            // Check for DCO (Device Configuration Overlay)
+            report_printf("DCO Status: ");
+            if (ata->dco_supported) {
+                report_printf("DCO Feature Supported\n");
+                report_printf("  ⚠️  Warning: DCO may hide device capacity and features\n");
+                report_printf("DCO Information:\n");
+                if (ata->dco_valid) {
+                    report_printf("  Real max sectors: %llu\n", ata->dco_real_max_sectors);
+                    unsigned long long visible = ata->native_max_valid ? ata->native_max_sectors : ata->user_max_sectors;
+                    if (ata->dco_real_max_sectors > visible) {
+                        unsigned long long hidden = ata->dco_real_max_sectors - visible;
+                        report_printf("  ⚠️  %llu sectors (%.2f GB) hidden by DCO\n",
+                               hidden, (hidden * 512.0) / (1024.0 * 1024.0 * 1024.0));
+                    }
+                } else {
+                    report_printf("  Unable to read DCO data (drive may be frozen or DCO locked)\n");
+                }
+            } else {
+                report_printf("DCO Feature Not Supported\n");
+            }
+            
+            // Additional security features
+            report_printf("\n=== ATA Security Features ===\n");
+            
+            // Security feature set
+            if (ata->security_supported) {
+                report_printf("Security Feature Set: ✓ Supported\n");
+                report_ata_security_state(ata, "  ");
+            } else {
+                report_printf("Security Feature Set: ✗ Not Supported\n");
+            }
+            
+            // Sanitize feature set (ACS-2)
+            if (ata->sanitize_supported) {
+                report_printf("Sanitize Feature: ✓ Supported\n");
+            } else {
+                report_printf("Sanitize Feature: ✗ Not Supported\n");
+            }
+            
+        } else {
+            report_printf("Not an ATA device or unable to get ATA identity\n");
+            
+            // For non-ATA devices, try alternative methods
+            report_printf("Attempting alternative capacity detection...\n");
+            
+            if (profile->kernel_size_valid) {
+                report_printf("Device Size: %llu bytes (%.2f GB)\n", 
+                       profile->kernel_size, profile->kernel_size / (1024.0 * 1024.0 * 1024.0));
+            }
+            
+            // Check if it's a SCSI device
+            if (profile->scsi_type >= 0) {
+                report_printf("SCSI Device Type: %d ", profile->scsi_type);
+                switch (profile->scsi_type) {
+                    case 0: report_printf("(Direct Access - Disk)\n"); break;
+                    case 5: report_printf("(CD-ROM)\n"); break;
+                    case 7: report_printf("(Optical Memory)\n"); break;
+                    default: report_printf("(Other)\n"); break;
+                }
+            }
+            if (profile->scsi.valid) {
+                report_printf("SCSI Block Limits:\n");
+                report_scsi_block_limits(&profile->scsi, "  ");
+            }
+            
+            report_printf("HPA/DCO Status: Not applicable for this device type\n");
+        }
+    }
+}
+
+void check_smart_info_linux(const struct device_profile* profile) {
+    report_printf("\n=== SMART Status ===\n");
+    
+    const struct smart_health_info *smart = &profile->smart;
+    if (smart->valid) {
+        if (smart->passed >= 0) {
+            report_printf("SMART overall-health self-assessment test result: %s\n", smart->passed ? "PASSED" : "FAILED!");
+        }
+        if (smart->is_nvme) {
+            report_printf("Critical Warning: 0x%02x\n", smart->critical_warning);
+            report_printf("Available Spare: %d%%\n", smart->available_spare);
+            report_printf("Percentage Used: %d%%\n", smart->percentage_used);
+            report_printf("Media and Data Integrity Errors: %lld\n", smart->media_errors);
+            report_printf("Unsafe Shutdowns: %lld\n", smart->unsafe_shutdowns);
+        } else {
+            if (smart->reallocated_sectors >= 0) {
+                report_printf("Reallocated Sectors: %lld\n", smart->reallocated_sectors);
+            }
+            if (smart->pending_sectors >= 0) {
+                report_printf("Current Pending Sectors: %lld\n", smart->pending_sectors);
+            }
+            if (smart->offline_uncorrectable >= 0) {
+                report_printf("Offline Uncorrectable: %lld\n", smart->offline_uncorrectable);
+            }
+        }
+        if (smart->power_on_hours >= 0) {
+            report_printf("Power-On Hours: %lld\n", smart->power_on_hours);
+        }
+        if (smart->temperature_c >= 0) {
+            report_printf("Temperature: %d Celsius\n", smart->temperature_c);
+        }
+    } else if (profile->smartctl_available) {
+        if (profile->smartctl_status[0]) {
+            report_printf("%s", profile->smartctl_status);
+        } else {
+            report_printf("SMART information not available (smartctl not installed or device doesn't support SMART)\n");
+        }
+    } else {
+        report_printf("Cannot check SMART status (smartctl not available)\n");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// USB ID database (usb.ids) and known mobile vendors
+// ---------------------------------------------------------------------------
+//
+// The usb.ids file shipped with usbutils/hwdata is mapped read-only and
+// indexed once, on the first lookup: one open-addressing table of vendor,
+// product, class, subclass and protocol keys, each pointing at its name inside
+// the mapping. Names are never copied until a lookup asks for one.
+
+#define USB_IDS_VENDOR      1ULL
+#define USB_IDS_PRODUCT     2ULL
+#define USB_IDS_CLASS       3ULL
+#define USB_IDS_SUBCLASS    4ULL
+#define USB_IDS_PROTOCOL    5ULL
+#define USB_IDS_FILE        "usb.ids"
+
+struct usb_ids_entry {
+    uint64_t key;                       // kind << 48 | id << 32 | id << 16 | id, 0 when free
+    uint32_t name;                      // offset of the name in the mapping
+    uint32_t len;
+};
+
+struct usb_ids_index {
+    const char *map;
+    size_t size;
+    struct usb_ids_entry *entries;
+    size_t mask;                        // table size - 1, a power of two
+    char path[512];                     // file the index was built from, empty if none
+};
+
+// --usb-ids, else the state directory's copy, else the distribution's
+static char usb_ids_path[512] = "";
+static struct usb_ids_index usb_ids;
+static pthread_once_t usb_ids_once = PTHREAD_ONCE_INIT;
+
+static uint64_t usb_ids_key(uint64_t kind, unsigned a, unsigned b, unsigned c) {
+    return kind << 48 | (uint64_t)(a & 0xffff) << 32 | (uint64_t)(b & 0xffff) << 16 | (c & 0xffff);
+}
+
+static size_t usb_ids_slot(uint64_t key, size_t mask) {
+    return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+// Exactly digits hex digits at p followed by whitespace
+static int usb_ids_hex(const char* p, const char* end, int digits, unsigned* value) {
+    unsigned v = 0;
+    for (int i = 0; i < digits; i++) {
+        if (p + i >= end || !isxdigit((unsigned char)p[i])) {
+            return -1;
+        }
+        v = v * 16 + (unsigned)(isdigit((unsigned char)p[i]) ? p[i] - '0' : (p[i] | 0x20) - 'a' + 10);
+    }
+    if (p + digits >= end || (p[digits] != ' ' && p[digits] != '\t')) {
+        return -1;
+    }
+    *value = v;
+    return 0;
+}
+
+// Walk the lines of the mapping; with entries NULL only count them
+static size_t usb_ids_parse(const char* map, size_t size, struct usb_ids_entry* entries, size_t mask) {
+    size_t count = 0;
+    uint64_t section = 0;               // USB_IDS_VENDOR, USB_IDS_CLASS or 0 for the other lists
+    unsigned top = 0, middle = 0;
+    const char *end = map + size;
+    for (const char *line = map; line < end; ) {
+        const char *eol = (const char*)memchr(line, '\n', (size_t)(end - line));
+        if (!eol) {
+            eol = end;
+        }
+        int tabs = 0;
+        while (line + tabs < eol && line[tabs] == '\t') {
+            tabs++;
+        }
+        const char *p = line + tabs;
+        uint64_t key = 0;
+        int digits = 0;
+        unsigned id = 0;
+        if (p < eol && *p != '#') {
+            if (tabs == 0 && usb_ids_hex(p, eol, 4, &id) == 0) {
+                section = USB_IDS_VENDOR;
+                top = id;
+                key = usb_ids_key(USB_IDS_VENDOR, id, 0, 0);
+                digits = 4;
+            } else if (tabs == 0 && p[0] == 'C' && p + 1 < eol && p[1] == ' ' && usb_ids_hex(p + 2, eol, 2, &id) == 0) {
+                section = USB_IDS_CLASS;
+                top = id;
+                key = usb_ids_key(USB_IDS_CLASS, id, 0, 0);
+                p += 2;
+                digits = 2;
+            } else if (tabs == 0) {
+                section = 0;
+            } else if (tabs == 1 && section == USB_IDS_VENDOR && usb_ids_hex(p, eol, 4, &id) == 0) {
+                key = usb_ids_key(USB_IDS_PRODUCT, top, id, 0);
+                digits = 4;
+            } else if (tabs == 1 && section == USB_IDS_CLASS && usb_ids_hex(p, eol, 2, &id) == 0) {
+                middle = id;
+                key = usb_ids_key(USB_IDS_SUBCLASS, top, id, 0);
+                digits = 2;
+            } else if (tabs == 2 && section == USB_IDS_CLASS && usb_ids_hex(p, eol, 2, &id) == 0) {
+                key = usb_ids_key(USB_IDS_PROTOCOL, top, middle, id);
+                digits = 2;
+            }
+        }
+        if (key) {
+            count++;
+            if (entries) {
+                const char *name = p + digits;
+                while (name < eol && (*name == ' ' || *name == '\t')) {
+                    name++;
+                }
+                size_t slot = usb_ids_slot(key, mask);
+                while (entries[slot].key && entries[slot].key != key) {
+                    slot = (slot + 1) & mask;
+                }
+                // The first definition wins, like lsusb
+                if (!entries[slot].key) {
+                    entries[slot].key = key;
+                    entries[slot].name = (uint32_t)(name - map);
+                    entries[slot].len = (uint32_t)(eol - name);
+                }
+            }
+        }
+        line = eol + 1;
+    }
+    return count;
+}
+
+static int usb_ids_map(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && (unsigned long long)st.st_size < 0xffffffffULL) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    usb_ids.map = (const char*)map;
+    usb_ids.size = (size_t)st.st_size;
+    snprintf(usb_ids.path, sizeof(usb_ids.path), "%s", path);
+    return 0;
+}
+
+static void usb_ids_load(void) {
+    char local[600] = "";
+    char dir[512];
+    if (state_dir[0]) {
+        snprintf(dir, sizeof(dir), "%s", state_dir);
+    } else {
+        default_state_dir(dir, sizeof(dir));
+    }
+    if (dir[0]) {
+        snprintf(local, sizeof(local), "%s/%s", dir, USB_IDS_FILE);
+    }
+    const char *const candidates[] = {
+        usb_ids_path, local, "/usr/share/hwdata/usb.ids", "/usr/share/misc/usb.ids",
+        "/usr/share/usb.ids", "/var/lib/usbutils/usb.ids"
+    };
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        if (candidates[i][0] && usb_ids_map(candidates[i]) == 0) {
+            break;
+        }
+        // An explicit --usb-ids is the only file tried
+        if (i == 0 && usb_ids_path[0]) {
+            return;
+        }
+    }
+    if (!usb_ids.map) {
+        return;
+    }
+    
+    size_t count = usb_ids_parse(usb_ids.map, usb_ids.size, NULL, 0);
+    size_t slots = 64;
+    while (slots < count * 2) {
+        slots *= 2;
+    }
+    usb_ids.entries = (struct usb_ids_entry*)calloc(slots, sizeof(struct usb_ids_entry));
+    if (!usb_ids.entries) {
+        munmap((void*)usb_ids.map, usb_ids.size);
+        usb_ids.map = NULL;
+        return;
+    }
+    usb_ids.mask = slots - 1;
+    usb_ids_parse(usb_ids.map, usb_ids.size, usb_ids.entries, usb_ids.mask);
+}
+
+// Copy the name of key into out; returns its length or -1 if unknown
+static int usb_ids_lookup(uint64_t key, char* out, size_t size) {
+    pthread_once(&usb_ids_once, usb_ids_load);
+    if (!usb_ids.entries) {
+        return -1;
+    }
+    for (size_t slot = usb_ids_slot(key, usb_ids.mask); usb_ids.entries[slot].key; slot = (slot + 1) & usb_ids.mask) {
+        const struct usb_ids_entry *entry = &usb_ids.entries[slot];
+        if (entry->key == key) {
+            snprintf(out, size, "%.*s", (int)entry->len, usb_ids.map + entry->name);
+            return (int)entry->len;
+        }
+    }
+    return -1;
+}
+
+static int usb_ids_vendor_name(unsigned vendor_id, char* out, size_t size) {
+    return usb_ids_lookup(usb_ids_key(USB_IDS_VENDOR, vendor_id, 0, 0), out, size);
+}
+
+static int usb_ids_product_name(unsigned vendor_id, unsigned product_id, char* out, size_t size) {
+    return usb_ids_lookup(usb_ids_key(USB_IDS_PRODUCT, vendor_id, product_id, 0), out, size);
+}
+
+// Most specific name known for a class triple
+static int usb_ids_class_name(unsigned device_class, unsigned subclass, unsigned protocol, char* out, size_t size) {
+    int len = usb_ids_lookup(usb_ids_key(USB_IDS_PROTOCOL, device_class, subclass, protocol), out, size);
+    if (len < 0) {
+        len = usb_ids_lookup(usb_ids_key(USB_IDS_SUBCLASS, device_class, subclass, 0), out, size);
+    }
+    if (len < 0) {
+        len = usb_ids_lookup(usb_ids_key(USB_IDS_CLASS, device_class, 0, 0), out, size);
+    }
+    return len;
+}
+
+// Phone and tablet vendors. Most of these IDs are only used on phones and
+// tablets; the shared ones also appear on SSDs, flash drives, LTE modems or
+// Wi-Fi dongles and only count with a phone interface or a usb.ids product
+// match. The table is hashed at compile time: each ID lands in its own slot,
+// so a lookup is one multiply and one compare, and works without usb.ids.
+struct mobile_vendor {
+    unsigned short vendor_id;
+    int shared;                         // ID also used on non-phone products
+    const char *detected;               // printed after the check mark
+};
+
+static constexpr struct mobile_vendor mobile_vendors[] = {
+    { 0x04e8, 1, "Samsung Mobile Device Detected" },
+    { 0x05ac, 1, "Apple Device Detected (iPhone/iPad)" },
+    { 0x18d1, 0, "Google/Android Device Detected" },
+    { 0x0bb4, 0, "HTC Device Detected" },
+    { 0x22b8, 0, "Motorola Device Detected" },
+    { 0x0fce, 0, "Sony Ericsson Device Detected" },
+    { 0x19d2, 1, "ZTE Device Detected" },
+    { 0x12d1, 1, "Huawei Device Detected" },
+    { 0x2717, 0, "Xiaomi Device Detected" },
+    { 0x2a70, 0, "OnePlus Device Detected" },
+    { 0x1004, 0, "LG Mobile Device Detected" },
+    { 0x22d9, 0, "OPPO/Realme Device Detected" },
+    { 0x2d95, 0, "vivo Device Detected" },
+    { 0x0421, 0, "Nokia Device Detected" },
+    { 0x0fca, 0, "BlackBerry Device Detected" },
+    { 0x2a45, 0, "Meizu Device Detected" },
+    { 0x2ae5, 0, "Fairphone Device Detected" },
+    { 0x1bbb, 1, "Alcatel/TCL Device Detected" },
+    { 0x0e8d, 1, "MediaTek-based Android Device Detected" },
+    { 0x1782, 0, "Spreadtrum/Unisoc-based Android Device Detected" },
+    { 0x1949, 0, "Amazon Kindle/Fire Device Detected" },
+};
+
+#define MOBILE_VENDOR_SLOTS 64
+
+static constexpr unsigned mobile_vendor_slot(unsigned vendor_id) {
+    return (vendor_id * 0x9e37b499u) >> 26;
+}
+
+struct mobile_vendor_index {
+    signed char slot[MOBILE_VENDOR_SLOTS];      // index into mobile_vendors, -1 when empty
+    int collisions;
+};
+
+static constexpr struct mobile_vendor_index mobile_vendor_index_build() {
+    struct mobile_vendor_index index = {};
+    for (int i = 0; i < MOBILE_VENDOR_SLOTS; i++) {
+        index.slot[i] = -1;
+    }
+    for (size_t i = 0; i < sizeof(mobile_vendors) / sizeof(mobile_vendors[0]); i++) {
+        unsigned slot = mobile_vendor_slot(mobile_vendors[i].vendor_id);
+        if (index.slot[slot] >= 0) {
+            index.collisions++;
+        }
+        index.slot[slot] = (signed char)i;
+    }
+    return index;
+}
+
+static constexpr struct mobile_vendor_index mobile_vendor_slots = mobile_vendor_index_build();
+static_assert(mobile_vendor_slots.collisions == 0, "mobile vendor IDs collide, pick another multiplier");
+
+static const struct mobile_vendor* mobile_vendor_lookup(unsigned vendor_id) {
+    int i = mobile_vendor_slots.slot[mobile_vendor_slot(vendor_id & 0xffff)];
+    return i >= 0 && mobile_vendors[i].vendor_id == vendor_id ? &mobile_vendors[i] : NULL;
+}
+
+// usb.ids product names of phones and tablets, e.g. "Galaxy series, misc. (MTP mode)"
+static int mobile_product_name(const char* name) {
+    static const char *const words[] = {
+        "Phone", "phone", "iPad", "iPod", "Android", "Galaxy", "Pixel", "Nexus", "Xperia", "Tablet", "MTP"
+    };
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        if (strstr(name, words[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// "04e8" from sysfs to a number, 0x10000 when missing so no table matches
+static unsigned usb_id_value(const char* text) {
+    char *end = NULL;
+    unsigned long value = strtoul(text, &end, 16);
+    return text[0] && end && *end == '\0' && value <= 0xffff ? (unsigned)value : 0x10000;
+}
+
+// Vendor and product IDs with their usb.ids names
+static void report_usb_ids(const struct usb_device_record* usb) {
+    char name[256];
+    unsigned vendor = usb_id_value(usb->vendor_id);
+    if (usb_ids_vendor_name(vendor, name, sizeof(name)) > 0) {
+        report_printf("Vendor ID: %s (%s)\n", usb->vendor_id, name);
+    } else {
+        report_printf("Vendor ID: %s\n", usb->vendor_id);
+    }
+    if (usb->present & USB_ATTR_PRODUCT_ID) {
+        if (usb_ids_product_name(vendor, usb_id_value(usb->product_id), name, sizeof(name)) > 0) {
+            report_printf("Product ID: %s (%s)\n", usb->product_id, name);
+        } else {
+            report_printf("Product ID: %s\n", usb->product_id);
+        }
+    }
+}
+
+void analyze_usb_device_details(const struct device_profile* profile) {
+    report_printf("\n=== USB Device Analysis ===\n");
+    
+    if (!profile->link_valid) {
+        report_printf("Unable to analyze USB device path\n");
+        return;
+    }
+    if (!strstr(profile->sysfs_link, "usb")) {
+        report_printf("Not a USB device\n");
+        return;
+    }
+    
+    const struct usb_topology *topology = usb_topology_get();
+    int index = topology && profile->usb_bus_id[0] ? usb_topology_find(topology, profile->usb_bus_id) : -1;
+    if (index < 0) {
+        report_printf("Unable to locate USB device information\n");
+        return;
+    }
+    const struct usb_device_record *usb = &topology->devices[index];
+    char name[256];
+    
+    report_printf("USB Device Path: %s\n", profile->usb_device_path);
+    report_usb_ids(usb);
+    if (usb->present & USB_ATTR_MANUFACTURER) {
+        report_printf("Manufacturer: %s\n", usb->manufacturer);
+    }
+    if (usb->present & USB_ATTR_PRODUCT) {
+        report_printf("Product: %s\n", usb->product);
+    }
+    if (usb->present & USB_ATTR_SERIAL) {
+        report_printf("Serial Number: %s\n", usb->serial);
+    }
+    if (usb->present & USB_ATTR_VERSION) {
+        report_printf("USB Version: %s\n", usb->version);
+    }
+    if (usb->present & USB_ATTR_SPEED) {
+        report_printf("Speed: %s Mbps\n", usb->speed);
+    }
+    if (usb->parent >= 0) {
+        report_printf("Connected to: %s\n", topology->devices[usb->parent].name);
+    }
+    
+    // Device class
+    long long device_class = usb->device_class;
+    if (device_class >= 0) {
+        report_printf("Device Class: 0x%02llx ", device_class);
+        switch (device_class) {
+            case 0x00: report_printf("(Defined at Interface Level)\n"); break;
+            case 0x01: report_printf("(Audio)\n"); break;
+            case 0x02: report_printf("(Communications)\n"); break;
+            case 0x03: report_printf("(HID - Human Interface Device)\n"); break;
+            case 0x06: report_printf("(Still Image)\n"); break;
+            case 0x07: report_printf("(Printer)\n"); break;
+            case 0x08: report_printf("(Mass Storage)\n"); break;
+            case 0x09: report_printf("(Hub)\n"); break;
+            case 0x0A: report_printf("(CDC-Data)\n"); break;
+            case 0x0E: report_printf("(Video)\n"); break;
+            case 0xEF: report_printf("(Miscellaneous)\n"); break;
+            case 0xFF: report_printf("(Vendor Specific)\n"); break;
+            default:
+                if (usb_ids_class_name((unsigned)device_class, 0x100, 0x100, name, sizeof(name)) > 0) {
+                    report_printf("(%s)\n", name);
+                } else {
+                    report_printf("(Unknown)\n");
+                }
+                break;
+        }
+    }
+    
+    // Check if it's likely a mobile phone
+    double span = trace_begin();
+    analyze_mobile_device_type(topology, usb);
+    trace_end("analyze_mobile_device_type", span, 0);
+}
+
+// Phone protocols, told apart by the class/subclass/protocol triple of the
+// interface that carries them. MTP has no class of its own (Android uses the
+// still-image or the vendor class), only its interface string names it.
+enum usb_mobile_protocol {
+    USB_PROTOCOL_NONE,
+    USB_PROTOCOL_MTP,
+    USB_PROTOCOL_PTP,
+    USB_PROTOCOL_ADB,
+    USB_PROTOCOL_FASTBOOT,
+    USB_PROTOCOL_USBMUX,
+    USB_PROTOCOL_RNDIS
+};
+
+static const char* usb_mobile_protocol_name(enum usb_mobile_protocol protocol) {
+    switch (protocol) {
+        case USB_PROTOCOL_MTP: return "MTP (Media Transfer Protocol)";
+        case USB_PROTOCOL_PTP: return "PTP (Picture Transfer Protocol)";
+        case USB_PROTOCOL_ADB: return "ADB (Android Debug Bridge)";
+        case USB_PROTOCOL_FASTBOOT: return "Fastboot (Android bootloader)";
+        case USB_PROTOCOL_USBMUX: return "Apple usbmux (iTunes/Finder sync)";
+        case USB_PROTOCOL_RNDIS: return "RNDIS (USB tethering)";
+        default: return "none";
+    }
+}
+
+static enum usb_mobile_protocol usb_interface_protocol(const struct usb_interface_record* interface) {
+    long long cls = interface->interface_class;
+    long long sub = interface->subclass;
+    long long proto = interface->protocol;
+    if (strstr(interface->label, "MTP")) {
+        return USB_PROTOCOL_MTP;
+    }
+    if (cls == 0x06 && sub == 0x01 && proto == 0x01) {
+        return USB_PROTOCOL_PTP;
+    }
+    if (cls == 0xff && sub == 0x42 && proto == 0x01) {
+        return USB_PROTOCOL_ADB;
+    }
+    if (cls == 0xff && sub == 0x42 && proto == 0x03) {
+        return USB_PROTOCOL_FASTBOOT;
+    }
+    if (cls == 0xff && sub == 0xfe && proto == 0x02) {
+        return USB_PROTOCOL_USBMUX;
+    }
+    if (cls == 0xe0 && sub == 0x01 && proto == 0x03) {
+        return USB_PROTOCOL_RNDIS;
+    }
+    return USB_PROTOCOL_NONE;
+}
+
+void analyze_mobile_device_type(const struct usb_topology* topology, const struct usb_device_record* usb) {
+    report_printf("\n=== Mobile Device Detection ===\n");
+    
+    const char *vendor_id = usb->vendor_id;
+    const char *product_id = usb->product_id;
+    const char *manufacturer = usb->manufacturer;
+    const char *product = usb->product;
+    
+    // Check for known mobile device vendors
+    int is_mobile = 0;
+    report_printf("Device Type Analysis:\n");
+    
+    // A phone protocol on one of the device's own interfaces; PTP alone is
+    // left out, cameras speak it too, and so is RNDIS, which LTE modems use
+    const struct usb_interface_record *interfaces = topology->interfaces + usb->first_interface;
+    enum usb_mobile_protocol signature = USB_PROTOCOL_NONE;
+    for (int i = 0; i < usb->interface_count && signature == USB_PROTOCOL_NONE; i++) {
+        enum usb_mobile_protocol protocol = usb_interface_protocol(&interfaces[i]);
+        if (protocol != USB_PROTOCOL_PTP && protocol != USB_PROTOCOL_RNDIS) {
+            signature = protocol;
+        }
+    }
+    
+    // Known mobile vendors first, then what usb.ids calls the product. Vendors
+    // that also make SSDs, modems or Wi-Fi dongles need more than their ID.
+    unsigned vendor = usb_id_value(vendor_id);
+    const struct mobile_vendor *known = mobile_vendor_lookup(vendor);
+    char model[256];
+    int model_is_mobile = usb_ids_product_name(vendor, usb_id_value(product_id), model, sizeof(model)) > 0 &&
+                          mobile_product_name(model);
+    if (known && (!known->shared || signature != USB_PROTOCOL_NONE || model_is_mobile)) {
+        report_printf("  ✓ %s\n", known->detected);
+        is_mobile = 1;
+    } else if (model_is_mobile) {
+        report_printf("  ✓ Mobile Device (usb.ids: %s)\n", model);
+        is_mobile = 1;
+    }
+    
+    // Check manufacturer and product strings for mobile indicators; the
+    // manufacturer alone is also on Samsung SSDs and Apple keyboards
+    int phone_interface = signature != USB_PROTOCOL_NONE;
+    if (!is_mobile) {
+        if (((strstr(manufacturer, "Samsung") || strstr(manufacturer, "SAMSUNG")) && phone_interface) ||
+            strstr(product, "Galaxy") || strstr(product, "GALAXY")) {
+            report_printf("  ✓ Samsung Mobile Device (by name)\n");
+            is_mobile = 1;
+        } else if ((strstr(manufacturer, "Apple") && phone_interface) || strstr(product, "iPhone") ||
+                   strstr(product, "iPad") || strstr(product, "iPod")) {
+            report_printf("  ✓ Apple Mobile Device (by name)\n");
+            is_mobile = 1;
+        } else if ((strstr(manufacturer, "Google") && phone_interface) || strstr(product, "Android") ||
+                   strstr(product, "Pixel")) {
+            report_printf("  ✓ Android Device (by name)\n");
+            is_mobile = 1;
+        } else if (strstr(product, "Phone") || strstr(product, "PHONE") ||
+                   strstr(product, "Mobile") || strstr(product, "MOBILE")) {
+            report_printf("  ✓ Mobile Device (by description)\n");
+            is_mobile = 1;
+        }
+    }
+    
+    // A phone with an unknown vendor and name still shows its protocols
+    if (!is_mobile && signature != USB_PROTOCOL_NONE) {
+        report_printf("  ✓ Mobile Device (by interface: %s)\n", usb_mobile_protocol_name(signature));
+        is_mobile = 1;
+    }
+    
+    if (!is_mobile) {
+        report_printf("  - Not identified as a mobile device\n");
+        report_printf("  - May be a USB storage device, hub, or other peripheral\n");
+    } else {
+        report_printf("\n=== Mobile Device Features ===\n");
+        
+        // Only this device's own interfaces are looked at
+        report_printf("Transfer Protocols:\n");
+        int found_protocol = 0;
+        int adb_found = 0;
+        for (int i = 0; i < usb->interface_count; i++) {
+            const struct usb_interface_record *interface = &interfaces[i];
+            enum usb_mobile_protocol protocol = usb_interface_protocol(interface);
+            if (protocol == USB_PROTOCOL_NONE) {
+                continue;
+            }
+            if (protocol == USB_PROTOCOL_ADB) {
+                adb_found = 1;
+            }
+            report_printf("  %s on interface %s", usb_mobile_protocol_name(protocol), interface->name);
+            if (interface->interface_class >= 0) {
+                report_printf(" (%02llx/%02llx/%02llx)", interface->interface_class,
+                              interface->subclass & 0xff, interface->protocol & 0xff);
+            }
+            if (interface->label[0]) {
+                report_printf(" \"%s\"", interface->label);
+            }
+            report_printf("\n");
+            found_protocol = 1;
+        }
+        if (!found_protocol) {
+            report_printf("  Standard USB protocols detected\n");
+        }
+        
+        // The ADB interface (ff/42/01) only exists while USB debugging is on
+        report_printf("\nADB Device Check:\n");
+        if (adb_found) {
+            report_printf("  ADB interface present: USB debugging is enabled\n");
+        } else {
+            report_printf("  No ADB interface (may need USB debugging enabled)\n");
+        }
+    }
+}
+
+// Final record of a structured listing, tells collectors the stream for scope is complete
+static void emit_summary_record(const char* scope, int count, const char* error) {
+    struct record rec;
+    record_begin(&rec, error ? "error" : "summary");
+    record_string(&rec, "scope", scope);
+    if (error) {
+        record_string(&rec, "message", error);
+    } else {
+        record_int(&rec, "count", count);
+    }
+    record_emit(&rec);
+}
+
+// Structured form of the USB listing: one "usb_device" record per device
+static void emit_usb_device_records(const struct usb_topology* topology) {
+    if (!topology->valid) {
+        emit_summary_record("usb", 0, "cannot access USB device information");
+        return;
+    }
+    
+    int usb_count = 0;
+    for (int i = 0; i < topology->count; i++) {
+        const struct usb_device_record *usb = &topology->devices[i];
+        // Root hubs (usbN) are part of the host controller
+        if (!strchr(usb->name, '-')) {
+            continue;
+        }
+        struct record rec;
+        record_begin(&rec, "usb_device");
+        record_string(&rec, "bus_id", usb->name);
+        record_string(&rec, "vendor_id", usb->vendor_id);
+        static const struct {
+            unsigned flag;
+            size_t offset;
+            const char *key;
+        } attrs[] = {
+            { USB_ATTR_PRODUCT_ID, offsetof(struct usb_device_record, product_id), "product_id" },
+            { USB_ATTR_MANUFACTURER, offsetof(struct usb_device_record, manufacturer), "manufacturer" },
+            { USB_ATTR_PRODUCT, offsetof(struct usb_device_record, product), "product" },
+            { USB_ATTR_SERIAL, offsetof(struct usb_device_record, serial), "serial" },
+            { USB_ATTR_VERSION, offsetof(struct usb_device_record, version), "usb_version" },
+            { USB_ATTR_SPEED, offsetof(struct usb_device_record, speed), "speed_mbps" }
+        };
+        for (size_t a = 0; a < sizeof(attrs) / sizeof(attrs[0]); a++) {
+            if (usb->present & attrs[a].flag) {
+                record_string(&rec, attrs[a].key, (const char*)usb + attrs[a].offset);
+            }
+        }
+        record_known(&rec, "device_class", usb->device_class);
+        // Names from usb.ids
+        char name[256];
+        unsigned vendor = usb_id_value(usb->vendor_id);
+        if (usb_ids_vendor_name(vendor, name, sizeof(name)) > 0) {
+            record_string(&rec, "vendor_name", name);
+        }
+        if (usb_ids_product_name(vendor, usb_id_value(usb->product_id), name, sizeof(name)) > 0) {
+            record_string(&rec, "product_name", name);
+        }
+        if (usb->parent >= 0) {
+            record_string(&rec, "parent", topology->devices[usb->parent].name);
+        }
+        record_key(&rec, "block_devices");
+        buffer_printf(&rec.buf, "[");
+        for (int b = 0; b < usb->block_count; b++) {
+            if (b) {
+                buffer_printf(&rec.buf, ",");
+            }
+            record_put_string(&rec, topology->blocks[usb->first_block + b].name);
+        }
+        buffer_printf(&rec.buf, "]");
+        record_emit(&rec);
+        usb_count++;
+    }
+    
+    emit_summary_record("usb", usb_count, NULL);
+}
+
+static int usb_overview_compare(const void* a, const void* b) {
+    const struct usb_device_record *x = *(const struct usb_device_record* const*)a;
+    const struct usb_device_record *y = *(const struct usb_device_record* const*)b;
+    if (x->busnum != y->busnum) {
+        return x->busnum < y->busnum ? -1 : 1;
+    }
+    return x->devnum < y->devnum ? -1 : x->devnum > y->devnum;
+}
+
+// One lsusb-style line per device, root hubs included, named from usb.ids
+static void report_usb_overview(const struct usb_topology* topology) {
+    if (topology->count == 0) {
+        return;
+    }
+    const struct usb_device_record **order =
+        (const struct usb_device_record**)malloc(topology->count * sizeof(*order));
+    if (!order) {
+        return;
+    }
+    for (int i = 0; i < topology->count; i++) {
+        order[i] = &topology->devices[i];
+    }
+    qsort(order, topology->count, sizeof(*order), usb_overview_compare);
+    report_printf("USB Device Overview:\n");
+    for (int i = 0; i < topology->count; i++) {
+        char vendor[128] = "", product[128] = "";
+        unsigned vendor_id = usb_id_value(order[i]->vendor_id);
+        unsigned product_id = usb_id_value(order[i]->product_id);
+        usb_ids_vendor_name(vendor_id, vendor, sizeof(vendor));
+        usb_ids_product_name(vendor_id, product_id, product, sizeof(product));
+        report_printf("  Bus %03lld Device %03lld: ID %04x:%04x%s%s%s%s\n", order[i]->busnum, order[i]->devnum,
+                      vendor_id & 0xffff, product_id & 0xffff, vendor[0] ? " " : "", vendor,
+                      product[0] ? " " : "", product);
+    }
+    report_printf("\n");
+    free(order);
+}
+
+void list_all_usb_devices(void) {
+    double scan_span = trace_begin();
+    const struct usb_topology *topology = usb_topology_get();
+    if (!topology) {
+        report_printf("Out of memory while reading the USB topology\n");
+        trace_end("list_all_usb_devices", scan_span, -1);
+        return;
+    }
+    if (output_format != OUTPUT_TEXT) {
+        emit_usb_device_records(topology);
+        trace_end("list_all_usb_devices", scan_span, 0);
+        return;
+    }
+    
+    report_printf("\n=== All Connected USB Devices ===\n");
+    report_usb_overview(topology);
+    
+    // Detailed information for everything below the root hubs
+    report_printf("Detailed USB Device Analysis:\n");
+    if (!topology->valid) {
+        report_printf("Cannot access USB device information\n");
+        trace_end("list_all_usb_devices", scan_span, 0);
+        return;
+    }
+    int usb_count = 0;
+    for (int i = 0; i < topology->count; i++) {
+        const struct usb_device_record *usb = &topology->devices[i];
+        if (!strchr(usb->name, '-')) {
+            continue;
+        }
+        report_printf("\n--- USB Device %s ---\n", usb->name);
+        usb_count++;
+        
+        report_usb_ids(usb);
+        if (usb->present & USB_ATTR_MANUFACTURER) {
+            report_printf("Manufacturer: %s\n", usb->manufacturer);
+        }
+        if (usb->present & USB_ATTR_PRODUCT) {
+            report_printf("Product: %s\n", usb->product);
+        }
+        if (usb->present & USB_ATTR_SPEED) {
+            report_printf("Speed: %s Mbps\n", usb->speed);
+        }
+        if (usb->parent >= 0) {
+            report_printf("Connected to: %s\n", topology->devices[usb->parent].name);
+        }
+        for (int b = 0; b < usb->block_count; b++) {
+            report_printf("%s%s", b ? ", " : "Block devices: ", topology->blocks[usb->first_block + b].name);
+        }
+        if (usb->block_count > 0) {
+            report_printf("\n");
+        }
+        
+        // Analyze if it's a mobile device
+        const char *outer_device = trace_set_device(usb->name);
+        double span = trace_begin();
+        analyze_mobile_device_type(topology, usb);
+        trace_end("analyze_mobile_device_type", span, 0);
+        trace_set_device(outer_device);
+    }
+    
+    if (usb_count == 0) {
+        report_printf("No USB devices found.\n");
+    } else {
+        report_printf("\nTotal USB devices analyzed: %d\n", usb_count);
+    }
+    trace_end("list_all_usb_devices", scan_span, 0);
+}
+
+// Parse and display NVMe security features and reserved spaces
+void show_nvme_security_features(const struct device_profile* profile) {
+    report_printf("\n=== NVMe Security Features & Reserved Spaces ===\n");
+    
+    const struct nvme_ctrl_info *ctrl = &profile->nvme_ctrl;
+    if (!ctrl->valid) {
+        report_printf("NVMe admin commands not available (try running as root)\n");
+        report_printf("Falling back to basic NVMe analysis...\n\n");
+        
+        // Basic info from sysfs
+        if (profile->sysfs_firmware[0]) {
+            report_printf("Firmware Revision: %s\n", profile->sysfs_firmware);
+        }
+        if (profile->model[0]) {
+            report_printf("Model: %s\n", profile->model);
+        }
+        return;
+    }
+    
+    // Show controller info
+    report_printf("NVMe Controller Information:\n");
+    report_printf("  Model: %s\n", ctrl->model);
+    report_printf("  Serial Number: %s\n", ctrl->serial);
+    report_printf("  Firmware Revision: %s\n", ctrl->firmware);
+    report_printf("  PCI Vendor ID: 0x%04x\n", ctrl->vendor_id);
+    report_printf("  oacs: 0x%04x  fna: 0x%02x  sanicap: 0x%08x\n", ctrl->oacs, ctrl->fna, ctrl->sanicap);
+    report_printf("  Firmware Slots: %d%s\n", (ctrl->frmw >> 1) & 0x07,
+           (ctrl->frmw & 0x01) ? " (slot 1 read-only)" : "");
+    report_printf("  Max Namespaces: %u\n", ctrl->nn);
+    
+    // List namespaces
+    report_printf("\nNVMe Namespaces:\n");
+    if (profile->nvme_ns_count > 0) {
+        for (int i = 0; i < profile->nvme_ns_count && i < NVME_MAX_PROFILE_NS; i++) {
+            report_printf("  [%4d]:0x%x\n", i, profile->nvme_namespaces[i].nsid);
+        }
+        if (profile->nvme_ns_count > NVME_MAX_PROFILE_NS) {
+            report_printf("  ... and %d more\n", profile->nvme_ns_count - NVME_MAX_PROFILE_NS);
+        }
+    } else {
+        report_printf("  No additional namespaces found\n");
+    }
+    
+    // Get namespace information
+    report_printf("\nNamespace Details:\n");
+    const struct nvme_ns_info *ns = &profile->nvme_ns;
+    if (ns->valid) {
+        report_printf("  nsid  : %u\n", ns->nsid);
+        report_printf("  nsze  : 0x%llx\n", ns->nsze);
+        report_printf("  ncap  : 0x%llx\n", ns->ncap);
+        report_printf("  nuse  : 0x%llx\n", ns->nuse);
+        report_printf("  dps   : 0x%x\n", ns->dps);
+        for (int i = 0; i <= ns->nlbaf; i++) {
+            report_printf("  lbaf %2d : ms:%-3d lbads:%-2d rp:%d%s\n", i,
+                   ns->lbaf[i].metadata_size, ns->lbaf[i].data_size_shift, ns->lbaf[i].relative_performance,
+                   (ns->flbas & 0x0f) == i ? " (in use)" : "");
+        }
+    } else {
+        report_printf("  Unable to read namespace identify data\n");
+    }
+    
+    // Check for firmware partitions/logs
+    report_printf("\nFirmware Log Analysis:\n");
+    if (profile->nvme_fw_log_valid) {
+        const struct nvme_fw_slot_log *fw_log = &profile->nvme_fw_log;
+        int found_fw = 0;
+        report_printf("  Active firmware slot: %d\n", fw_log->active_slot);
+        if (fw_log->next_slot) {
+            report_printf("  Next reset activates slot: %d\n", fw_log->next_slot);
+        }
+        for (int i = 0; i < 7; i++) {
+            if (fw_log->revision[i][0]) {
+                report_printf("  Slot %d firmware: %s\n", i + 1, fw_log->revision[i]);
+                found_fw = 1;
+            }
+        }
+        if (!found_fw) {
+            report_printf("  No explicit firmware log entries found\n");
+        }
+    } else {
+        report_printf("  Firmware slot log not available\n");
+    }
+    
+    // Check for security capabilities
+    report_printf("\nSecurity Capabilities:\n");
+    report_nvme_security_caps(ctrl, "  ");
+    
+    report_printf("\nNote: Some reserved areas may not be visible without vendor-specific tools.\n");
+}
+
+// Parse and display SATA SSD security features and reserved spaces
+void show_sata_security_features(const struct device_profile* profile) {
+    report_printf("\n=== SATA SSD Security Features & Reserved Spaces ===\n");
+    
+    const struct ata_identify_info *ata = &profile->ata;
+    if (!ata->valid) {
+        report_printf("ATA IDENTIFY not available or device not supported.\n");
+    } else {
+        report_printf("Model: %s\n", ata->model);
+        report_printf("Firmware Revision: %s\n", ata->firmware);
+        
+        report_printf("Security:\n");
+        report_printf("  %s supported\n", ata->security_supported ? "   " : "not");
+        report_ata_security_state(ata, "  ");
+        
+        if (ata->sanitize_supported) {
+            report_printf("Sanitize: supported (crypto scramble: %s, overwrite: %s, block erase: %s)\n",
+                   ata->crypto_scramble_supported ? "yes" : "no",
+                   ata->overwrite_supported ? "yes" : "no",
+                   ata->block_erase_supported ? "yes" : "no");
+        }
+        report_printf("Data Set Management TRIM: %s\n", ata->trim_supported ? "supported" : "not supported");
+        
+        // Show HPA/DCO info
+        if (ata->native_max_valid) {
+            report_printf(" max sectors   = %llu/%llu, HPA is %s\n",
+                   ata->user_max_sectors, ata->native_max_sectors,
+                   ata->native_max_sectors > ata->user_max_sectors ? "enabled" : "disabled");
+        }
+        if (ata->dco_valid) {
+            report_printf("Real max sectors: %llu\n", ata->dco_real_max_sectors);
+        }
+    }
+    report_printf("Note: For more details, use vendor-specific tools or consult SSD documentation.\n");
+}
+
+// Detect firmware reserved spaces for SSDs (NVMe and SATA)
+void check_ssd_firmware_reserved(const struct device_profile* profile) {
+    report_printf("\n=== SSD Firmware Reserved Space Analysis ===\n");
+    
+    // NVMe SSDs
+    if (profile->is_nvme) {
+        const struct nvme_ctrl_info *ctrl = &profile->nvme_ctrl;
+        if (!ctrl->valid) {
+            report_printf("NVMe admin commands not available (try running as root)\n");
+            report_printf("Performing basic NVMe analysis...\n\n");
+            
+            // Device size from sysfs
+            if (profile->sectors >= 0) {
+                double size_gb = (profile->sectors * 512.0) / (1024.0 * 1024.0 * 1024.0);
+                report_printf("Total Capacity: %.2f GB (%lld sectors)\n", size_gb, profile->sectors);
+            }
+            return;
+        }
+        
+        report_printf("Analyzing NVMe device via admin commands...\n");
+        
+        // List NVMe namespaces with their capacity
+        report_printf("Available Namespaces:\n");
+        if (profile->nvme_ns_count > 0) {
+            for (int i = 0; i < profile->nvme_ns_count && i < NVME_MAX_PROFILE_NS; i++) {
+                const struct nvme_ns_summary *ns = &profile->nvme_namespaces[i];
+                report_printf("  Namespace %u: %.2f GB (%llu blocks of %llu bytes)\n", ns->nsid,
+                       (ns->nsze * ns->block_size) / (1024.0 * 1024.0 * 1024.0), ns->nsze, ns->block_size);
+            }
+            if (profile->nvme_ns_count > NVME_MAX_PROFILE_NS) {
+                report_printf("  ... and %d more\n", profile->nvme_ns_count - NVME_MAX_PROFILE_NS);
+            }
+        } else {
+            report_printf("  Default namespace (1) active\n");
+        }
+        
+        // Get capacity information
+        report_printf("\nCapacity Analysis:\n");
+        if (profile->nvme_ns.valid) {
+            report_printf("  nsze    : 0x%llx\n", profile->nvme_ns.nsze);
+            report_printf("  ncap    : 0x%llx\n", profile->nvme_ns.ncap);
+            report_printf("  nuse    : 0x%llx\n", profile->nvme_ns.nuse);
+        }
+        
+        // Check for over-provisioning and firmware areas
+        report_printf("\nFirmware and Reserved Areas:\n");
+        report_printf("  Firmware Revision: %s (%d slots)\n", ctrl->firmware, (ctrl->frmw >> 1) & 0x07);
+        if (ctrl->tnvmcap) {
+            report_printf("  Total NVM Capacity: %.2f GB\n", ctrl->tnvmcap / (1024.0 * 1024.0 * 1024.0));
+            report_printf("  Unallocated NVM Capacity: %.2f GB\n", ctrl->unvmcap / (1024.0 * 1024.0 * 1024.0));
+            if (profile->nvme_allocated_bytes && ctrl->tnvmcap > profile->nvme_allocated_bytes) {
+                unsigned long long unassigned = ctrl->tnvmcap - profile->nvme_allocated_bytes;
+                report_printf("  ⚠️  %.2f GB of NVM capacity is not assigned to any active namespace\n",
+                       unassigned / (1024.0 * 1024.0 * 1024.0));
+            }
+        } else {
+            report_printf("  No explicit firmware reserved areas reported\n");
+        }
+        
+        report_printf("\nNote: NVMe over-provisioning and firmware areas may not be directly visible\n");
+        report_printf("      Some reserved areas require vendor-specific tools to analyze\n");
+        
+    } else {
+        // SATA SSDs
+        report_printf("Analyzing SATA SSD...\n");
+        
+        const struct ata_identify_info *ata = &profile->ata;
+        if (!ata->valid) {
+            report_printf("ATA IDENTIFY not available (try running as root)\n");
+            report_printf("Limited SATA analysis available...\n");
+        } else {
+            report_printf("Firmware Information:\n");
+            report_printf("  Firmware Revision: %s\n", ata->firmware);
+            report_printf("  User Addressable Sectors: %llu\n", ata->user_max_sectors);
+            
+            unsigned long long real_max = ata->user_max_sectors;
+            if (ata->native_max_valid && ata->native_max_sectors > real_max) {
+                real_max = ata->native_max_sectors;
+            }
+            if (ata->dco_valid && ata->dco_real_max_sectors > real_max) {
+                real_max = ata->dco_real_max_sectors;
+            }
+            if (real_max > ata->user_max_sectors) {
+                unsigned long long reserved = real_max - ata->user_max_sectors;
+                report_printf("  Reserved (HPA/DCO) Sectors: %llu (%.2f GB)\n",
+                       reserved, (reserved * 512.0) / (1024.0 * 1024.0 * 1024.0));
+            } else {
+                report_printf("  No explicit firmware reserved info found\n");
+            }
+        }
+        
+        report_printf("Note: SATA SSD firmware areas require vendor-specific tools for detailed analysis\n");
+    }
+}
+
+// Request queue limits that decide which --sanitize methods the device can offload
+static void report_discard_capabilities(const struct device_profile* profile) {
+    if (profile->discard_max_bytes < 0 && profile->write_zeroes_max_bytes < 0) {
+        return;
+    }
+    report_printf("Discard / Zero-Out Capabilities:\n");
+    if (profile->discard_max_bytes > 0) {
+        report_printf("  Discard (BLKDISCARD): supported, up to %lld bytes per request, %lld-byte granularity\n",
+               profile->discard_max_bytes, profile->discard_granularity);
+        // The queue limits do not say whether the device can erase securely
+        report_printf("  Secure Discard (BLKSECDISCARD): not reported by sysfs, probed by --sanitize\n");
+    } else if (profile->discard_max_bytes == 0) {
+        report_printf("  Discard (BLKDISCARD): not supported\n");
+        report_printf("  Secure Discard (BLKSECDISCARD): not supported\n");
+    }
+    if (profile->write_zeroes_max_bytes > 0) {
+        report_printf("  Write Zeroes (BLKZEROOUT): offloaded, up to %lld bytes per request\n",
+               profile->write_zeroes_max_bytes);
+    } else if (profile->write_zeroes_max_bytes == 0) {
+        report_printf("  Write Zeroes (BLKZEROOUT): not offloaded, the kernel writes zero pages\n");
+    }
+}
+
+// Print the full report of a probed device
+void report_device_profile(const struct device_profile* profile) {
+    report_printf("=== Storage Device Information for %s ===\n", profile->dev_path);
+    
+    // Check if device is rotational (HDD vs SSD)
+    if (profile->rotational >= 0) {
+        report_printf("Device Type: %s\n", (profile->rotational == 1) ? "HDD (Rotational)" : "SSD/Flash (Non-rotational)");
+    }
+    if (profile->model[0]) {
+        report_printf("Model: %s\n", profile->model);
+    }
+    if (profile->vendor[0]) {
+        report_printf("Vendor: %s\n", profile->vendor);
+    }
+    if (profile->serial[0]) {
+        report_printf("Serial: %s\n", profile->serial);
+    }
+    if (profile->sectors >= 0) {
+        double size_gb = (profile->sectors * 512.0) / (1024.0 * 1024.0 * 1024.0);
+        report_printf("Size: %.2f GB\n", size_gb);
+    }
+    if (profile->physical_block_size >= 0) {
+        report_printf("Physical Block Size: %d bytes\n", profile->physical_block_size);
+    }
+    if (profile->logical_block_size >= 0) {
+        report_printf("Logical Block Size: %d bytes\n", profile->logical_block_size);
+    }
+    
+    switch (profile->interface) {
+        case IFACE_NVME: report_printf("Interface: NVMe\n"); break;
+        case IFACE_SATA: report_printf("Interface: SATA\n"); break;
+        case IFACE_USB:
+            report_printf("Interface: USB\n");
+            report_printf("🔌 USB Device Detected - Performing detailed analysis...\n");
+            break;
+        case IFACE_MMC: report_printf("Interface: MMC/SD\n"); break;
+        case IFACE_VIRTIO: report_printf("Interface: VirtIO (Virtual)\n"); break;
+        default: break;
+    }
+    
+    if (profile->removable >= 0) {
+        report_printf("Removable: %s\n", (profile->removable == 1) ? "Yes" : "No");
+    }
+    if (profile->read_only >= 0) {
+        report_printf("Read-Only: %s\n", (profile->read_only == 1) ? "Yes" : "No");
+    }
+    if (profile->from_cache) {
+        report_printf("Identify Data: inventory cache (use --refresh to re-probe)\n");
+    }
+    report_discard_capabilities(profile);
+    
+    const char *outer_device = trace_set_device(profile->name);
+    double span;
+    // If it's a USB device, perform detailed USB analysis
+    if (profile->link_valid && strstr(profile->sysfs_link, "usb")) {
+        span = trace_begin();
+        analyze_usb_device_details(profile);
+        trace_end("analyze_usb_device_details", span, 0);
+    }
+    
+    // Add HPA/DCO, SMART, and firmware reserved checks
+    report_printf("\n");
+    span = trace_begin();
+    check_hpa_dco_linux(profile);
+    trace_end("check_hpa_dco_linux", span, 0);
+    span = trace_begin();
+    check_smart_info_linux(profile);
+    trace_end("check_smart_info_linux", span, 0);
+    span = trace_begin();
+    check_ssd_firmware_reserved(profile);
+    trace_end("check_ssd_firmware_reserved", span, 0);
+    
+    // Show advanced security features and reserved spaces
+    span = trace_begin();
+    if (profile->is_nvme) {
+        show_nvme_security_features(profile);
+        trace_end("show_nvme_security_features", span, 0);
+    } else {
+        show_sata_security_features(profile);
+        trace_end("show_sata_security_features", span, 0);
+    }
+    trace_set_device(outer_device);
+}
+
+static const char* device_interface_name(enum device_interface interface) {
+    switch (interface) {
+        case IFACE_NVME: return "nvme";
+        case IFACE_SATA: return "sata";
+        case IFACE_USB: return "usb";
+        case IFACE_MMC: return "mmc";
+        case IFACE_VIRTIO: return "virtio";
+        default: return "unknown";
+    }
+}
+
+// Structured counterpart of report_device_profile(): one "device" record
+void emit_device_record(const struct device_profile* profile) {
+    struct record rec;
+    record_begin(&rec, "device");
+    record_string(&rec, "name", profile->name);
+    record_string(&rec, "path", profile->dev_path);
+    record_string(&rec, "interface", device_interface_name(profile->interface));
+    record_bool(&rec, "usb", profile->link_valid && strstr(profile->sysfs_link, "usb") != NULL);
+    record_string(&rec, "usb_device_path", profile->usb_device_path);
+    record_string(&rec, "model", profile->model);
+    record_string(&rec, "vendor", profile->vendor);
+    record_string(&rec, "serial", profile->serial);
+    record_string(&rec, "firmware", profile->sysfs_firmware);
+    if (profile->rotational >= 0) {
+        record_bool(&rec, "rotational", profile->rotational == 1);
+    }
+    if (profile->sectors >= 0) {
+        record_int(&rec, "size_bytes", profile->sectors * 512);
+    }
+    record_known(&rec, "physical_block_size", profile->physical_block_size);
+    record_known(&rec, "logical_block_size", profile->logical_block_size);
+    if (profile->removable >= 0) {
+        record_bool(&rec, "removable", profile->removable == 1);
+    }
+    if (profile->read_only >= 0) {
+        record_bool(&rec, "read_only", profile->read_only == 1);
+    }
+    if (profile->discard_max_bytes >= 0 || profile->write_zeroes_max_bytes >= 0) {
+        record_object_begin(&rec, "discard");
+        record_known(&rec, "max_bytes", profile->discard_max_bytes);
+        record_known(&rec, "granularity", profile->discard_granularity);
+        record_known(&rec, "write_zeroes_max_bytes", profile->write_zeroes_max_bytes);
+        record_object_end(&rec);
+    }
+    const struct scsi_block_limits *scsi = &profile->scsi;
+    if (scsi->valid) {
+        record_object_begin(&rec, "scsi");
+        record_uint(&rec, "blocks", scsi->blocks);
+        record_uint(&rec, "block_size", scsi->block_size);
+        record_bool(&rec, "thin_provisioned", scsi->lbpme);
+        record_bool(&rec, "unmapped_reads_zero", scsi->lbprz);
+        if (scsi->block_limits_valid) {
+            record_uint(&rec, "max_transfer_blocks", scsi->max_transfer_blocks);
+            record_uint(&rec, "max_write_same_blocks", scsi->max_write_same_blocks);
+            record_uint(&rec, "max_unmap_blocks", scsi->max_unmap_blocks);
+            record_uint(&rec, "max_unmap_descriptors", scsi->max_unmap_descriptors);
+            record_uint(&rec, "unmap_granularity", scsi->unmap_granularity);
+        }
+        if (scsi->provisioning_valid) {
+            record_bool(&rec, "unmap", scsi->lbpu);
+            record_bool(&rec, "write_same_unmap", scsi->lbpws);
+        }
+        record_object_end(&rec);
+    }
+    record_bool(&rec, "opened", !profile->open_failed);
+    record_string(&rec, "identify_source", profile->from_cache ? "cache" : "device");
+    
+    const struct ata_identify_info *ata = &profile->ata;
+    if (ata->valid) {
+        record_object_begin(&rec, "ata");
+        record_string(&rec, "model", ata->model);
+        record_string(&rec, "serial", ata->serial);
+        record_string(&rec, "firmware", ata->firmware);
+        record_bool(&rec, "lba48", ata->lba48);
+        record_uint(&rec, "user_max_sectors", ata->user_max_sectors);
+        record_bool(&rec, "hpa_supported", ata->hpa_supported);
+        record_bool(&rec, "hpa_enabled", ata->hpa_enabled);
+        if (ata->native_max_valid) {
+            record_uint(&rec, "native_max_sectors", ata->native_max_sectors);
+        }
+        record_bool(&rec, "dco_supported", ata->dco_supported);
+        if (ata->dco_valid) {
+            record_uint(&rec, "dco_real_max_sectors", ata->dco_real_max_sectors);
+        }
+        record_object_begin(&rec, "security");
+        record_bool(&rec, "supported", ata->security_supported);
+        record_bool(&rec, "enabled", ata->security_enabled);
+        record_bool(&rec, "locked", ata->security_locked);
+        record_bool(&rec, "frozen", ata->security_frozen);
+        record_bool(&rec, "enhanced_erase", ata->enhanced_erase_supported);
+        record_known(&rec, "erase_minutes", ata->erase_time_minutes);
+        record_known(&rec, "enhanced_erase_minutes", ata->enhanced_erase_time_minutes);
+        record_object_end(&rec);
+        record_object_begin(&rec, "sanitize");
+        record_bool(&rec, "supported", ata->sanitize_supported);
+        record_bool(&rec, "crypto_scramble", ata->crypto_scramble_supported);
+        record_bool(&rec, "overwrite", ata->overwrite_supported);
+        record_bool(&rec, "block_erase", ata->block_erase_supported);
+        record_object_end(&rec);
+        record_bool(&rec, "trim", ata->trim_supported);
+        record_object_end(&rec);
+    }
+    
+    const struct nvme_ctrl_info *ctrl = &profile->nvme_ctrl;
+    if (profile->is_nvme && ctrl->valid) {
+        record_object_begin(&rec, "nvme");
+        char vendor_id[8];
+        snprintf(vendor_id, sizeof(vendor_id), "%04x", ctrl->vendor_id);
+        record_string(&rec, "vendor_id", vendor_id);
+        record_string(&rec, "model", ctrl->model);
+        record_string(&rec, "serial", ctrl->serial);
+        record_string(&rec, "firmware", ctrl->firmware);
+        record_uint(&rec, "total_capacity_bytes", ctrl->tnvmcap);
+        record_uint(&rec, "unallocated_capacity_bytes", ctrl->unvmcap);
+        record_uint(&rec, "namespace_limit", ctrl->nn);
+        record_known(&rec, "active_namespaces", profile->nvme_ns_count);
+        if (profile->nvme_nsid) {
+            record_uint(&rec, "nsid", profile->nvme_nsid);
+        }
+        record_object_begin(&rec, "sanitize");
+        record_bool(&rec, "crypto_erase", ctrl->sanicap & 0x1);
+        record_bool(&rec, "block_erase", (ctrl->sanicap >> 1) & 0x1);
+        record_bool(&rec, "overwrite", (ctrl->sanicap >> 2) & 0x1);
+        record_object_end(&rec);
+        record_bool(&rec, "format", ctrl->oacs & 0x2);
+        record_bool(&rec, "security_send_receive", ctrl->oacs & 0x1);
+        record_object_end(&rec);
+    }
+    
+    const struct smart_health_info *smart = &profile->smart;
+    if (smart->valid) {
+        record_object_begin(&rec, "smart");
+        if (smart->passed >= 0) {
+            record_bool(&rec, "passed", smart->passed);
+        }
+        record_known(&rec, "temperature_c", smart->temperature_c);
+        record_known(&rec, "power_on_hours", smart->power_on_hours);
+        if (smart->is_nvme) {
+            record_known(&rec, "critical_warning", smart->critical_warning);
+            record_known(&rec, "available_spare", smart->available_spare);
+            record_known(&rec, "percentage_used", smart->percentage_used);
+            record_known(&rec, "media_errors", smart->media_errors);
+            record_known(&rec, "unsafe_shutdowns", smart->unsafe_shutdowns);
+        } else {
+            record_known(&rec, "reallocated_sectors", smart->reallocated_sectors);
+            record_known(&rec, "pending_sectors", smart->pending_sectors);
+            record_known(&rec, "offline_uncorrectable", smart->offline_uncorrectable);
+        }
+        record_object_end(&rec);
+    } else if (profile->smartctl_available && profile->smartctl_status[0]) {
+        record_object_begin(&rec, "smart");
+        record_string(&rec, "smartctl", profile->smartctl_status);
+        record_object_end(&rec);
+    }
+    
+    record_emit(&rec);
+}
+
+void get_device_info_linux(const char* device) {
+    struct device_profile *profile = (struct device_profile*)malloc(sizeof(struct device_profile));
+    if (!profile) {
+        report_printf("Out of memory while probing /dev/%s\n", device);
+        return;
+    }
+    const char *outer_device = trace_set_device(device);
+    double span = trace_begin();
+    probe_device_profile(device, profile);
+    if (output_format != OUTPUT_TEXT) {
+        emit_device_record(profile);
+    } else {
+        report_device_profile(profile);
+    }
+    trace_end("get_device_info_linux", span, profile->open_failed);
+    trace_set_device(outer_device);
+    free(profile);
+}
+
+void get_device_info_windows() {
+#ifdef _WIN32
+    printf("=== Storage Device Information (Windows) ===\n");
+    
+    // Simple approach using basic Windows APIs
+    printf("Detecting storage devices...\n");
+    
+    // Try to get basic drive information
+    for (char drive = 'C'; drive <= 'Z'; drive++) {
+        char drive_path[4] = {drive, ':', '\\', '\0'};
+        UINT drive_type = GetDriveTypeA(drive_path);
+        
+        if (drive_type != DRIVE_NO_ROOT_DIR) {
+            printf("\nDrive %c:\\\n", drive);
+            
+            switch (drive_type) {
+                case DRIVE_FIXED:
+                    printf("  Type: Fixed Drive (HDD/SSD)\n");
+                    break;
+                case DRIVE_REMOVABLE:
+                    printf("  Type: Removable Drive\n");
+                    break;
+                case DRIVE_CDROM:
+                    printf("  Type: CD-ROM/DVD\n");
+                    break;
+                case DRIVE_RAMDISK:
+                    printf("  Type: RAM Disk\n");
+                    break;
+                case DRIVE_REMOTE:
+                    printf("  Type: Network Drive\n");
+                    break;
+                default:
+                    printf("  Type: Unknown\n");
+            }
             
-            char usb_device_path[512];
-            snprintf(usb_device_path, sizeof(usb_device_path), "/sys/bus/usb/devices/%s", entry->d_name);
+            // Get disk space information
+            ULARGE_INTEGER free_bytes, total_bytes;
+            if (GetDiskFreeSpaceExA(drive_path, &free_bytes, &total_bytes, NULL)) {
+                double total_gb = total_bytes.QuadPart / (1024.0 * 1024.0 * 1024.0);
+                double free_gb = free_bytes.QuadPart / (1024.0 * 1024.0 * 1024.0);
+                printf("  Size: %.2f GB (%.2f GB free)\n", total_gb, free_gb);
+            }
+        }
+    }
+    
+    printf("\nNote: For detailed hardware information on Windows, run 'wmic diskdrive list full' in Command Prompt\n");
+#else
+    printf("Windows-specific function called on non-Windows platform\n");
+#endif
+}
+
+#ifndef _WIN32
+// Shared state of a parallel device scan. Workers claim devices in order and
+// render each report into its own buffer; the main thread prints the buffers
+// in the original /sys/block order as soon as they are complete.
+struct device_scan {
+    char (*devices)[256];
+    struct report_buffer *reports;
+    int *done;
+    int count;
+    int next;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+};
+
+// Probe and render the full report of one device, including its "Device:" header line
+static void report_device(const char* device) {
+    struct device_profile *profile = (struct device_profile*)malloc(sizeof(struct device_profile));
+    if (!profile) {
+        report_printf("Device: %s\nOut of memory while probing /dev/%s\n\n", device, device);
+        return;
+    }
+    const char *outer_device = trace_set_device(device);
+    double span = trace_begin();
+    probe_device_profile(device, profile);
+    
+    if (output_format != OUTPUT_TEXT) {
+        emit_device_record(profile);
+    } else {
+        report_printf("Device: %s", device);
+        if (profile->link_valid && strstr(profile->sysfs_link, "usb")) {
+            report_printf(" [USB Device]");
+        }
+        report_printf("\n");
+        
+        report_device_profile(profile);
+        report_printf("\n");
+    }
+    trace_end("report_device", span, profile->open_failed);
+    trace_set_device(outer_device);
+    free(profile);
+}
+
+static void* device_scan_worker(void* arg) {
+    struct device_scan *scan = (struct device_scan*)arg;
+    
+    while (1) {
+        int index = __atomic_fetch_add(&scan->next, 1, __ATOMIC_RELAXED);
+        if (index >= scan->count) {
+            break;
+        }
+        
+        current_report = &scan->reports[index];
+        report_device(scan->devices[index]);
+        current_report = NULL;
+        
+        pthread_mutex_lock(&scan->lock);
+        scan->done[index] = 1;
+        pthread_cond_broadcast(&scan->ready);
+        pthread_mutex_unlock(&scan->lock);
+    }
+    return NULL;
+}
+
+// Probe all devices with a pool of worker threads and print the reports in order
+static void scan_devices_parallel(char (*devices)[256], int count, int jobs) {
+    struct device_scan scan;
+    scan.devices = devices;
+    scan.count = count;
+    scan.next = 0;
+    scan.reports = (struct report_buffer*)calloc(count, sizeof(struct report_buffer));
+    scan.done = (int*)calloc(count, sizeof(int));
+    if (!scan.reports || !scan.done) {
+        free(scan.reports);
+        free(scan.done);
+        for (int i = 0; i < count; i++) {
+            report_device(devices[i]);
+        }
+        return;
+    }
+    pthread_mutex_init(&scan.lock, NULL);
+    pthread_cond_init(&scan.ready, NULL);
+    
+    if (jobs <= 0 || jobs > count) {
+        jobs = count;
+    }
+    pthread_t *workers = (pthread_t*)calloc(jobs, sizeof(pthread_t));
+    int started = 0;
+    if (workers) {
+        for (int i = 0; i < jobs; i++) {
+            if (pthread_create(&workers[started], NULL, device_scan_worker, &scan) == 0) {
+                started++;
+            }
+        }
+    }
+    if (started == 0) {
+        // No threads available, probe everything from this thread instead
+        device_scan_worker(&scan);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        pthread_mutex_lock(&scan.lock);
+        while (!scan.done[i]) {
+            pthread_cond_wait(&scan.ready, &scan.lock);
+        }
+        pthread_mutex_unlock(&scan.lock);
+        
+        if (scan.reports[i].len > 0) {
+            fwrite(scan.reports[i].data, 1, scan.reports[i].len, stdout);
+            fflush(stdout);
+        }
+        free(scan.reports[i].data);
+    }
+    
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    pthread_cond_destroy(&scan.ready);
+    pthread_mutex_destroy(&scan.lock);
+    free(scan.reports);
+    free(scan.done);
+}
+#endif
+
+#ifndef _WIN32
+// Whole disks worth reporting: skip loop, ram and device-mapper nodes.
+// blocks_fd is the open /sys/block directory.
+static int is_scannable_block_device(int blocks_fd, const char* name) {
+    if (name[0] == '.' || strncmp(name, "loop", 4) == 0 || 
+        strncmp(name, "ram", 3) == 0 || strncmp(name, "dm-", 3) == 0) {
+        return 0;
+    }
+    
+    // Check if it's a real block device
+    char path[512];
+    snprintf(path, sizeof(path), "%s/size", name);
+    return sysfs_attr_exists(blocks_fd, path);
+}
+
+// Names of all scannable devices in /sys/block order, -1 if it cannot be read
+static int collect_block_devices(char (**devices_out)[256]) {
+    int blocks_fd = sysfs_open_dir("block");
+    DIR *dir = blocks_fd >= 0 ? fdopendir(blocks_fd) : NULL;
+    if (!dir) {
+        if (blocks_fd >= 0) {
+            close(blocks_fd);
+        }
+        return -1;
+    }
+    
+    struct dirent *entry;
+    char (*devices)[256] = NULL;
+    int device_count = 0;
+    int device_cap = 0;
+    
+    while ((entry = readdir(dir)) != NULL) {
+        if (!is_scannable_block_device(blocks_fd, entry->d_name)) {
+            continue;
+        }
+        if (device_count == device_cap) {
+            int new_cap = device_cap ? device_cap * 2 : 16;
+            char (*grown)[256] = (char (*)[256])realloc(devices, new_cap * sizeof(*devices));
+            if (!grown) {
+                break;
+            }
+            devices = grown;
+            device_cap = new_cap;
+        }
+        snprintf(devices[device_count], sizeof(devices[device_count]), "%s", entry->d_name);
+        device_count++;
+    }
+    closedir(dir);
+    
+    *devices_out = devices;
+    return device_count;
+}
+#endif
+
+void list_available_devices() {
+#ifdef _WIN32
+    get_device_info_windows();
+#else
+    double span = trace_begin();
+    char (*devices)[256] = NULL;
+    int device_count = collect_block_devices(&devices);
+    trace_end("collect_block_devices", span, device_count);
+    if (output_format != OUTPUT_TEXT) {
+        if (device_count >= 0) {
+            scan_devices_parallel(devices, device_count, scan_jobs);
+            free(devices);
+            emit_summary_record("devices", device_count, NULL);
+        } else {
+            emit_summary_record("devices", 0, "cannot access /sys/block");
+        }
+        trace_end("list_available_devices", span, device_count);
+        return;
+    }
+    
+    printf("=== Available Storage Devices ===\n");
+    if (device_count >= 0) {
+        if (scan_jobs == 1 || device_count <= 1) {
+            for (int i = 0; i < device_count; i++) {
+                report_device(devices[i]);
+            }
+        } else {
+            scan_devices_parallel(devices, device_count, scan_jobs);
+        }
+        free(devices);
+        
+        if (device_count == 0) {
+            printf("No storage devices found. Try running with sudo for better detection.\n");
+        } else {
+            printf("Total devices found: %d\n", device_count);
+        }
+        
+        printf("\nTip: If you plug in a USB device, run this program again to detect it.\n");
+        printf("     USB devices typically appear as sdb, sdc, etc. or as sd* devices.\n");
+    } else {
+        printf("Cannot access /sys/block directory\n");
+    }
+    trace_end("list_available_devices", span, device_count);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Random pattern generator (seekable ChaCha8 keystream)
+// ---------------------------------------------------------------------------
+
+// The random pass pattern is the ChaCha keystream for a 256-bit seed, with the
+// 64-byte block counter derived from the device offset. Any range of the
+// pattern can be produced on its own, so writers fill buffers independently
+// and verification regenerates the expected data instead of storing it.
+// Eight rounds are plenty for overwrite data and keep the generator far ahead
+// of the disks.
+#define CHACHA_ROUNDS       8
+#define CHACHA_BLOCK_SIZE   64
+
+struct pattern_key {
+    uint32_t key[8];
+    uint64_t stream;                    // ChaCha nonce, separates passes with the same seed
+};
+
+#define CHACHA_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define CHACHA_QUARTER(a, b, c, d) \
+    a += b; d ^= a; d = CHACHA_ROTL(d, 16); \
+    c += d; b ^= c; b = CHACHA_ROTL(b, 12); \
+    a += b; d ^= a; d = CHACHA_ROTL(d, 8); \
+    c += d; b ^= c; b = CHACHA_ROTL(b, 7);
+
+static void chacha_init_state(const struct pattern_key* key, uint64_t counter, uint32_t state[16]) {
+    state[0] = 0x61707865;              // "expand 32-byte k"
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    memcpy(&state[4], key->key, sizeof(key->key));
+    state[12] = (uint32_t)counter;
+    state[13] = (uint32_t)(counter >> 32);
+    state[14] = (uint32_t)key->stream;
+    state[15] = (uint32_t)(key->stream >> 32);
+}
+
+static void chacha_blocks_scalar(const struct pattern_key* key, uint64_t counter, unsigned char* out, size_t blocks) {
+    for (size_t n = 0; n < blocks; n++, out += CHACHA_BLOCK_SIZE) {
+        uint32_t input[16];
+        uint32_t x[16];
+        chacha_init_state(key, counter + n, input);
+        memcpy(x, input, sizeof(x));
+        for (int i = 0; i < CHACHA_ROUNDS; i += 2) {
+            CHACHA_QUARTER(x[0], x[4], x[8], x[12]);
+            CHACHA_QUARTER(x[1], x[5], x[9], x[13]);
+            CHACHA_QUARTER(x[2], x[6], x[10], x[14]);
+            CHACHA_QUARTER(x[3], x[7], x[11], x[15]);
+            CHACHA_QUARTER(x[0], x[5], x[10], x[15]);
+            CHACHA_QUARTER(x[1], x[6], x[11], x[12]);
+            CHACHA_QUARTER(x[2], x[7], x[8], x[13]);
+            CHACHA_QUARTER(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; i++) {
+            uint32_t v = x[i] + input[i];
+            out[i * 4] = (unsigned char)v;
+            out[i * 4 + 1] = (unsigned char)(v >> 8);
+            out[i * 4 + 2] = (unsigned char)(v >> 16);
+            out[i * 4 + 3] = (unsigned char)(v >> 24);
+        }
+    }
+}
+
+#ifdef PATTERN_HAVE_X86_SIMD
+// Eight blocks at a time, one block per 32-bit lane, transposed back to
+// consecutive 64-byte blocks on store
+__attribute__((target("avx2")))
+static inline __m256i chacha_rotl_avx2(__m256i v, int n) {
+    return _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - n));
+}
+
+#define CHACHA_QUARTER_AVX2(a, b, c, d) \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16); \
+    c = _mm256_add_epi32(c, d); b = chacha_rotl_avx2(_mm256_xor_si256(b, c), 12); \
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8); \
+    c = _mm256_add_epi32(c, d); b = chacha_rotl_avx2(_mm256_xor_si256(b, c), 7);
+
+// Store words first..first+7 of the eight lane blocks to their place in out
+__attribute__((target("avx2")))
+static inline void chacha_store_avx2(const __m256i* w, unsigned char* out) {
+    __m256i t0 = _mm256_unpacklo_epi32(w[0], w[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(w[0], w[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(w[2], w[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(w[2], w[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(w[4], w[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(w[4], w[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(w[6], w[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(w[6], w[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    _mm256_storeu_si256((__m256i*)(out + 0 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u0, u4, 0x20));
+    _mm256_storeu_si256((__m256i*)(out + 1 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u1, u5, 0x20));
+    _mm256_storeu_si256((__m256i*)(out + 2 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u2, u6, 0x20));
+    _mm256_storeu_si256((__m256i*)(out + 3 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u3, u7, 0x20));
+    _mm256_storeu_si256((__m256i*)(out + 4 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u0, u4, 0x31));
+    _mm256_storeu_si256((__m256i*)(out + 5 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u1, u5, 0x31));
+    _mm256_storeu_si256((__m256i*)(out + 6 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u2, u6, 0x31));
+    _mm256_storeu_si256((__m256i*)(out + 7 * CHACHA_BLOCK_SIZE), _mm256_permute2x128_si256(u3, u7, 0x31));
+}
+
+__attribute__((target("avx2")))
+static void chacha_blocks_avx2(const struct pattern_key* key, uint64_t counter, unsigned char* out, size_t blocks) {
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                          3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    uint32_t state[16];
+    chacha_init_state(key, 0, state);
+    __m256i input[16];
+    for (int i = 0; i < 16; i++) {
+        input[i] = _mm256_set1_epi32((int)state[i]);
+    }
+    
+    while (blocks >= 8) {
+        // 64-bit counters of the eight lanes, split into low and high words
+        uint32_t lo[8];
+        uint32_t hi[8];
+        for (int i = 0; i < 8; i++) {
+            lo[i] = (uint32_t)(counter + i);
+            hi[i] = (uint32_t)((counter + i) >> 32);
+        }
+        input[12] = _mm256_loadu_si256((const __m256i*)lo);
+        input[13] = _mm256_loadu_si256((const __m256i*)hi);
+        
+        __m256i x[16];
+        for (int i = 0; i < 16; i++) {
+            x[i] = input[i];
+        }
+        for (int i = 0; i < CHACHA_ROUNDS; i += 2) {
+            CHACHA_QUARTER_AVX2(x[0], x[4], x[8], x[12]);
+            CHACHA_QUARTER_AVX2(x[1], x[5], x[9], x[13]);
+            CHACHA_QUARTER_AVX2(x[2], x[6], x[10], x[14]);
+            CHACHA_QUARTER_AVX2(x[3], x[7], x[11], x[15]);
+            CHACHA_QUARTER_AVX2(x[0], x[5], x[10], x[15]);
+            CHACHA_QUARTER_AVX2(x[1], x[6], x[11], x[12]);
+            CHACHA_QUARTER_AVX2(x[2], x[7], x[8], x[13]);
+            CHACHA_QUARTER_AVX2(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; i++) {
+            x[i] = _mm256_add_epi32(x[i], input[i]);
+        }
+        chacha_store_avx2(&x[0], out);
+        chacha_store_avx2(&x[8], out + 32);
+        
+        counter += 8;
+        out += 8 * CHACHA_BLOCK_SIZE;
+        blocks -= 8;
+    }
+    chacha_blocks_scalar(key, counter, out, blocks);
+}
+#endif
+
+#ifdef PATTERN_HAVE_X86_SIMD
+// Sixteen lanes with native rotates; each 256-bit half is stored like the AVX2 path.
+// GCC 12 reports its own AVX-512 intrinsics as maybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#define CHACHA_QUARTER_AVX512(a, b, c, d) \
+    a = _mm512_add_epi32(a, b); d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 16); \
+    c = _mm512_add_epi32(c, d); b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 12); \
+    a = _mm512_add_epi32(a, b); d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 8); \
+    c = _mm512_add_epi32(c, d); b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 7);
+
+__attribute__((target("avx512f")))
+static void chacha_blocks_avx512(const struct pattern_key* key, uint64_t counter, unsigned char* out, size_t blocks) {
+    uint32_t state[16];
+    chacha_init_state(key, 0, state);
+    __m512i input[16];
+    for (int i = 0; i < 16; i++) {
+        input[i] = _mm512_set1_epi32((int)state[i]);
+    }
+    const __m512i lane = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    
+    while (blocks >= 16) {
+        // 64-bit counters of the sixteen lanes, split into low and high words
+        __m512i c0 = _mm512_add_epi64(_mm512_set1_epi64((long long)counter), lane);
+        __m512i c1 = _mm512_add_epi64(c0, _mm512_set1_epi64(8));
+        input[12] = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(c0)), _mm512_cvtepi64_epi32(c1), 1);
+        input[13] = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(_mm512_srli_epi64(c0, 32))),
+                                       _mm512_cvtepi64_epi32(_mm512_srli_epi64(c1, 32)), 1);
+        
+        __m512i x[16];
+        for (int i = 0; i < 16; i++) {
+            x[i] = input[i];
+        }
+        for (int i = 0; i < CHACHA_ROUNDS; i += 2) {
+            CHACHA_QUARTER_AVX512(x[0], x[4], x[8], x[12]);
+            CHACHA_QUARTER_AVX512(x[1], x[5], x[9], x[13]);
+            CHACHA_QUARTER_AVX512(x[2], x[6], x[10], x[14]);
+            CHACHA_QUARTER_AVX512(x[3], x[7], x[11], x[15]);
+            CHACHA_QUARTER_AVX512(x[0], x[5], x[10], x[15]);
+            CHACHA_QUARTER_AVX512(x[1], x[6], x[11], x[12]);
+            CHACHA_QUARTER_AVX512(x[2], x[7], x[8], x[13]);
+            CHACHA_QUARTER_AVX512(x[3], x[4], x[9], x[14]);
+        }
+        __m256i low[16];
+        __m256i high[16];
+        for (int i = 0; i < 16; i++) {
+            x[i] = _mm512_add_epi32(x[i], input[i]);
+            low[i] = _mm512_castsi512_si256(x[i]);
+            high[i] = _mm512_extracti64x4_epi64(x[i], 1);
+        }
+        chacha_store_avx2(&low[0], out);
+        chacha_store_avx2(&low[8], out + 32);
+        chacha_store_avx2(&high[0], out + 8 * CHACHA_BLOCK_SIZE);
+        chacha_store_avx2(&high[8], out + 8 * CHACHA_BLOCK_SIZE + 32);
+        
+        counter += 16;
+        out += 16 * CHACHA_BLOCK_SIZE;
+        blocks -= 16;
+    }
+    chacha_blocks_avx2(key, counter, out, blocks);
+}
+#pragma GCC diagnostic pop
+#endif
+
+// Verification kernels: length of the prefix of data equal to expected / to a repeated byte
+static size_t compare_bytes_scalar(const unsigned char* data, const unsigned char* expected, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, data + i, 8);
+        memcpy(&b, expected + i, 8);
+        if (a != b) {
+            break;
+        }
+    }
+    for (; i < len; i++) {
+        if (data[i] != expected[i]) {
+            return i;
+        }
+    }
+    return len;
+}
+
+static size_t compare_fill_scalar(const unsigned char* data, unsigned char value, size_t len) {
+    uint64_t pattern = 0x0101010101010101ULL * value;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a;
+        memcpy(&a, data + i, 8);
+        if (a != pattern) {
+            break;
+        }
+    }
+    for (; i < len; i++) {
+        if (data[i] != value) {
+            return i;
+        }
+    }
+    return len;
+}
+
+#ifdef PATTERN_HAVE_X86_SIMD
+// 64 bytes per step; the scalar kernel pins down the exact mismatch
+__attribute__((target("avx2")))
+static size_t compare_bytes_avx2(const unsigned char* data, const unsigned char* expected, size_t len) {
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)),
+                                       _mm256_loadu_si256((const __m256i*)(expected + i)));
+        __m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + 32)),
+                                       _mm256_loadu_si256((const __m256i*)(expected + i + 32)));
+        if (_mm256_movemask_epi8(_mm256_and_si256(e0, e1)) != -1) {
+            break;
+        }
+    }
+    return i + compare_bytes_scalar(data + i, expected + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t compare_fill_avx2(const unsigned char* data, unsigned char value, size_t len) {
+    const __m256i pattern = _mm256_set1_epi8((char)value);
+    size_t i = 0;
+    for (; i + 128 <= len; i += 128) {
+        __m256i diff = _mm256_or_si256(
+            _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i)), pattern),
+                            _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i + 32)), pattern)),
+            _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i + 64)), pattern),
+                            _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(data + i + 96)), pattern)));
+        if (!_mm256_testz_si256(diff, diff)) {
+            break;
+        }
+    }
+    return i + compare_fill_scalar(data + i, value, len - i);
+}
+#endif
+
+static size_t (*compare_bytes)(const unsigned char*, const unsigned char*, size_t) = compare_bytes_scalar;
+static size_t (*compare_fill)(const unsigned char*, unsigned char, size_t) = compare_fill_scalar;
+
+static void (*chacha_blocks)(const struct pattern_key*, uint64_t, unsigned char*, size_t) = chacha_blocks_scalar;
+static const char *pattern_engine = "scalar";
+
+// Pick the widest keystream and compare implementations the CPU supports
+static void pattern_dispatch_init(void) {
+#ifdef PATTERN_HAVE_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        compare_bytes = compare_bytes_avx2;
+        compare_fill = compare_fill_avx2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        chacha_blocks = chacha_blocks_avx512;
+        pattern_engine = "avx512";
+    } else if (__builtin_cpu_supports("avx2")) {
+        chacha_blocks = chacha_blocks_avx2;
+        pattern_engine = "avx2";
+    }
+#endif
+}
+
+// Fill buf with the pattern bytes that belong at device offset
+static void pattern_fill(const struct pattern_key* key, unsigned long long offset, unsigned char* buf, size_t len) {
+    unsigned char block[CHACHA_BLOCK_SIZE];
+    uint64_t counter = offset / CHACHA_BLOCK_SIZE;
+    size_t skip = (size_t)(offset % CHACHA_BLOCK_SIZE);
+    
+    if (skip) {
+        size_t n = CHACHA_BLOCK_SIZE - skip;
+        if (n > len) {
+            n = len;
+        }
+        chacha_blocks_scalar(key, counter++, block, 1);
+        memcpy(buf, block + skip, n);
+        buf += n;
+        len -= n;
+    }
+    size_t blocks = len / CHACHA_BLOCK_SIZE;
+    if (blocks) {
+        chacha_blocks(key, counter, buf, blocks);
+        counter += blocks;
+        buf += blocks * CHACHA_BLOCK_SIZE;
+        len -= blocks * CHACHA_BLOCK_SIZE;
+    }
+    if (len) {
+        chacha_blocks_scalar(key, counter, block, 1);
+        memcpy(buf, block, len);
+    }
+}
+
+static int hex_digit_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Seed from 1-64 hex digits (--seed), shorter seeds are zero padded on the right
+static int pattern_key_parse(const char* hex, struct pattern_key* key) {
+    unsigned char bytes[32] = {0};
+    size_t len = strlen(hex);
+    if (len == 0 || len > 64) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        int v = hex_digit_value(hex[i]);
+        if (v < 0) {
+            return -1;
+        }
+        bytes[i / 2] |= (unsigned char)(i % 2 ? v : v << 4);
+    }
+    for (int i = 0; i < 8; i++) {
+        key->key[i] = get_le32(&bytes[i * 4]);
+    }
+    key->stream = 0;
+    return 0;
+}
+
+static void pattern_key_format(const struct pattern_key* key, char* out, size_t size) {
+    size_t used = 0;
+    for (int i = 0; i < 8 && used + 9 <= size; i++) {
+        for (int b = 0; b < 4; b++) {
+            used += snprintf(out + used, size - used, "%02x", (key->key[i] >> (8 * b)) & 0xff);
+        }
+    }
+}
+
+#ifdef __linux__
+// ---------------------------------------------------------------------------
+// Wipe engine (io_uring + O_DIRECT)
+// ---------------------------------------------------------------------------
+
+#define WIPE_DEFAULT_QUEUE_DEPTH    32
+#define WIPE_MAX_QUEUE_DEPTH        1024
+#define WIPE_DEFAULT_REQUEST_SIZE   (1024 * 1024)
+#define WIPE_MAX_REQUEST_SIZE       (64 * 1024 * 1024)
+#define WIPE_MIN_ALIGNMENT          4096
+
+#define WIPE_MAX_REPEAT_LEN         64
+#define VERIFY_CHUNK_SIZE           (16 * 1024)
+#define VERIFY_SAMPLE_TOLERANCE     0.01    // percent of the units a --verify-sample may miss
+#define VERIFY_SAMPLE_REGION        (64ULL * 1024 * 1024)   // read in full at both ends and around errors
+#define VERIFY_SAMPLE_MAX_REGIONS   64      // mismatches whose surroundings are re-read
+#define SANITIZE_CHUNK_SIZE         (1024ULL * 1024 * 1024)
+#define WIPE_DEFAULT_CHECKPOINT_INTERVAL 30     // seconds
+#define WIPE_DEFAULT_TELEMETRY_INTERVAL 5       // seconds
+
+enum wipe_pattern {
+    WIPE_PATTERN_ZERO,
+    WIPE_PATTERN_ONES,
+    WIPE_PATTERN_REPEAT,                // options->repeat over and over
+    WIPE_PATTERN_RANDOM                 // ChaCha keystream of options->seed
+};
+
+// How --wipe destroys the data: by writing a pattern or with a --sanitize method
+enum wipe_method {
+    WIPE_METHOD_OVERWRITE,
+    WIPE_METHOD_AUTO,                   // secure discard, falling back to zero-out
+    WIPE_METHOD_SECURE_DISCARD,         // BLKSECDISCARD
+    WIPE_METHOD_DISCARD,                // BLKDISCARD, FALLOC_FL_PUNCH_HOLE on files
+    WIPE_METHOD_ZEROOUT,                // BLKZEROOUT, FALLOC_FL_ZERO_RANGE on files
+    WIPE_METHOD_WRITE_SAME,             // SCSI WRITE SAME(16) of a zeroed block through SG_IO
+    WIPE_METHOD_UNMAP                   // SCSI UNMAP through SG_IO
+};
+
+struct wipe_options {
+    enum wipe_method method;
+    int queue_depth;                    // writes in flight (--queue-depth)
+    unsigned long long request_size;    // bytes per write (--request-size)
+    enum wipe_pattern pattern;
+    struct pattern_key seed;            // --seed, random unless given
+    int seed_given;
+    unsigned char repeat[WIPE_MAX_REPEAT_LEN];  // --pattern hex:...
+    size_t repeat_len;
+    int checkpoint_interval;            // seconds between journal checkpoints, 0 disables the journal
+    int status_interval;                // seconds between status lines, 0 turns them off
+    const char *metrics_path;           // node_exporter textfile (--metrics)
+    double sample_confidence;           // --verify-sample, percent; 0 reads every block
+    double sample_tolerance;            // percent of the units allowed to differ undetected
+};
+
+// Block device, loop device or plain file opened for overwriting
+struct wipe_target {
+    char path[512];
+    int fd;
+    int direct;                         // fd was opened with O_DIRECT
+    int is_block;
+    unsigned long long size;
+    int logical_block_size;
+    int physical_block_size;
+};
+
+struct wipe_result {
+    unsigned long long bytes;           // written, or read back when verifying
+    double seconds;
+    int error;                          // errno of the first failure, 0 on success
+    unsigned long long error_offset;
+    const char *engine;                 // "io_uring" or "pwrite", the ioctl or fallocate mode when sanitizing
+    int fixed_buffers;
+    int fixed_files;
+    enum wipe_method method;            // sanitize method that ran, after the auto fallback
+    unsigned long long chunk_size;      // bytes per sanitize request
+    unsigned long long tail_bytes;      // unaligned end zeroed after a discard
+    int journaled;                      // the pass kept a checkpoint journal
+    unsigned long long resumed_from;    // offset the pass continued from
+    unsigned long long durable;         // last checkpoint, where a rerun continues
+};
+
+// Run of consecutive logical blocks that failed verification
+struct lba_range {
+    unsigned long long start;
+    unsigned long long count;
+};
+
+struct verify_result {
+    unsigned long long mismatched_blocks;
+    struct lba_range *ranges;
+    int range_count;
+    int range_cap;
+    unsigned char *scratch;             // VERIFY_CHUNK_SIZE bytes of regenerated pattern
+    // --verify-sample: the target is split into request-sized units and only some are read
+    unsigned long long focus;           // offset whose region is read in full, e.g. where a wipe resumed
+    int sampled;
+    unsigned long long unit_size;
+    unsigned long long units;           // units on the target
+    unsigned long long random_units;    // drawn at random, one per stratum
+    unsigned long long units_read;      // random units, both ends and the focus region
+    unsigned long long expanded_units;  // read afterwards around mismatches
+    int expanded_regions;
+};
+
+// Byte range handed to the engines; a sampled verify passes many, a full pass one
+struct wipe_extent {
+    unsigned long long offset;
+    unsigned long long len;
+};
+
+// One buffer of the wipe queue and the request it currently carries
+struct wipe_slot {
+    unsigned char *buf;
+    unsigned long long offset;
+    size_t len;
+    size_t done;
+    double submitted;                   // monotonic time of the first submission, with wipe_latency_log
+};
+
+// Completion latencies of one thread's requests in seconds. Past capacity the
+// samples are a uniform reservoir of everything seen.
+struct latency_log {
+    double *samples;
+    size_t count;
+    size_t capacity;
+    unsigned long long seen;
+};
+
+// Set by --bench around a pass; the engines only read the clock when it is
+static __thread struct latency_log *wipe_latency_log = NULL;
+
+static void latency_log_add(struct latency_log* log, double seconds) {
+    log->seen++;
+    if (log->count < log->capacity) {
+        log->samples[log->count++] = seconds;
+        return;
+    }
+    // xorshift keyed by the sample count is plenty for picking a victim
+    uint64_t x = log->seen * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 31;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 29;
+    unsigned long long slot = x % log->seen;
+    if (slot < log->capacity) {
+        log->samples[slot] = seconds;
+    }
+}
+
+// Minimal io_uring instance driven through the raw system calls
+struct uring {
+    int fd;
+    unsigned sq_entries;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_local_tail;             // entries queued but not yet published
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void uring_free(struct uring* ring) {
+    if (ring->sqes && ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+// Set up a ring with at least entries submission slots; returns 0 or -errno
+static int uring_init(struct uring* ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return -errno;
+    }
+    ring->sq_entries = params.sq_entries;
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+    
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        int err = errno;
+        uring_free(ring);
+        return -err;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            int err = errno;
+            uring_free(ring);
+            return -err;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        int err = errno;
+        uring_free(ring);
+        return -err;
+    }
+    
+    char *sq = (char*)ring->sq_ring;
+    char *cq = (char*)ring->cq_ring;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->sq_local_tail = *ring->sq_tail;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+static int uring_register(struct uring* ring, unsigned opcode, void* arg, unsigned nr_args) {
+    int ret = (int)syscall(__NR_io_uring_register, ring->fd, opcode, arg, nr_args);
+    return ret < 0 ? -errno : ret;
+}
+
+// Next free submission entry, cleared; NULL when the queue is full
+static struct io_uring_sqe* uring_get_sqe(struct uring* ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = ring->sq_local_tail;
+    if (tail - head >= ring->sq_entries) {
+        return NULL;
+    }
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    ring->sq_array[index] = index;
+    ring->sq_local_tail = tail + 1;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+// Publish queued entries and wait until at least wait_nr completions are available
+static int uring_submit_and_wait(struct uring* ring, unsigned wait_nr) {
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    unsigned to_submit = ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    int ret;
+    do {
+        ret = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, wait_nr,
+                           wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? -errno : ret;
+}
+
+static struct io_uring_cqe* uring_peek_cqe(struct uring* ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+static void uring_cqe_seen(struct uring* ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// Accept a byte count with an optional K, M or G (binary) suffix
+static int parse_size_arg(const char* text, unsigned long long* out) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text || errno != 0) {
+        return -1;
+    }
+    switch (*end) {
+        case 'k': case 'K': value <<= 10; end++; break;
+        case 'm': case 'M': value <<= 20; end++; break;
+        case 'g': case 'G': value <<= 30; end++; break;
+        default: break;
+    }
+    if (*end != '\0') {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+static void wipe_options_init(struct wipe_options* options) {
+    options->method = WIPE_METHOD_OVERWRITE;
+    options->checkpoint_interval = WIPE_DEFAULT_CHECKPOINT_INTERVAL;
+    options->status_interval = WIPE_DEFAULT_TELEMETRY_INTERVAL;
+    options->metrics_path = NULL;
+    options->sample_confidence = 0;
+    options->sample_tolerance = VERIFY_SAMPLE_TOLERANCE;
+    options->queue_depth = WIPE_DEFAULT_QUEUE_DEPTH;
+    options->request_size = WIPE_DEFAULT_REQUEST_SIZE;
+    options->pattern = WIPE_PATTERN_ZERO;
+    memset(&options->seed, 0, sizeof(options->seed));
+    options->seed_given = 0;
+    memset(options->repeat, 0, sizeof(options->repeat));
+    options->repeat_len = 0;
+}
+
+// A fresh random seed per wipe unless --seed pins it
+static int wipe_options_seed(struct wipe_options* options) {
+    if (options->seed_given) {
+        return 0;
+    }
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    ssize_t got = read(fd, options->seed.key, sizeof(options->seed.key));
+    close(fd);
+    return got == (ssize_t)sizeof(options->seed.key) ? 0 : -EIO;
+}
+
+// --pattern hex:55aa: up to WIPE_MAX_REPEAT_LEN bytes written over and over
+static int parse_repeat_pattern(const char* hex, struct wipe_options* options) {
+    size_t len = strlen(hex);
+    if (len == 0 || len % 2 != 0 || len / 2 > WIPE_MAX_REPEAT_LEN) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i += 2) {
+        int high = hex_digit_value(hex[i]);
+        int low = hex_digit_value(hex[i + 1]);
+        if (high < 0 || low < 0) {
+            return -1;
+        }
+        options->repeat[i / 2] = (unsigned char)(high << 4 | low);
+    }
+    options->repeat_len = len / 2;
+    return 0;
+}
+
+// Name of a block device under /sys/block from its device number
+static int wipe_block_name(dev_t rdev, char* name, size_t size) {
+    char number[32];
+    char link[512];
+    snprintf(number, sizeof(number), "%u:%u", major(rdev), minor(rdev));
+    int dev_fd = sysfs_open_dir("dev/block");
+    if (dev_fd < 0) {
+        return -1;
+    }
+    ssize_t len = readlinkat(dev_fd, number, link, sizeof(link) - 1);
+    close(dev_fd);
+    if (len <= 0) {
+        return -1;
+    }
+    link[len] = '\0';
+    const char *base = strrchr(link, '/');
+    base = base ? base + 1 : link;
+    if (strlen(base) >= size) {
+        return -1;
+    }
+    memcpy(name, base, strlen(base) + 1);
+    return 0;
+}
+
+// Open path for overwriting, or for reading it back when writable is 0. Block
+// devices are opened exclusively for writing so a mounted or otherwise claimed
+// device is refused by the kernel. Block sizes come from the probed profile
+// when there is one, otherwise from the device itself.
+static int wipe_open_target(const char* path, const struct device_profile* profile, int writable,
+                            struct wipe_target* target) {
+    int access = writable ? O_WRONLY : O_RDONLY;
+    struct stat st;
+    memset(target, 0, sizeof(*target));
+    target->fd = -1;
+    snprintf(target->path, sizeof(target->path), "%s", path);
+    
+    if (stat(path, &st) != 0) {
+        return -errno;
+    }
+    if (S_ISBLK(st.st_mode)) {
+        target->is_block = 1;
+        target->fd = open(path, access | O_DIRECT | (writable ? O_EXCL : 0) | O_CLOEXEC);
+        if (target->fd < 0) {
+            return -errno;
+        }
+        target->direct = 1;
+        
+        int read_only = 0;
+        if (writable && ioctl(target->fd, BLKROGET, &read_only) == 0 && read_only) {
+            close(target->fd);
+            target->fd = -1;
+            return -EROFS;
+        }
+        uint64_t size = 0;
+        if (ioctl(target->fd, BLKGETSIZE64, &size) != 0) {
+            int err = errno;
+            close(target->fd);
+            target->fd = -1;
+            return -err;
+        }
+        target->size = size;
+        
+        int logical = 0;
+        unsigned int physical = 0;
+        if (profile && profile->logical_block_size > 0) {
+            logical = profile->logical_block_size;
+        } else if (ioctl(target->fd, BLKSSZGET, &logical) != 0) {
+            logical = 512;
+        }
+        if (profile && profile->physical_block_size > 0) {
+            physical = (unsigned int)profile->physical_block_size;
+        } else if (ioctl(target->fd, BLKPBSZGET, &physical) != 0) {
+            physical = (unsigned int)logical;
+        }
+        target->logical_block_size = logical;
+        target->physical_block_size = (int)physical;
+    } else if (S_ISREG(st.st_mode)) {
+        // Not every filesystem supports O_DIRECT (tmpfs for one)
+        target->fd = open(path, access | O_DIRECT | O_CLOEXEC);
+        target->direct = target->fd >= 0;
+        if (target->fd < 0 && errno == EINVAL) {
+            target->fd = open(path, access | O_CLOEXEC);
+        }
+        if (target->fd < 0) {
+            return -errno;
+        }
+        target->size = (unsigned long long)st.st_size;
+        target->logical_block_size = st.st_blksize > 0 ? (int)st.st_blksize : WIPE_MIN_ALIGNMENT;
+        target->physical_block_size = target->logical_block_size;
+    } else {
+        return -ENOTSUP;
+    }
+    return 0;
+}
+
+// Pattern bytes for [offset, offset + len) of the target
+static void wipe_fill_pattern(const struct wipe_options* options, unsigned long long offset,
+                              unsigned char* buf, size_t len) {
+    if (options->pattern == WIPE_PATTERN_RANDOM) {
+        pattern_fill(&options->seed, offset, buf, len);
+    } else if (options->pattern == WIPE_PATTERN_REPEAT) {
+        // One period in phase with offset, then double the filled prefix; its
+        // length stays a multiple of the period so every copy stays in phase
+        size_t period = options->repeat_len;
+        size_t phase = (size_t)(offset % period);
+        size_t filled = len < period ? len : period;
+        for (size_t i = 0; i < filled; i++) {
+            buf[i] = options->repeat[(phase + i) % period];
+        }
+        while (filled < len) {
+            size_t n = len - filled < filled ? len - filled : filled;
+            memcpy(buf + filled, buf, n);
+            filled += n;
+        }
+    } else {
+        memset(buf, options->pattern == WIPE_PATTERN_ONES ? 0xff : 0x00, len);
+    }
+}
+
+// Constant patterns are written once into every buffer, the others per request
+static int wipe_pattern_per_request(const struct wipe_options* options) {
+    return options->pattern == WIPE_PATTERN_RANDOM || options->pattern == WIPE_PATTERN_REPEAT;
+}
+
+// Number of leading bytes of data that match the pattern at offset. Constant
+// patterns are checked in place; the others are regenerated in cache-sized
+// pieces so the expected data never leaves L1.
+static size_t verify_span(const struct wipe_options* options, unsigned long long offset,
+                          const unsigned char* data, size_t len, unsigned char* scratch) {
+    if (!wipe_pattern_per_request(options)) {
+        return compare_fill(data, options->pattern == WIPE_PATTERN_ONES ? 0xff : 0x00, len);
+    }
+    size_t done = 0;
+    while (done < len) {
+        size_t n = len - done < VERIFY_CHUNK_SIZE ? len - done : VERIFY_CHUNK_SIZE;
+        wipe_fill_pattern(options, offset + done, scratch, n);
+        size_t same = compare_bytes(data + done, scratch, n);
+        done += same;
+        if (same < n) {
+            break;
+        }
+    }
+    return done;
+}
+
+static void verify_add_mismatch(struct verify_result* verify, unsigned long long lba) {
+    verify->mismatched_blocks++;
+    if (verify->range_count > 0) {
+        struct lba_range *last = &verify->ranges[verify->range_count - 1];
+        if (last->start + last->count == lba) {
+            last->count++;
+            return;
+        }
+    }
+    if (verify->range_count == verify->range_cap) {
+        int new_cap = verify->range_cap ? verify->range_cap * 2 : 16;
+        struct lba_range *grown = (struct lba_range*)realloc(verify->ranges, new_cap * sizeof(*grown));
+        if (!grown) {
+            return;
+        }
+        verify->ranges = grown;
+        verify->range_cap = new_cap;
+    }
+    verify->ranges[verify->range_count].start = lba;
+    verify->ranges[verify->range_count].count = 1;
+    verify->range_count++;
+}
+
+// Compare a buffer read from offset; a mismatch is narrowed down to the
+// logical blocks that differ
+static void verify_buffer(const struct wipe_target* target, const struct wipe_options* options,
+                          unsigned long long offset, const unsigned char* data, size_t len,
+                          struct verify_result* verify) {
+    size_t same = verify_span(options, offset, data, len, verify->scratch);
+    if (same == len) {
+        return;
+    }
+    size_t block = (size_t)target->logical_block_size;
+    for (size_t pos = same / block * block; pos < len; pos += block) {
+        size_t n = len - pos < block ? len - pos : block;
+        if (verify_span(options, offset + pos, data + pos, n, verify->scratch) < n) {
+            verify_add_mismatch(verify, (offset + pos) / block);
+        }
+    }
+}
+
+static int lba_range_compare(const void* a, const void* b) {
+    const struct lba_range *x = (const struct lba_range*)a;
+    const struct lba_range *y = (const struct lba_range*)b;
+    return x->start < y->start ? -1 : x->start > y->start;
+}
+
+// Reads complete out of order; sort the ranges and join neighbours
+static void verify_merge_ranges(struct verify_result* verify) {
+    if (verify->range_count < 2) {
+        return;
+    }
+    qsort(verify->ranges, verify->range_count, sizeof(struct lba_range), lba_range_compare);
+    int out = 0;
+    for (int i = 1; i < verify->range_count; i++) {
+        struct lba_range *last = &verify->ranges[out];
+        if (verify->ranges[i].start <= last->start + last->count) {
+            unsigned long long end = verify->ranges[i].start + verify->ranges[i].count;
+            if (end > last->start + last->count) {
+                last->count = end - last->start;
+            }
+        } else {
+            verify->ranges[++out] = verify->ranges[i];
+        }
+    }
+    verify->range_count = out + 1;
+}
+
+// ---------------------------------------------------------------------------
+// Wipe journal (resumable overwrite passes)
+// ---------------------------------------------------------------------------
+//
+// <state dir>/journal/<model>_<serial>.journal starts with a header naming the
+// device and the pattern, followed by one record per checkpoint with the
+// logical blocks that reached the media since the previous one. A record is
+// only appended after fdatasync() of the target, and a torn last record fails
+// its checksum and is dropped, so a rerun of the same command continues from
+// the last checkpoint that fully reached the journal.
+
+#define WIPE_JOURNAL_MAGIC      "SDWJRNL\n"
+#define WIPE_JOURNAL_VERSION    1
+#define WIPE_JOURNAL_DIR        "journal"
+
+struct wipe_journal_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t checksum;                  // FNV-1a of the header with this field zeroed
+    char model[64];
+    char serial[64];
+    uint64_t size;
+    uint32_t logical_block_size;
+    uint32_t pattern;
+    uint32_t repeat_len;
+    uint32_t reserved;
+    unsigned char repeat[WIPE_MAX_REPEAT_LEN];
+    struct pattern_key seed;
+    int64_t started_at;
+};
+
+struct wipe_journal_record {
+    uint32_t pass;                      // 0: the overwrite pass
+    uint32_t checksum;                  // FNV-1a of the record with this field zeroed
+    uint64_t start_lba;                 // [start_lba, end_lba) is on the media
+    uint64_t end_lba;
+    int64_t written_at;
+};
+
+struct wipe_journal {
+    int fd;                             // -1 when the pass is not journaled
+    char path[1024];
+    double interval;
+    double last_checkpoint;
+    unsigned long long durable;         // bytes from offset 0 known to be on the media
+    unsigned long long block_size;
+};
+
+// Set by SIGINT/SIGTERM: stop submitting, drain the queue and checkpoint
+static volatile sig_atomic_t wipe_interrupted = 0;
+
+static void wipe_signal_handler(int sig) {
+    (void)sig;
+    wipe_interrupted = 1;
+}
+
+// A second Ctrl+C terminates right away
+static void wipe_install_signal_handlers(void) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = wipe_signal_handler;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+static uint32_t fnv1a32(const void* data, size_t len) {
+    const unsigned char *p = (const unsigned char*)data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t wipe_journal_header_checksum(const struct wipe_journal_header* header) {
+    struct wipe_journal_header copy = *header;
+    copy.checksum = 0;
+    return fnv1a32(&copy, sizeof(copy));
+}
+
+static uint32_t wipe_journal_record_checksum(const struct wipe_journal_record* record) {
+    struct wipe_journal_record copy = *record;
+    copy.checksum = 0;
+    return fnv1a32(&copy, sizeof(copy));
+}
+
+// Identity the journal is keyed and checked by: identify data where the
+// drive answered it, else sysfs; plain files by their path. Fails for a
+// device without a serial number: two identical sticks would otherwise
+// share one journal and the second would skip the first one's checkpoint.
+static int wipe_journal_identity(const struct wipe_target* target, const struct device_profile* profile,
+                                  struct wipe_journal_header* header) {
+    if (!profile) {
+        // Hash of the full path plus the file name, which alone may repeat
+        const char *base = strrchr(target->path, '/');
+        snprintf(header->model, sizeof(header->model), "file");
+        snprintf(header->serial, sizeof(header->serial), "%08x-%.50s",
+                 fnv1a32(target->path, strlen(target->path)), base ? base + 1 : target->path);
+    } else if (profile->ata.valid) {
+        snprintf(header->model, sizeof(header->model), "%s", profile->ata.model);
+        snprintf(header->serial, sizeof(header->serial), "%s", profile->ata.serial);
+    } else if (profile->is_nvme && profile->nvme_ctrl.valid && profile->nvme_ctrl.serial[0]) {
+        snprintf(header->model, sizeof(header->model), "%s", profile->nvme_ctrl.model);
+        snprintf(header->serial, sizeof(header->serial), "%s-n%u", profile->nvme_ctrl.serial, profile->nvme_nsid);
+    } else {
+        snprintf(header->model, sizeof(header->model), "%.63s", profile->model[0] ? profile->model : profile->name);
+        snprintf(header->serial, sizeof(header->serial), "%.63s", profile->serial);
+    }
+    return header->serial[0] ? 0 : -1;
+}
+
+static void wipe_journal_name(const struct wipe_journal_header* header, char* name, size_t size) {
+    snprintf(name, size, "%s_%s", header->model, header->serial);
+    for (char *p = name; *p; p++) {
+        if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') ||
+              *p == '-' || *p == '.')) {
+            *p = '_';
+        }
+    }
+}
+
+// Header of the current run; for a random pattern without --seed the seed of
+// the journal is adopted, so the resumed pass writes the same keystream
+static int wipe_journal_matches(const struct wipe_journal_header* stored, const struct wipe_journal_header* current,
+                                const struct wipe_options* options) {
+    if (strcmp(stored->model, current->model) != 0 || strcmp(stored->serial, current->serial) != 0 ||
+        stored->size != current->size || stored->logical_block_size != current->logical_block_size ||
+        stored->pattern != current->pattern || stored->repeat_len != current->repeat_len ||
+        memcmp(stored->repeat, current->repeat, sizeof(stored->repeat)) != 0) {
+        return 0;
+    }
+    if (current->pattern == WIPE_PATTERN_RANDOM && options->seed_given &&
+        memcmp(&stored->seed, &current->seed, sizeof(stored->seed)) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+// Open or create the journal of the target. A matching journal moves the
+// start of the pass to its last checkpoint; anything else starts over.
+static void wipe_journal_open(struct wipe_journal* journal, const struct wipe_target* target,
+                              const struct device_profile* profile, struct wipe_options* options) {
+    memset(journal, 0, sizeof(*journal));
+    journal->fd = -1;
+    journal->interval = options->checkpoint_interval;
+    journal->block_size = (unsigned long long)target->logical_block_size;
+    
+    char dir[512];
+    char journal_dir[600];
+    if (options->checkpoint_interval <= 0 || state_dir_path(dir, sizeof(dir)) != 0) {
+        return;
+    }
+    snprintf(journal_dir, sizeof(journal_dir), "%s/%s", dir, WIPE_JOURNAL_DIR);
+    if (make_directories(journal_dir) != 0) {
+        return;
+    }
+    
+    struct wipe_journal_header current;
+    memset(&current, 0, sizeof(current));
+    memcpy(current.magic, WIPE_JOURNAL_MAGIC, sizeof(current.magic));
+    current.version = WIPE_JOURNAL_VERSION;
+    if (wipe_journal_identity(target, profile, &current) != 0) {
+        report_printf("%s reports no serial number and is wiped without checkpoints\n", target->path);
+        return;
+    }
+    current.size = target->size;
+    current.logical_block_size = (uint32_t)target->logical_block_size;
+    current.pattern = (uint32_t)options->pattern;
+    if (options->pattern == WIPE_PATTERN_REPEAT) {
+        current.repeat_len = (uint32_t)options->repeat_len;
+        memcpy(current.repeat, options->repeat, options->repeat_len);
+    }
+    if (options->pattern == WIPE_PATTERN_RANDOM) {
+        current.seed = options->seed;
+    }
+    current.started_at = (int64_t)time(NULL);
+    
+    char name[160];
+    wipe_journal_name(&current, name, sizeof(name));
+    snprintf(journal->path, sizeof(journal->path), "%s/%s.journal", journal_dir, name);
+    int fd = open(journal->path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return;
+    }
+    // Two targets reporting the same serial (cheap USB bridges) must not share a journal
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        report_printf("Journal %s is in use, %s is wiped without checkpoints\n", journal->path, target->path);
+        close(fd);
+        return;
+    }
+    
+    struct wipe_journal_header stored;
+    if (pread(fd, &stored, sizeof(stored), 0) == (ssize_t)sizeof(stored) &&
+        memcmp(stored.magic, WIPE_JOURNAL_MAGIC, sizeof(stored.magic)) == 0 &&
+        stored.version == WIPE_JOURNAL_VERSION && stored.checksum == wipe_journal_header_checksum(&stored)) {
+        if (wipe_journal_matches(&stored, &current, options)) {
+            // Checkpoints are contiguous from offset 0; stop at the first torn or foreign record
+            off_t valid = sizeof(stored);
+            unsigned long long durable_lba = 0;
+            struct wipe_journal_record record;
+            while (pread(fd, &record, sizeof(record), valid) == (ssize_t)sizeof(record) &&
+                   record.checksum == wipe_journal_record_checksum(&record) &&
+                   record.pass == 0 && record.start_lba <= durable_lba && record.end_lba > durable_lba) {
+                durable_lba = record.end_lba;
+                valid += sizeof(record);
+            }
+            if (ftruncate(fd, valid) == 0 && lseek(fd, 0, SEEK_END) == valid) {
+                options->seed = stored.seed;
+                journal->durable = durable_lba * journal->block_size;
+                if (journal->durable > target->size) {
+                    journal->durable = 0;
+                }
+                journal->fd = fd;
+                journal->last_checkpoint = monotonic_seconds();
+                return;
+            }
+        } else {
+            report_printf("Journal %s belongs to another device or pattern, starting over\n", journal->path);
+        }
+    }
+    
+    current.checksum = wipe_journal_header_checksum(&current);
+    if (ftruncate(fd, 0) != 0 || pwrite(fd, &current, sizeof(current), 0) != (ssize_t)sizeof(current) ||
+        lseek(fd, 0, SEEK_END) != (off_t)sizeof(current) || fdatasync(fd) != 0) {
+        close(fd);
+        return;
+    }
+    // Make the new directory entry durable as well
+    int dir_fd = open(journal_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    journal->fd = fd;
+    journal->last_checkpoint = monotonic_seconds();
+}
+
+// Record that everything below watermark is on the media, at most once per
+// interval unless forced
+static void wipe_journal_checkpoint(struct wipe_journal* journal, const struct wipe_target* target,
+                                    unsigned long long watermark, int force) {
+    if (!journal || journal->fd < 0) {
+        return;
+    }
+    double now = monotonic_seconds();
+    if (!force && now - journal->last_checkpoint < journal->interval) {
+        return;
+    }
+    journal->last_checkpoint = now;
+    watermark -= watermark % journal->block_size;
+    if (watermark <= journal->durable || fdatasync(target->fd) != 0) {
+        return;
+    }
+    
+    struct wipe_journal_record record;
+    memset(&record, 0, sizeof(record));
+    record.start_lba = journal->durable / journal->block_size;
+    record.end_lba = watermark / journal->block_size;
+    record.written_at = (int64_t)time(NULL);
+    record.checksum = wipe_journal_record_checksum(&record);
+    if (write(journal->fd, &record, sizeof(record)) == (ssize_t)sizeof(record) && fdatasync(journal->fd) == 0) {
+        journal->durable = watermark;
+    }
+}
+
+// A completed pass has nothing left to resume
+static void wipe_journal_close(struct wipe_journal* journal, int completed) {
+    if (journal->fd < 0) {
+        return;
+    }
+    if (completed) {
+        unlink(journal->path);
+    }
+    close(journal->fd);
+    journal->fd = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Wipe telemetry (status lines and --metrics textfile)
+// ---------------------------------------------------------------------------
+//
+// The I/O threads only add to counters and histogram buckets of their target
+// with relaxed atomics. A reporter thread samples them every interval, reads
+// /sys/block/<name>/stat next to them, prints one status line per running
+// target and rewrites the node_exporter textfile. A drive that starts
+// retrying shows up in the latency tail well before its transfers fail.
+
+#define LATENCY_SUB_BUCKET_BITS     4
+#define LATENCY_SUB_BUCKETS         (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_EXPONENT        31          // 2^32 us, a bit over an hour
+#define LATENCY_HISTOGRAM_BUCKETS   ((LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 2) * LATENCY_SUB_BUCKETS)
+
+// HDR-style histogram of microseconds: exact below 16 us, then 16 linear
+// sub-buckets per power of two, so every bucket is within 1/16 of its value
+struct latency_histogram {
+    unsigned long long counts[LATENCY_HISTOGRAM_BUCKETS];
+    unsigned long long total;
+    unsigned long long sum_us;
+    unsigned long long max_us;
+};
+
+enum wipe_telemetry_state {
+    WIPE_TELEMETRY_PENDING,
+    WIPE_TELEMETRY_RUNNING,
+    WIPE_TELEMETRY_DONE,
+    WIPE_TELEMETRY_FAILED
+};
+
+struct wipe_telemetry {
+    char label[256];                    // block device name, or the path of a file
+    char block[64];                     // /sys/block name, empty for files
+    // Written by the I/O thread
+    const char *pass;                   // "wipe", "verify" or "sanitize"
+    int state;
+    double started;
+    unsigned long long total;           // bytes of the current pass
+    unsigned long long bytes;           // bytes of the current pass done so far
+    unsigned long long errors;
+    struct latency_histogram latency;
+    // Owned by the reporter
+    unsigned long long last_bytes;
+    double last_sample;
+    double rate;                        // bytes/s over the last interval
+    int stalled;                        // nothing completed during the last interval
+};
+
+struct wipe_telemetry_set {
+    struct wipe_telemetry *targets;
+    int count;
+    int interval;
+    const char *metrics_path;
+    double started;
+    pthread_t thread;
+    int thread_started;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+// Target of the calling I/O thread, NULL when nobody is watching
+static __thread struct wipe_telemetry *wipe_telemetry_current = NULL;
+
+static int latency_bucket(unsigned long long us) {
+    if (us < LATENCY_SUB_BUCKETS) {
+        return (int)us;
+    }
+    int exponent = 63 - __builtin_clzll(us);
+    if (exponent > LATENCY_MAX_EXPONENT) {
+        return LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+    int shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    return (shift + 1) * LATENCY_SUB_BUCKETS + (int)((us >> shift) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+// Highest value that falls into bucket index
+static unsigned long long latency_bucket_limit(int index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return (unsigned long long)index;
+    }
+    int shift = index / LATENCY_SUB_BUCKETS - 1;
+    unsigned long long sub = (unsigned long long)(index % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+static void latency_histogram_add(struct latency_histogram* histogram, unsigned long long us) {
+    __atomic_add_fetch(&histogram->counts[latency_bucket(us)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->total, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->sum_us, us, __ATOMIC_RELAXED);
+    unsigned long long max = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&histogram->max_us, &max, us, 1,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Value at quantile q (0..1) of a snapshot, as the upper end of its bucket
+static unsigned long long latency_histogram_quantile(const struct latency_histogram* histogram, double q) {
+    if (histogram->total == 0) {
+        return 0;
+    }
+    unsigned long long rank = (unsigned long long)(q * histogram->total);
+    if (rank >= histogram->total) {
+        rank = histogram->total - 1;
+    }
+    unsigned long long seen = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen > rank) {
+            unsigned long long limit = latency_bucket_limit(i);
+            return limit < histogram->max_us ? limit : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+static void latency_histogram_snapshot(const struct latency_histogram* histogram, struct latency_histogram* copy) {
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        copy->counts[i] = __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+    }
+    copy->total = __atomic_load_n(&histogram->total, __ATOMIC_RELAXED);
+    copy->sum_us = __atomic_load_n(&histogram->sum_us, __ATOMIC_RELAXED);
+    copy->max_us = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+}
+
+// The engines read the clock around requests only when someone collects it
+static int wipe_timing_enabled(void) {
+    return wipe_latency_log != NULL || wipe_telemetry_current != NULL;
+}
+
+static void wipe_note_latency(double seconds) {
+    if (wipe_latency_log) {
+        latency_log_add(wipe_latency_log, seconds);
+    }
+    if (wipe_telemetry_current) {
+        latency_histogram_add(&wipe_telemetry_current->latency, (unsigned long long)(seconds * 1e6));
+    }
+}
+
+static void wipe_note_bytes(unsigned long long bytes) {
+    if (wipe_telemetry_current) {
+        __atomic_add_fetch(&wipe_telemetry_current->bytes, bytes, __ATOMIC_RELAXED);
+    }
+}
+
+static void wipe_note_error(void) {
+    if (wipe_telemetry_current) {
+        __atomic_add_fetch(&wipe_telemetry_current->errors, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// A pass of the calling thread's target starts with done of total bytes behind it
+static void wipe_telemetry_begin(const char* pass, unsigned long long total, unsigned long long done) {
+    struct wipe_telemetry *telemetry = wipe_telemetry_current;
+    if (!telemetry) {
+        return;
+    }
+    memset(&telemetry->latency, 0, sizeof(telemetry->latency));
+    __atomic_store_n(&telemetry->total, total, __ATOMIC_RELAXED);
+    __atomic_store_n(&telemetry->bytes, done, __ATOMIC_RELAXED);
+    double now = monotonic_seconds();
+    __atomic_store(&telemetry->started, &now, __ATOMIC_RELAXED);
+    __atomic_store_n(&telemetry->pass, pass, __ATOMIC_RELAXED);
+    __atomic_store_n(&telemetry->state, (int)WIPE_TELEMETRY_RUNNING, __ATOMIC_RELEASE);
+}
+
+// A pass that finds more to do, e.g. a sampled verify re-reading around mismatches
+static void wipe_telemetry_extend(unsigned long long bytes) {
+    if (wipe_telemetry_current) {
+        __atomic_fetch_add(&wipe_telemetry_current->total, bytes, __ATOMIC_RELAXED);
+    }
+}
+static void wipe_telemetry_end(int error) {
+    if (wipe_telemetry_current) {
+        __atomic_store_n(&wipe_telemetry_current->state,
+                         (int)(error ? WIPE_TELEMETRY_FAILED : WIPE_TELEMETRY_DONE), __ATOMIC_RELEASE);
+    }
+}
+
+static const char* wipe_telemetry_state_name(int state) {
+    switch (state) {
+        case WIPE_TELEMETRY_RUNNING: return "running";
+        case WIPE_TELEMETRY_DONE: return "done";
+        case WIPE_TELEMETRY_FAILED: return "failed";
+        default: return "pending";
+    }
+}
+
+// Fields of /sys/block/<name>/stat the metrics carry
+struct block_stat {
+    unsigned long long read_ios;
+    unsigned long long read_sectors;
+    unsigned long long write_ios;
+    unsigned long long write_sectors;
+    unsigned long long in_flight;
+    unsigned long long io_ticks;        // ms the device had I/O in flight
+    unsigned long long time_in_queue;   // ms, summed over all requests
+};
+
+static int read_block_stat(const char* name, struct block_stat* stat) {
+    char relative[128];
+    char line[512];
+    snprintf(relative, sizeof(relative), "block/%s", name);
+    int dir_fd = sysfs_open_dir(relative);
+    if (dir_fd < 0) {
+        return -1;
+    }
+    int len = sysfs_read_attr(dir_fd, "stat", line, sizeof(line));
+    close(dir_fd);
+    unsigned long long read_merges, read_ticks, write_merges, write_ticks;
+    if (len <= 0 || sscanf(line, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                           &stat->read_ios, &read_merges, &stat->read_sectors, &read_ticks,
+                           &stat->write_ios, &write_merges, &stat->write_sectors, &write_ticks,
+                           &stat->in_flight, &stat->io_ticks, &stat->time_in_queue) != 11) {
+        return -1;
+    }
+    return 0;
+}
+
+// Label values escape backslash, double quote and newline
+static void metrics_label(FILE* fp, const char* value) {
+    for (; *value; value++) {
+        if (*value == '\\' || *value == '"') {
+            fputc('\\', fp);
+            fputc(*value, fp);
+        } else if (*value == '\n') {
+            fputs("\\n", fp);
+        } else {
+            fputc(*value, fp);
+        }
+    }
+}
+
+static void metrics_sample(FILE* fp, const char* metric, const struct wipe_telemetry* telemetry,
+                           const char* extra, double value) {
+    fprintf(fp, "%s{device=\"", metric);
+    metrics_label(fp, telemetry->label);
+    fprintf(fp, "\"%s} %.15g\n", extra ? extra : "", value);
+}
+
+// Rewrite the textfile through a temporary name so node_exporter never reads half of it
+static void wipe_telemetry_write_metrics(struct wipe_telemetry_set* set, const struct latency_histogram* snapshots,
+                                         const unsigned long long* bytes, const int* states) {
+    char tmp[600];
+    snprintf(tmp, sizeof(tmp), "%.590s.tmp", set->metrics_path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        return;
+    }
+    fprintf(fp, "# HELP secure_wipe_bytes Bytes of the current pass transferred so far.\n");
+    fprintf(fp, "# TYPE secure_wipe_bytes gauge\n");
+    for (int i = 0; i < set->count; i++) {
+        char pass[48];
+        snprintf(pass, sizeof(pass), ",pass=\"%s\"", set->targets[i].pass ? set->targets[i].pass : "none");
+        metrics_sample(fp, "secure_wipe_bytes", &set->targets[i], pass, (double)bytes[i]);
+    }
+    fprintf(fp, "# HELP secure_wipe_target_bytes Bytes the current pass covers.\n");
+    fprintf(fp, "# TYPE secure_wipe_target_bytes gauge\n");
+    for (int i = 0; i < set->count; i++) {
+        metrics_sample(fp, "secure_wipe_target_bytes", &set->targets[i], NULL, (double)set->targets[i].total);
+    }
+    fprintf(fp, "# HELP secure_wipe_throughput_bytes_per_second Throughput over the last interval.\n");
+    fprintf(fp, "# TYPE secure_wipe_throughput_bytes_per_second gauge\n");
+    for (int i = 0; i < set->count; i++) {
+        metrics_sample(fp, "secure_wipe_throughput_bytes_per_second", &set->targets[i], NULL, set->targets[i].rate);
+    }
+    fprintf(fp, "# HELP secure_wipe_average_bytes_per_second Throughput since the pass started.\n");
+    fprintf(fp, "# TYPE secure_wipe_average_bytes_per_second gauge\n");
+    double now = monotonic_seconds();
+    for (int i = 0; i < set->count; i++) {
+        double elapsed = now - set->targets[i].started;
+        double average = states[i] != WIPE_TELEMETRY_PENDING && elapsed > 0 ? bytes[i] / elapsed : 0.0;
+        metrics_sample(fp, "secure_wipe_average_bytes_per_second", &set->targets[i], NULL, average);
+    }
+    fprintf(fp, "# HELP secure_wipe_eta_seconds Estimated seconds until the pass completes.\n");
+    fprintf(fp, "# TYPE secure_wipe_eta_seconds gauge\n");
+    for (int i = 0; i < set->count; i++) {
+        const struct wipe_telemetry *telemetry = &set->targets[i];
+        double eta = telemetry->rate > 0 && telemetry->total > bytes[i] ? (telemetry->total - bytes[i]) / telemetry->rate : 0.0;
+        metrics_sample(fp, "secure_wipe_eta_seconds", telemetry, NULL, eta);
+    }
+    fprintf(fp, "# HELP secure_wipe_errors_total Failed I/O completions.\n");
+    fprintf(fp, "# TYPE secure_wipe_errors_total counter\n");
+    for (int i = 0; i < set->count; i++) {
+        metrics_sample(fp, "secure_wipe_errors_total", &set->targets[i], NULL,
+                       (double)__atomic_load_n(&set->targets[i].errors, __ATOMIC_RELAXED));
+    }
+    fprintf(fp, "# HELP secure_wipe_state Pass state of the target (value 1 for the current state).\n");
+    fprintf(fp, "# TYPE secure_wipe_state gauge\n");
+    for (int i = 0; i < set->count; i++) {
+        char state[48];
+        snprintf(state, sizeof(state), ",state=\"%s\"", wipe_telemetry_state_name(states[i]));
+        metrics_sample(fp, "secure_wipe_state", &set->targets[i], state, 1);
+    }
+    fprintf(fp, "# HELP secure_wipe_stalled No I/O completed on a running target during the last interval.\n");
+    fprintf(fp, "# TYPE secure_wipe_stalled gauge\n");
+    for (int i = 0; i < set->count; i++) {
+        metrics_sample(fp, "secure_wipe_stalled", &set->targets[i], NULL, set->targets[i].stalled);
+    }
+    
+    // Buckets every fourfold from 32 us; the full resolution is in the quantiles
+    fprintf(fp, "# HELP secure_wipe_completion_latency_seconds I/O completion latency of the current pass.\n");
+    fprintf(fp, "# TYPE secure_wipe_completion_latency_seconds histogram\n");
+    for (int i = 0; i < set->count; i++) {
+        const struct latency_histogram *histogram = &snapshots[i];
+        unsigned long long cumulative = 0;
+        int bucket = 0;
+        for (int exponent = 0; exponent <= LATENCY_MAX_EXPONENT; exponent++) {
+            unsigned long long limit = (2ULL << exponent) - 1;
+            while (bucket < LATENCY_HISTOGRAM_BUCKETS && latency_bucket_limit(bucket) <= limit) {
+                cumulative += histogram->counts[bucket++];
+            }
+            if (exponent < 4 || exponent % 2 == 1) {
+                continue;
+            }
+            char le[48];
+            snprintf(le, sizeof(le), ",le=\"%.6g\"", (limit + 1) / 1e6);
+            metrics_sample(fp, "secure_wipe_completion_latency_seconds_bucket", &set->targets[i], le, (double)cumulative);
+        }
+        metrics_sample(fp, "secure_wipe_completion_latency_seconds_bucket", &set->targets[i], ",le=\"+Inf\"",
+                       (double)histogram->total);
+        metrics_sample(fp, "secure_wipe_completion_latency_seconds_sum", &set->targets[i], NULL, histogram->sum_us / 1e6);
+        metrics_sample(fp, "secure_wipe_completion_latency_seconds_count", &set->targets[i], NULL, (double)histogram->total);
+    }
+    fprintf(fp, "# HELP secure_wipe_completion_latency_quantile_seconds Completion latency quantiles from the HDR histogram.\n");
+    fprintf(fp, "# TYPE secure_wipe_completion_latency_quantile_seconds gauge\n");
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+    for (int i = 0; i < set->count; i++) {
+        for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+            char label[48];
+            snprintf(label, sizeof(label), ",quantile=\"%g\"", quantiles[q]);
+            metrics_sample(fp, "secure_wipe_completion_latency_quantile_seconds", &set->targets[i], label,
+                           latency_histogram_quantile(&snapshots[i], quantiles[q]) / 1e6);
+        }
+    }
+    
+    // The kernel's own view of the device: queue depth and busy time
+    fprintf(fp, "# HELP secure_wipe_device_in_flight Requests in flight (/sys/block/<device>/stat).\n");
+    fprintf(fp, "# TYPE secure_wipe_device_in_flight gauge\n");
+    struct block_stat *stats = (struct block_stat*)calloc(set->count, sizeof(struct block_stat));
+    int *have_stat = (int*)calloc(set->count, sizeof(int));
+    for (int i = 0; stats && have_stat && i < set->count; i++) {
+        have_stat[i] = set->targets[i].block[0] && read_block_stat(set->targets[i].block, &stats[i]) == 0;
+        if (have_stat[i]) {
+            metrics_sample(fp, "secure_wipe_device_in_flight", &set->targets[i], NULL, (double)stats[i].in_flight);
+        }
+    }
+    fprintf(fp, "# HELP secure_wipe_device_io_seconds_total Time the device had I/O in flight.\n");
+    fprintf(fp, "# TYPE secure_wipe_device_io_seconds_total counter\n");
+    for (int i = 0; stats && have_stat && i < set->count; i++) {
+        if (have_stat[i]) {
+            metrics_sample(fp, "secure_wipe_device_io_seconds_total", &set->targets[i], NULL, stats[i].io_ticks / 1e3);
+        }
+    }
+    fprintf(fp, "# HELP secure_wipe_device_weighted_io_seconds_total Request time summed over all requests.\n");
+    fprintf(fp, "# TYPE secure_wipe_device_weighted_io_seconds_total counter\n");
+    for (int i = 0; stats && have_stat && i < set->count; i++) {
+        if (have_stat[i]) {
+            metrics_sample(fp, "secure_wipe_device_weighted_io_seconds_total", &set->targets[i], NULL,
+                           stats[i].time_in_queue / 1e3);
+        }
+    }
+    fprintf(fp, "# HELP secure_wipe_device_completed_ios_total Completed requests by direction.\n");
+    fprintf(fp, "# TYPE secure_wipe_device_completed_ios_total counter\n");
+    for (int i = 0; stats && have_stat && i < set->count; i++) {
+        if (have_stat[i]) {
+            metrics_sample(fp, "secure_wipe_device_completed_ios_total", &set->targets[i], ",op=\"read\"",
+                           (double)stats[i].read_ios);
+            metrics_sample(fp, "secure_wipe_device_completed_ios_total", &set->targets[i], ",op=\"write\"",
+                           (double)stats[i].write_ios);
+        }
+    }
+    free(stats);
+    free(have_stat);
+    
+    int failed = ferror(fp);
+    if (fclose(fp) != 0 || failed || rename(tmp, set->metrics_path) != 0) {
+        unlink(tmp);
+    }
+}
+
+static void format_duration(double seconds, char* out, size_t size) {
+    long long s = (long long)(seconds + 0.5);
+    if (s >= 3600) {
+        snprintf(out, size, "%lldh%02lldm", s / 3600, s / 60 % 60);
+    } else if (s >= 60) {
+        snprintf(out, size, "%lldm%02llds", s / 60, s % 60);
+    } else {
+        snprintf(out, size, "%llds", s);
+    }
+}
+
+static void wipe_telemetry_status(struct wipe_telemetry_set* set, int index, const struct latency_histogram* latency,
+                                  unsigned long long bytes) {
+    struct wipe_telemetry *telemetry = &set->targets[index];
+    double now = monotonic_seconds();
+    double elapsed = now - telemetry->started;
+    double average = elapsed > 0 ? bytes / elapsed : 0.0;
+    double percent = telemetry->total ? 100.0 * bytes / telemetry->total : 100.0;
+    double rate = telemetry->rate > 0 ? telemetry->rate : average;
+    double eta = rate > 0 && telemetry->total > bytes ? (telemetry->total - bytes) / rate : 0.0;
+    unsigned long long errors = __atomic_load_n(&telemetry->errors, __ATOMIC_RELAXED);
+    double p50 = latency_histogram_quantile(latency, 0.5) / 1e3;
+    double p99 = latency_histogram_quantile(latency, 0.99) / 1e3;
+    
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "progress");
+        record_string(&rec, "device", telemetry->label);
+        record_string(&rec, "pass", telemetry->pass);
+        record_uint(&rec, "bytes", bytes);
+        record_uint(&rec, "total_bytes", telemetry->total);
+        record_key(&rec, "mb_per_second");
+        buffer_printf(&rec.buf, "%.1f", telemetry->rate / 1e6);
+        record_key(&rec, "average_mb_per_second");
+        buffer_printf(&rec.buf, "%.1f", average / 1e6);
+        record_key(&rec, "eta_seconds");
+        buffer_printf(&rec.buf, "%.0f", eta);
+        record_key(&rec, "p50_ms");
+        buffer_printf(&rec.buf, "%.3f", p50);
+        record_key(&rec, "p99_ms");
+        buffer_printf(&rec.buf, "%.3f", p99);
+        record_uint(&rec, "errors", errors);
+        record_bool(&rec, "stalled", telemetry->stalled);
+        record_emit(&rec);
+        return;
+    }
+    char eta_text[32];
+    char elapsed_text[32];
+    format_duration(eta, eta_text, sizeof(eta_text));
+    format_duration(now - set->started, elapsed_text, sizeof(elapsed_text));
+    printf("[%7s] %-12s %-8s %5.1f%% %8.1f MB/s (avg %.1f) ETA %-7s p50 %.2f ms p99 %.2f ms err %llu%s\n",
+           elapsed_text, telemetry->label, telemetry->pass, percent, telemetry->rate / 1e6, average / 1e6,
+           eta_text, p50, p99, errors, telemetry->stalled ? " STALLED" : "");
+    fflush(stdout);
+}
+
+// One sample of every target: rates, status lines, textfile
+static void wipe_telemetry_sample(struct wipe_telemetry_set* set, int final) {
+    struct latency_histogram *snapshots = (struct latency_histogram*)calloc(set->count, sizeof(struct latency_histogram));
+    unsigned long long *bytes = (unsigned long long*)calloc(set->count, sizeof(unsigned long long));
+    int *states = (int*)calloc(set->count, sizeof(int));
+    if (!snapshots || !bytes || !states) {
+        free(snapshots);
+        free(bytes);
+        free(states);
+        return;
+    }
+    double now = monotonic_seconds();
+    for (int i = 0; i < set->count; i++) {
+        struct wipe_telemetry *telemetry = &set->targets[i];
+        states[i] = __atomic_load_n(&telemetry->state, __ATOMIC_ACQUIRE);
+        bytes[i] = __atomic_load_n(&telemetry->bytes, __ATOMIC_RELAXED);
+        latency_histogram_snapshot(&telemetry->latency, &snapshots[i]);
+        
+        // A new pass starts counting from zero again
+        if (bytes[i] < telemetry->last_bytes || telemetry->last_sample < telemetry->started) {
+            telemetry->last_bytes = 0;
+            telemetry->last_sample = telemetry->started;
+        }
+        double interval = now - telemetry->last_sample;
+        telemetry->rate = states[i] == WIPE_TELEMETRY_RUNNING && interval > 0 ?
+                          (bytes[i] - telemetry->last_bytes) / interval : 0.0;
+        telemetry->stalled = states[i] == WIPE_TELEMETRY_RUNNING && bytes[i] == telemetry->last_bytes &&
+                             interval >= set->interval;
+        telemetry->last_bytes = bytes[i];
+        telemetry->last_sample = now;
+        
+        if (!final && states[i] == WIPE_TELEMETRY_RUNNING && set->interval > 0) {
+            wipe_telemetry_status(set, i, &snapshots[i], bytes[i]);
+        }
+    }
+    if (set->metrics_path) {
+        wipe_telemetry_write_metrics(set, snapshots, bytes, states);
+    }
+    free(snapshots);
+    free(bytes);
+    free(states);
+}
+
+static void* wipe_telemetry_thread(void* arg) {
+    struct wipe_telemetry_set *set = (struct wipe_telemetry_set*)arg;
+    // Without status lines the textfile is still refreshed every default interval
+    int interval = set->interval > 0 ? set->interval : WIPE_DEFAULT_TELEMETRY_INTERVAL;
+    pthread_mutex_lock(&set->lock);
+    while (!set->stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += interval;
+        while (!set->stop && pthread_cond_timedwait(&set->wake, &set->lock, &deadline) != ETIMEDOUT) {
+        }
+        if (set->stop) {
+            break;
+        }
+        pthread_mutex_unlock(&set->lock);
+        wipe_telemetry_sample(set, 0);
+        pthread_mutex_lock(&set->lock);
+    }
+    pthread_mutex_unlock(&set->lock);
+    return NULL;
+}
+
+// Telemetry of count targets; the reporter runs only when it has an output
+static int wipe_telemetry_start(struct wipe_telemetry_set* set, int count, int interval, const char* metrics_path) {
+    memset(set, 0, sizeof(*set));
+    set->targets = (struct wipe_telemetry*)calloc(count, sizeof(struct wipe_telemetry));
+    if (!set->targets) {
+        return -ENOMEM;
+    }
+    set->count = count;
+    set->interval = interval;
+    set->metrics_path = metrics_path;
+    set->started = monotonic_seconds();
+    pthread_mutex_init(&set->lock, NULL);
+    pthread_cond_init(&set->wake, NULL);
+    return 0;
+}
+
+// Name the target before the I/O starts
+static void wipe_telemetry_target(struct wipe_telemetry_set* set, int index, const char* path, const char* block) {
+    struct wipe_telemetry *telemetry = &set->targets[index];
+    snprintf(telemetry->label, sizeof(telemetry->label), "%.255s", block && block[0] ? block : path);
+    snprintf(telemetry->block, sizeof(telemetry->block), "%.63s", block ? block : "");
+}
+
+static void wipe_telemetry_run(struct wipe_telemetry_set* set) {
+    if (set->interval > 0 || set->metrics_path) {
+        set->thread_started = pthread_create(&set->thread, NULL, wipe_telemetry_thread, set) == 0;
+    }
+}
+
+// Stop the reporter and leave the final state in the textfile
+static void wipe_telemetry_stop(struct wipe_telemetry_set* set) {
+    if (!set->targets) {
+        return;
+    }
+    if (set->thread_started) {
+        pthread_mutex_lock(&set->lock);
+        set->stop = 1;
+        pthread_cond_signal(&set->wake);
+        pthread_mutex_unlock(&set->lock);
+        pthread_join(set->thread, NULL);
+    }
+    if (set->metrics_path) {
+        wipe_telemetry_sample(set, 1);
+    }
+    pthread_cond_destroy(&set->wake);
+    pthread_mutex_destroy(&set->lock);
+    free(set->targets);
+    set->targets = NULL;
+}
+
+static void wipe_queue_io(struct uring* ring, const struct wipe_target* target,
+                          struct wipe_slot* slots, int index, const struct wipe_result* result, int write) {
+    struct wipe_slot *slot = &slots[index];
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    
+    // The ring has at least one entry per slot, so this cannot fail
+    if (result->fixed_buffers) {
+        sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    } else {
+        sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe->fd = result->fixed_files ? 0 : target->fd;
+    if (result->fixed_files) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    sqe->addr = (unsigned long long)(uintptr_t)(slot->buf + slot->done);
+    sqe->len = (unsigned)(slot->len - slot->done);
+    sqe->off = slot->offset + slot->done;
+    sqe->buf_index = (unsigned short)index;
+    sqe->user_data = (unsigned long long)index;
+}
+
+// Lowest offset not yet transferred: everything below it has completed
+static unsigned long long wipe_slots_watermark(const struct wipe_slot* slots, int slot_count,
+                                               unsigned long long next_offset) {
+    unsigned long long watermark = next_offset;
+    for (int i = 0; i < slot_count; i++) {
+        if (slots[i].done < slots[i].len && slots[i].offset < watermark) {
+            watermark = slots[i].offset;
+        }
+    }
+    return watermark;
+}
+
+// Keep queue_depth requests in flight until the extents are covered; short
+// transfers are resubmitted. Without verify the slots are written with the
+// pattern, otherwise they are read back and each completed buffer is compared
+// while the following reads are already in flight.
+static int wipe_run_uring(const struct wipe_target* target, const struct wipe_options* options,
+                          struct wipe_slot* slots, int slot_count, size_t request_size,
+                          const struct wipe_extent* extents, int extent_count,
+                          struct wipe_result* result, struct verify_result* verify,
+                          struct wipe_journal* journal) {
+    struct uring ring;
+    int ret = uring_init(&ring, (unsigned)slot_count);
+    if (ret < 0) {
+        return ret;
+    }
+    result->engine = "io_uring";
+    int write = verify == NULL;
+    
+    struct iovec *iov = (struct iovec*)calloc(slot_count, sizeof(struct iovec));
+    if (iov) {
+        for (int i = 0; i < slot_count; i++) {
+            iov[i].iov_base = slots[i].buf;
+            iov[i].iov_len = request_size;
+        }
+        // Registration pins the buffers once instead of on every request; it
+        // can fail under a tight RLIMIT_MEMLOCK, plain requests still work then
+        result->fixed_buffers = uring_register(&ring, IORING_REGISTER_BUFFERS, iov, (unsigned)slot_count) == 0;
+        free(iov);
+    }
+    int fd = target->fd;
+    result->fixed_files = uring_register(&ring, IORING_REGISTER_FILES, &fd, 1) == 0;
+    
+    int *free_slots = (int*)malloc(slot_count * sizeof(int));
+    if (!free_slots) {
+        uring_free(&ring);
+        return -ENOMEM;
+    }
+    int free_count = 0;
+    for (int i = slot_count - 1; i >= 0; i--) {
+        free_slots[free_count++] = i;
+    }
+    
+    int extent = 0;
+    unsigned long long next_offset = extent_count > 0 ? extents[0].offset : 0;
+    unsigned long long end = extent_count > 0 ? extents[0].offset + extents[0].len : 0;
+    int inflight = 0;
+    while (1) {
+        while (free_count > 0 && extent < extent_count && !result->error && !wipe_interrupted) {
+            if (next_offset >= end) {
+                if (++extent < extent_count) {
+                    next_offset = extents[extent].offset;
+                    end = next_offset + extents[extent].len;
+                }
+                continue;
+            }
+            int index = free_slots[--free_count];
+            unsigned long long remaining = end - next_offset;
+            slots[index].offset = next_offset;
+            slots[index].len = remaining < request_size ? (size_t)remaining : request_size;
+            slots[index].done = 0;
+            if (write && wipe_pattern_per_request(options)) {
+                wipe_fill_pattern(options, slots[index].offset, slots[index].buf, slots[index].len);
+            }
+            if (wipe_timing_enabled()) {
+                slots[index].submitted = monotonic_seconds();
+            }
+            wipe_queue_io(&ring, target, slots, index, result, write);
+            next_offset += slots[index].len;
+            inflight++;
+        }
+        if (inflight == 0) {
+            break;
+        }
+        
+        ret = uring_submit_and_wait(&ring, 1);
+        if (ret < 0) {
+            // Requests still in flight finish when the ring is torn down
+            if (!result->error) {
+                result->error = -ret;
+                result->error_offset = next_offset;
+            }
+            break;
+        }
+        
+        struct io_uring_cqe *cqe;
+        while ((cqe = uring_peek_cqe(&ring)) != NULL) {
+            int index = (int)cqe->user_data;
+            int res = cqe->res;
+            uring_cqe_seen(&ring);
+            inflight--;
             
-            // Check if it has idVendor (actual device, not hub/controller)
-            char vendor_path[512];
-            snprintf(vendor_path, sizeof(vendor_path), "%s/idVendor", usb_device_path);
-            if (access(vendor_path, R_OK) != 0) {
+            struct wipe_slot *slot = &slots[index];
+            if (res <= 0) {
+                wipe_note_error();
+                // A read of 0 bytes means the target shrank under us
+                if (!result->error) {
+                    result->error = res < 0 ? -res : EIO;
+                    result->error_offset = slot->offset + slot->done;
+                }
+                free_slots[free_count++] = index;
+                continue;
+            }
+            slot->done += (size_t)res;
+            result->bytes += (unsigned long long)res;
+            wipe_note_bytes((unsigned long long)res);
+            if (slot->done < slot->len && !result->error) {
+                wipe_queue_io(&ring, target, slots, index, result, write);
+                inflight++;
                 continue;
             }
-            
-            printf("\n--- USB Device %s ---\n", entry->d_name);
-            usb_count++;
-            
-            // Read device information
-            FILE *fp;
-            char buffer[256];
-            
-            // Vendor ID
-            fp = fopen(vendor_path, "r");
-            if (fp) {
-                if (fgets(buffer, sizeof(buffer), fp)) {
-                    buffer[strcspn(buffer, "\n")] = 0;
-                    printf("Vendor ID: %s\n", buffer);
-                }
-                fclose(fp);
+            if (wipe_timing_enabled()) {
+                wipe_note_latency(monotonic_seconds() - slot->submitted);
+            }
+            if (verify && slot->done == slot->len) {
+                // The other slots' reads stay in flight while this one is compared
+                verify_buffer(target, options, slot->offset, slot->buf, slot->len, verify);
+            }
+            free_slots[free_count++] = index;
+        }
+        wipe_journal_checkpoint(journal, target, wipe_slots_watermark(slots, slot_count, next_offset), 0);
+    }
+    unsigned long long watermark = wipe_slots_watermark(slots, slot_count, next_offset);
+    if (wipe_interrupted && (next_offset < end || extent + 1 < extent_count) && !result->error) {
+        result->error = EINTR;
+        result->error_offset = watermark;
+    }
+    wipe_journal_checkpoint(journal, target, watermark, 1);
+    
+    free(free_slots);
+    uring_free(&ring);
+    return 0;
+}
+
+// Fallback when io_uring is unavailable (old kernel or blocked by seccomp)
+static void wipe_run_sync(const struct wipe_target* target, const struct wipe_options* options,
+                          struct wipe_slot* slot, size_t request_size,
+                          const struct wipe_extent* extents, int extent_count,
+                          struct wipe_result* result, struct verify_result* verify,
+                          struct wipe_journal* journal) {
+    result->engine = verify ? "pread" : "pwrite";
+    unsigned long long offset = extent_count > 0 ? extents[0].offset : 0;
+    unsigned long long end = extent_count > 0 ? extents[0].offset + extents[0].len : 0;
+    for (int extent = 0; extent < extent_count && !result->error; ) {
+        if (offset >= end) {
+            if (++extent < extent_count) {
+                offset = extents[extent].offset;
+                end = offset + extents[extent].len;
+            }
+            continue;
+        }
+        if (wipe_interrupted) {
+            result->error = EINTR;
+            result->error_offset = offset;
+            break;
+        }
+        unsigned long long remaining = end - offset;
+        size_t len = remaining < request_size ? (size_t)remaining : request_size;
+        ssize_t done;
+        if (!verify && wipe_pattern_per_request(options)) {
+            wipe_fill_pattern(options, offset, slot->buf, len);
+        }
+        double submitted = wipe_timing_enabled() ? monotonic_seconds() : 0.0;
+        if (verify) {
+            done = pread(target->fd, slot->buf, len, (off_t)offset);
+        } else {
+            done = pwrite(target->fd, slot->buf, len, (off_t)offset);
+        }
+        if (wipe_timing_enabled() && done > 0) {
+            wipe_note_latency(monotonic_seconds() - submitted);
+        }
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            wipe_note_error();
+            result->error = done < 0 ? errno : EIO;
+            result->error_offset = offset;
+            break;
+        }
+        if (verify) {
+            verify_buffer(target, options, offset, slot->buf, (size_t)done, verify);
+        }
+        offset += (unsigned long long)done;
+        result->bytes += (unsigned long long)done;
+        wipe_note_bytes((unsigned long long)done);
+        wipe_journal_checkpoint(journal, target, offset, 0);
+    }
+    wipe_journal_checkpoint(journal, target, offset, 1);
+}
+
+// O_DIRECT needs block-multiple transfers; the unaligned end of a plain file
+// goes through a second, buffered descriptor
+static void wipe_transfer_tail(const struct wipe_target* target, const struct wipe_options* options,
+                               unsigned long long start, struct wipe_result* result,
+                               struct verify_result* verify) {
+    unsigned long long tail = target->size - start;
+    if (tail == 0 || result->error) {
+        return;
+    }
+    int fd = open(target->path, (verify ? O_RDONLY : O_WRONLY) | O_CLOEXEC);
+    unsigned char *buf = (unsigned char*)malloc((size_t)tail);
+    if (fd < 0 || !buf) {
+        result->error = fd < 0 ? errno : ENOMEM;
+        result->error_offset = start;
+    } else {
+        ssize_t done;
+        if (verify) {
+            done = pread(fd, buf, (size_t)tail, (off_t)start);
+        } else {
+            wipe_fill_pattern(options, start, buf, (size_t)tail);
+            done = pwrite(fd, buf, (size_t)tail, (off_t)start);
+            if (done == (ssize_t)tail && fdatasync(fd) != 0) {
+                done = -1;
+            }
+        }
+        if (done != (ssize_t)tail) {
+            result->error = done < 0 ? errno : EIO;
+            result->error_offset = start;
+        } else {
+            if (verify) {
+                verify_buffer(target, options, start, buf, (size_t)tail, verify);
+            }
+            result->bytes += tail;
+            wipe_note_bytes(tail);
+        }
+    }
+    free(buf);
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+// --verify-sample reads a random subset of request-sized units instead of the
+// whole target. The units between the two end regions are split into strata of
+// at most 1/n of them and one unit is drawn uniformly from each. However the
+// bad units are spread over the strata, every draw misses them with
+// probability at most exp(-n * p) when more than a fraction p of the units are
+// bad, so n = -ln(1 - confidence) / p draws give the requested confidence. The
+// strata also keep the sample spread evenly over the LBA range.
+static unsigned long long verify_sample_size(double confidence, double tolerance) {
+    double draws = ceil(-log(1.0 - confidence / 100.0) / (tolerance / 100.0));
+    return draws < 1e18 ? (unsigned long long)draws : 1000000000000000000ULL;
+}
+
+// splitmix64; the draws only have to be unpredictable to whoever wrote the disk
+static unsigned long long sample_random(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+struct unit_list {
+    unsigned long long *units;
+    size_t count;
+    size_t capacity;
+};
+
+static int unit_list_add(struct unit_list* list, unsigned long long unit) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        unsigned long long *units = (unsigned long long*)realloc(list->units, capacity * sizeof(*units));
+        if (!units) {
+            return -ENOMEM;
+        }
+        list->units = units;
+        list->capacity = capacity;
+    }
+    list->units[list->count++] = unit;
+    return 0;
+}
+
+// Units [first, last) clipped to the target
+static int unit_list_add_range(struct unit_list* list, unsigned long long first, unsigned long long last,
+                               unsigned long long units) {
+    for (unsigned long long unit = first; unit < last && unit < units; unit++) {
+        if (unit_list_add(list, unit) != 0) {
+            return -ENOMEM;
+        }
+    }
+    return 0;
+}
+
+static int unit_compare(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void unit_list_sort(struct unit_list* list) {
+    if (list->count < 2) {
+        return;
+    }
+    qsort(list->units, list->count, sizeof(*list->units), unit_compare);
+    size_t out = 0;
+    for (size_t i = 1; i < list->count; i++) {
+        if (list->units[i] != list->units[out]) {
+            list->units[++out] = list->units[i];
+        }
+    }
+    list->count = out + 1;
+}
+
+static int unit_list_contains(const struct unit_list* list, unsigned long long unit) {
+    return list->count > 0 &&
+           bsearch(&unit, list->units, list->count, sizeof(*list->units), unit_compare) != NULL;
+}
+
+// Sorted units to extents, runs of neighbours merged so the drive sees one request stream
+static int unit_list_extents(const struct unit_list* list, unsigned long long unit_size, unsigned long long end,
+                             struct wipe_extent** extents) {
+    *extents = (struct wipe_extent*)malloc((list->count ? list->count : 1) * sizeof(struct wipe_extent));
+    if (!*extents) {
+        return -ENOMEM;
+    }
+    int count = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        unsigned long long offset = list->units[i] * unit_size;
+        unsigned long long len = end - offset < unit_size ? end - offset : unit_size;
+        if (count > 0 && (*extents)[count - 1].offset + (*extents)[count - 1].len == offset) {
+            (*extents)[count - 1].len += len;
+        } else {
+            (*extents)[count].offset = offset;
+            (*extents)[count].len = len;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Pick the units of a sampled verify: both end regions and the focus region in
+// full, plus one random unit per stratum. Leaves verify->sampled at 0 when the
+// sample would cover the whole target anyway.
+static int verify_sample_plan(const struct wipe_options* options, unsigned long long end,
+                              unsigned long long unit_size, struct verify_result* verify,
+                              struct unit_list* list) {
+    unsigned long long units = (end + unit_size - 1) / unit_size;
+    unsigned long long region = (VERIFY_SAMPLE_REGION + unit_size - 1) / unit_size;
+    unsigned long long draws = verify_sample_size(options->sample_confidence, options->sample_tolerance);
+    verify->unit_size = unit_size;
+    verify->units = units;
+    if (units <= 2 * region || draws >= units - 2 * region) {
+        return 0;
+    }
+    
+    unsigned long long seed = 0;
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || read(fd, &seed, sizeof(seed)) != (ssize_t)sizeof(seed)) {
+        seed = (unsigned long long)(monotonic_seconds() * 1e9) ^ (unsigned long long)getpid();
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    
+    if (unit_list_add_range(list, 0, region, units) != 0 ||
+        unit_list_add_range(list, units - region, units, units) != 0) {
+        return -ENOMEM;
+    }
+    if (verify->focus > 0 && verify->focus < end) {
+        unsigned long long center = verify->focus / unit_size;
+        unsigned long long first = center > region / 2 ? center - region / 2 : 0;
+        if (unit_list_add_range(list, first, first + region, units) != 0) {
+            return -ENOMEM;
+        }
+    }
+    // Strata are rounded down so none is larger than 1/draws of the middle
+    unsigned long long middle = units - 2 * region;
+    unsigned long long stride = middle / draws;
+    for (unsigned long long first = region; first < units - region; first += stride) {
+        unsigned long long size = units - region - first < stride ? units - region - first : stride;
+        if (unit_list_add(list, first + sample_random(&seed) % size) != 0) {
+            return -ENOMEM;
+        }
+        verify->random_units++;
+    }
+    unit_list_sort(list);
+    verify->sampled = 1;
+    verify->units_read = list->count;
+    return 0;
+}
+
+// After a sampled pass found mismatches: the units around the first
+// VERIFY_SAMPLE_MAX_REGIONS of them that were not read yet
+static int verify_sample_expand(const struct wipe_target* target, struct verify_result* verify,
+                                const struct unit_list* sampled, struct unit_list* list) {
+    unsigned long long unit_size = verify->unit_size;
+    unsigned long long region = (VERIFY_SAMPLE_REGION + unit_size - 1) / unit_size;
+    verify_merge_ranges(verify);
+    for (int i = 0; i < verify->range_count && i < VERIFY_SAMPLE_MAX_REGIONS; i++) {
+        unsigned long long first = verify->ranges[i].start * target->logical_block_size / unit_size;
+        unsigned long long last = (verify->ranges[i].start + verify->ranges[i].count) *
+                                  target->logical_block_size / unit_size;
+        first = first > region / 2 ? first - region / 2 : 0;
+        for (unsigned long long unit = first; unit <= last + region / 2 && unit < verify->units; unit++) {
+            if (!unit_list_contains(sampled, unit) && unit_list_add(list, unit) != 0) {
+                return -ENOMEM;
+            }
+        }
+        verify->expanded_regions++;
+    }
+    unit_list_sort(list);
+    verify->expanded_units = list->count;
+    verify->units_read += list->count;
+    return 0;
+}
+
+static void wipe_run_extents(const struct wipe_target* target, const struct wipe_options* options,
+                             struct wipe_slot* slots, int slot_count, size_t request_size,
+                             const struct wipe_extent* extents, int extent_count,
+                             struct wipe_result* result, struct verify_result* verify,
+                             struct wipe_journal* journal) {
+    int ret = wipe_run_uring(target, options, slots, slot_count, request_size, extents, extent_count,
+                             result, verify, journal);
+    if (ret < 0) {
+        wipe_run_sync(target, options, &slots[0], request_size, extents, extent_count, result, verify, journal);
+    }
+}
+
+// Overwrite an opened target with the configured pattern, or with verify
+// read it back and record every logical block that does not hold it. With
+// --verify-sample only the planned units are read.
+static void wipe_target_run(const struct wipe_target* target, const struct wipe_options* options,
+                            struct wipe_result* result, struct verify_result* verify,
+                            struct wipe_journal* journal) {
+    memset(result, 0, sizeof(*result));
+    
+    // Requests are whole multiples of the larger block size and buffers are
+    // page aligned, which satisfies O_DIRECT on every device we probe
+    size_t alignment = WIPE_MIN_ALIGNMENT;
+    if ((size_t)target->physical_block_size > alignment) {
+        alignment = (size_t)target->physical_block_size;
+    }
+    if ((size_t)target->logical_block_size > alignment) {
+        alignment = (size_t)target->logical_block_size;
+    }
+    size_t request_size = (size_t)options->request_size / alignment * alignment;
+    if (request_size == 0) {
+        request_size = alignment;
+    }
+    unsigned long long end = target->size;
+    if (target->direct) {
+        end -= end % (unsigned long long)target->logical_block_size;
+    }
+    
+    int slot_count = options->queue_depth;
+    unsigned long long requests = (end + request_size - 1) / request_size;
+    if (requests < (unsigned long long)slot_count) {
+        slot_count = requests > 0 ? (int)requests : 1;
+    }
+    struct wipe_slot *slots = (struct wipe_slot*)calloc(slot_count, sizeof(struct wipe_slot));
+    if (!slots) {
+        result->error = ENOMEM;
+        return;
+    }
+    for (int i = 0; i < slot_count; i++) {
+        if (posix_memalign((void**)&slots[i].buf, alignment, request_size) != 0) {
+            slots[i].buf = NULL;
+            result->error = ENOMEM;
+            break;
+        }
+        // Constant patterns are written once here, the others per request
+        if (!verify) {
+            wipe_fill_pattern(options, 0, slots[i].buf, request_size);
+        }
+    }
+    
+    // A journaled pass continues behind its last checkpoint
+    unsigned long long resume = journal && journal->fd >= 0 ? journal->durable : 0;
+    if (resume > end) {
+        resume = end;
+    }
+    result->journaled = journal && journal->fd >= 0;
+    result->resumed_from = resume;
+    
+    struct wipe_extent whole = { resume, end - resume };
+    struct wipe_extent *extents = &whole;
+    int extent_count = 1;
+    struct unit_list sample = { NULL, 0, 0 };
+    struct wipe_extent *sample_extents = NULL;
+    if (verify && options->sample_confidence > 0 && !result->error) {
+        int ret = verify_sample_plan(options, end, request_size, verify, &sample);
+        if (ret == 0 && verify->sampled) {
+            ret = unit_list_extents(&sample, request_size, end, &sample_extents);
+            extents = sample_extents;
+            extent_count = ret;
+        }
+        if (ret < 0) {
+            result->error = -ret;
+            extent_count = 0;
+        }
+    }
+    unsigned long long planned = target->size - end;
+    for (int i = 0; i < extent_count; i++) {
+        planned += extents[i].len;
+    }
+    wipe_telemetry_begin(verify ? "verify" : "wipe", planned + resume, resume);
+    
+    double start = monotonic_seconds();
+    if (!result->error) {
+        wipe_run_extents(target, options, slots, slot_count, request_size, extents, extent_count,
+                         result, verify, journal);
+    }
+    if (verify && verify->sampled && verify->mismatched_blocks && !result->error && !wipe_interrupted) {
+        // Find out how far the damage reaches around what the sample hit
+        struct unit_list around = { NULL, 0, 0 };
+        struct wipe_extent *around_extents = NULL;
+        int ret = verify_sample_expand(target, verify, &sample, &around);
+        if (ret == 0) {
+            ret = unit_list_extents(&around, request_size, end, &around_extents);
+        }
+        if (ret < 0) {
+            result->error = -ret;
+        } else if (ret > 0) {
+            for (int i = 0; i < ret; i++) {
+                wipe_telemetry_extend(around_extents[i].len);
+            }
+            wipe_run_extents(target, options, slots, slot_count, request_size, around_extents, ret,
+                             result, verify, NULL);
+        }
+        free(around_extents);
+        free(around.units);
+    }
+    free(sample_extents);
+    free(sample.units);
+    if (!verify && !result->error && fdatasync(target->fd) != 0) {
+        result->error = errno;
+        result->error_offset = end;
+    }
+    wipe_transfer_tail(target, options, end, result, verify);
+    result->seconds = monotonic_seconds() - start;
+    wipe_telemetry_end(result->error || (verify && verify->mismatched_blocks));
+    if (result->journaled) {
+        result->durable = journal->durable;
+    }
+    
+    for (int i = 0; i < slot_count; i++) {
+        free(slots[i].buf);
+    }
+    free(slots);
+}
+
+// Issue one sanitize request for [offset, offset + len), returns 0 or an errno
+static int wipe_sanitize_request(const struct wipe_target* target, const struct scsi_block_limits* scsi,
+                                 enum wipe_method method, unsigned long long offset, unsigned long long len) {
+    int ret;
+    if (method == WIPE_METHOD_WRITE_SAME || method == WIPE_METHOD_UNMAP) {
+        unsigned long long lba = offset / scsi->block_size;
+        unsigned long long blocks = len / scsi->block_size;
+        if (method == WIPE_METHOD_UNMAP) {
+            return scsi_unmap(target->fd, lba, blocks, scsi);
+        }
+        unsigned char *zero_block = (unsigned char*)calloc(1, scsi->block_size);
+        if (!zero_block) {
+            return ENOMEM;
+        }
+        ret = scsi_write_same16(target->fd, lba, (uint32_t)blocks, zero_block, scsi->block_size, 0);
+        free(zero_block);
+        return ret;
+    }
+    if (target->is_block) {
+        uint64_t range[2] = { offset, len };
+        unsigned long request = method == WIPE_METHOD_SECURE_DISCARD ? BLKSECDISCARD :
+                                method == WIPE_METHOD_DISCARD ? BLKDISCARD : BLKZEROOUT;
+        ret = ioctl(target->fd, request, range);
+    } else if (method == WIPE_METHOD_SECURE_DISCARD) {
+        // Filesystems have no secure variant of hole punching
+        return EOPNOTSUPP;
+    } else {
+        int mode = method == WIPE_METHOD_DISCARD ? FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE : FALLOC_FL_ZERO_RANGE;
+        ret = fallocate(target->fd, mode, (off_t)offset, (off_t)len);
+    }
+    return ret < 0 ? errno : 0;
+}
+
+static const char* wipe_sanitize_engine(const struct wipe_target* target, enum wipe_method method) {
+    if (method == WIPE_METHOD_WRITE_SAME) {
+        return "WRITE SAME(16)";
+    }
+    if (method == WIPE_METHOD_UNMAP) {
+        return "UNMAP";
+    }
+    if (!target->is_block) {
+        if (method == WIPE_METHOD_SECURE_DISCARD) {
+            return "none";
+        }
+        return method == WIPE_METHOD_ZEROOUT ? "FALLOC_FL_ZERO_RANGE" : "FALLOC_FL_PUNCH_HOLE";
+    }
+    switch (method) {
+        case WIPE_METHOD_SECURE_DISCARD: return "BLKSECDISCARD";
+        case WIPE_METHOD_DISCARD: return "BLKDISCARD";
+        default: return "BLKZEROOUT";
+    }
+}
+
+// Largest request of a sanitize method and the alignment its range needs.
+// Returns EOPNOTSUPP when the probed limits rule the method out.
+static int wipe_sanitize_limits(const struct wipe_target* target, const struct device_profile* profile,
+                                enum wipe_method method, unsigned long long* chunk, unsigned long long* granularity) {
+    *chunk = SANITIZE_CHUNK_SIZE;
+    *granularity = target->is_block ? (unsigned long long)target->logical_block_size : 1;
+    
+    if (method == WIPE_METHOD_WRITE_SAME || method == WIPE_METHOD_UNMAP) {
+        // Native SCSI commands address the disk in the blocks READ CAPACITY(16) reported
+        if (!target->is_block || !profile || !profile->scsi.valid) {
+            return EOPNOTSUPP;
+        }
+        const struct scsi_block_limits *scsi = &profile->scsi;
+        if (scsi->block_size != (uint32_t)target->logical_block_size) {
+            return EINVAL;
+        }
+        if (method == WIPE_METHOD_WRITE_SAME) {
+            unsigned long long blocks = scsi->max_write_same_blocks ? scsi->max_write_same_blocks
+                                                                    : SCSI_DEFAULT_WRITE_SAME_BLOCKS;
+            // One command has to finish well within SCSI_WRITE_SAME_TIMEOUT
+            // even on a disk that reports a huge MAXIMUM WRITE SAME LENGTH
+            if (blocks > SCSI_MAX_WRITE_SAME_BLOCKS) {
+                blocks = SCSI_MAX_WRITE_SAME_BLOCKS;
+            }
+            if (blocks * scsi->block_size > SANITIZE_CHUNK_SIZE) {
+                blocks = SANITIZE_CHUNK_SIZE / scsi->block_size;
+            }
+            *chunk = blocks * scsi->block_size;
+            return 0;
+        }
+        if (!scsi->max_unmap_blocks || !scsi->max_unmap_descriptors) {
+            return EOPNOTSUPP;
+        }
+        unsigned long long descriptors = scsi->max_unmap_descriptors < SCSI_MAX_UNMAP_DESCRIPTORS ?
+                                         scsi->max_unmap_descriptors : SCSI_MAX_UNMAP_DESCRIPTORS;
+        *chunk = (unsigned long long)scsi->max_unmap_blocks * descriptors * scsi->block_size;
+        if (scsi->unmap_granularity > 1) {
+            *granularity = (unsigned long long)scsi->unmap_granularity * scsi->block_size;
+        }
+    } else if (target->is_block && method != WIPE_METHOD_ZEROOUT) {
+        if (profile && profile->discard_max_bytes == 0) {
+            return EOPNOTSUPP;
+        }
+        if (profile && profile->discard_granularity > 0) {
+            *granularity = (unsigned long long)profile->discard_granularity;
+        }
+    } else {
+        return 0;
+    }
+    *chunk -= *chunk % *granularity;
+    if (*chunk == 0) {
+        *chunk = *granularity;
+    }
+    return 0;
+}
+
+// Sanitize [start, end) in chunks of at most chunk bytes
+static void wipe_sanitize_range(const struct wipe_target* target, const struct scsi_block_limits* scsi,
+                                enum wipe_method method, unsigned long long start, unsigned long long end,
+                                unsigned long long chunk, struct wipe_result* result) {
+    for (unsigned long long offset = start; offset < end && !result->error; ) {
+        unsigned long long len = end - offset < chunk ? end - offset : chunk;
+        double submitted = wipe_timing_enabled() ? monotonic_seconds() : 0.0;
+        int err = wipe_sanitize_request(target, scsi, method, offset, len);
+        if (err) {
+            // Unsupported methods are a fallback, not a failing drive
+            if (err != EOPNOTSUPP) {
+                wipe_note_error();
+            }
+            result->error = err;
+            result->error_offset = offset;
+            break;
+        }
+        if (wipe_timing_enabled()) {
+            wipe_note_latency(monotonic_seconds() - submitted);
+        }
+        result->bytes += len;
+        wipe_note_bytes(len);
+        offset += len;
+    }
+}
+
+// Destroy the contents of the target with device commands instead of writes.
+// Discards only release whole granules, so the chunks start on granule
+// boundaries and an unaligned end of the device is zeroed out instead.
+static void wipe_sanitize_run(const struct wipe_target* target, const struct device_profile* profile,
+                              const struct wipe_options* options, struct wipe_result* result) {
+    enum wipe_method candidates[2];
+    int candidate_count = 0;
+    if (options->method != WIPE_METHOD_AUTO) {
+        candidates[candidate_count++] = options->method;
+    } else if (target->is_block) {
+        candidates[candidate_count++] = WIPE_METHOD_SECURE_DISCARD;
+        candidates[candidate_count++] = WIPE_METHOD_ZEROOUT;
+    } else {
+        candidates[candidate_count++] = WIPE_METHOD_ZEROOUT;
+        candidates[candidate_count++] = WIPE_METHOD_DISCARD;
+    }
+    const struct scsi_block_limits *scsi = profile ? &profile->scsi : NULL;
+    wipe_telemetry_begin("sanitize", target->size, 0);
+    
+    double start = monotonic_seconds();
+    for (int c = 0; c < candidate_count; c++) {
+        memset(result, 0, sizeof(*result));
+        enum wipe_method method = candidates[c];
+        result->method = method;
+        result->engine = wipe_sanitize_engine(target, method);
+        
+        unsigned long long granularity = 0;
+        result->error = wipe_sanitize_limits(target, profile, method, &result->chunk_size, &granularity);
+        unsigned long long end = target->size - target->size % granularity;
+        if (!result->error) {
+            wipe_sanitize_range(target, scsi, method, 0, end, result->chunk_size, result);
+        }
+        // Fall back only while nothing has been erased yet
+        if (result->error == EOPNOTSUPP && result->bytes == 0 && c + 1 < candidate_count) {
+            continue;
+        }
+        if (!result->error && end < target->size) {
+            result->tail_bytes = target->size - end;
+            int err = wipe_sanitize_request(target, scsi, WIPE_METHOD_ZEROOUT, end, result->tail_bytes);
+            if (err) {
+                result->error = err;
+                result->error_offset = end;
+            } else {
+                result->bytes += result->tail_bytes;
+            }
+        }
+        break;
+    }
+    if (!result->error && fdatasync(target->fd) != 0) {
+        result->error = errno;
+        result->error_offset = target->size;
+    }
+    // SG_IO bypasses the page cache, drop whatever it still holds of the old data
+    if (result->method == WIPE_METHOD_WRITE_SAME || result->method == WIPE_METHOD_UNMAP) {
+        ioctl(target->fd, BLKFLSBUF, 0);
+    }
+    result->seconds = monotonic_seconds() - start;
+    wipe_telemetry_end(result->error);
+}
+
+static const char* wipe_method_name(enum wipe_method method) {
+    switch (method) {
+        case WIPE_METHOD_AUTO: return "auto";
+        case WIPE_METHOD_SECURE_DISCARD: return "secure-discard";
+        case WIPE_METHOD_DISCARD: return "discard";
+        case WIPE_METHOD_ZEROOUT: return "zeroout";
+        case WIPE_METHOD_WRITE_SAME: return "write-same";
+        case WIPE_METHOD_UNMAP: return "unmap";
+        default: return "overwrite";
+    }
+}
+
+static const char* wipe_pattern_name(enum wipe_pattern pattern) {
+    switch (pattern) {
+        case WIPE_PATTERN_ONES: return "ones";
+        case WIPE_PATTERN_REPEAT: return "repeating";
+        case WIPE_PATTERN_RANDOM: return "random";
+        default: return "zero";
+    }
+}
+
+static void report_wipe_result(const struct wipe_target* target, const struct wipe_options* options,
+                               const struct wipe_result* result) {
+    double mb_per_second = result->seconds > 0 ? result->bytes / result->seconds / 1e6 : 0.0;
+    
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "wipe");
+        record_string(&rec, "path", target->path);
+        record_string(&rec, "status", result->error ? "error" : "ok");
+        if (result->error) {
+            record_string(&rec, "message", strerror(result->error));
+            record_uint(&rec, "error_offset", result->error_offset);
+        }
+        record_uint(&rec, "size_bytes", target->size);
+        record_uint(&rec, "bytes_written", result->bytes);
+        record_bool(&rec, "journaled", result->journaled);
+        if (result->resumed_from) {
+            record_uint(&rec, "resumed_from", result->resumed_from);
+        }
+        if (result->journaled && result->error) {
+            record_uint(&rec, "checkpoint", result->durable);
+        }
+        record_key(&rec, "seconds");
+        buffer_printf(&rec.buf, "%.3f", result->seconds);
+        record_key(&rec, "mb_per_second");
+        buffer_printf(&rec.buf, "%.1f", mb_per_second);
+        record_string(&rec, "engine", result->engine);
+        record_bool(&rec, "direct", target->direct);
+        record_bool(&rec, "fixed_buffers", result->fixed_buffers);
+        record_bool(&rec, "fixed_files", result->fixed_files);
+        record_int(&rec, "queue_depth", options->queue_depth);
+        record_uint(&rec, "request_size", options->request_size);
+        record_string(&rec, "pattern", wipe_pattern_name(options->pattern));
+        if (options->pattern == WIPE_PATTERN_RANDOM) {
+            char seed[65] = "";
+            pattern_key_format(&options->seed, seed, sizeof(seed));
+            record_string(&rec, "seed", seed);
+            record_string(&rec, "pattern_engine", pattern_engine);
+        }
+        record_emit(&rec);
+        return;
+    }
+    
+    report_printf("\n=== Wipe Result for %s ===\n", target->path);
+    report_printf("Engine: %s%s (%s buffers, %s file), queue depth %d\n",
+           result->engine ? result->engine : "none", target->direct ? " + O_DIRECT" : "",
+           result->fixed_buffers ? "registered" : "unregistered",
+           result->fixed_files ? "registered" : "unregistered", options->queue_depth);
+    if (options->pattern == WIPE_PATTERN_RANDOM) {
+        char seed[65] = "";
+        pattern_key_format(&options->seed, seed, sizeof(seed));
+        report_printf("Pattern: random (ChaCha%d keystream, %s), seed %s\n", CHACHA_ROUNDS, pattern_engine, seed);
+    } else {
+        report_printf("Pattern: %s\n", wipe_pattern_name(options->pattern));
+    }
+    if (result->resumed_from) {
+        report_printf("Resumed: continued at offset %llu from the checkpoint journal\n", result->resumed_from);
+    }
+    report_printf("Written: %llu of %llu bytes in %.2f s (%.1f MB/s)\n",
+           result->bytes, target->size, result->seconds, mb_per_second);
+    if (result->error) {
+        report_printf("❌ Wipe FAILED at offset %llu: %s\n", result->error_offset, strerror(result->error));
+        if (result->journaled) {
+            report_printf("Checkpoint: %llu bytes are on the media, run the same command again to resume\n",
+                   result->durable);
+        }
+    } else {
+        report_printf("✓ Wipe completed\n");
+    }
+}
+
+static void report_sanitize_result(const struct wipe_target* target, const struct wipe_options* options,
+                                   const struct wipe_result* result) {
+    double mb_per_second = result->seconds > 0 ? result->bytes / result->seconds / 1e6 : 0.0;
+    
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "sanitize");
+        record_string(&rec, "path", target->path);
+        record_string(&rec, "status", result->error ? "error" : "ok");
+        if (result->error) {
+            record_string(&rec, "message", strerror(result->error));
+            record_uint(&rec, "error_offset", result->error_offset);
+        }
+        record_string(&rec, "requested", wipe_method_name(options->method));
+        record_string(&rec, "method", wipe_method_name(result->method));
+        record_string(&rec, "engine", result->engine);
+        record_uint(&rec, "size_bytes", target->size);
+        record_uint(&rec, "bytes_sanitized", result->bytes);
+        record_uint(&rec, "chunk_size", result->chunk_size);
+        record_uint(&rec, "tail_zeroed_bytes", result->tail_bytes);
+        record_key(&rec, "seconds");
+        buffer_printf(&rec.buf, "%.3f", result->seconds);
+        record_key(&rec, "mb_per_second");
+        buffer_printf(&rec.buf, "%.1f", mb_per_second);
+        record_emit(&rec);
+        return;
+    }
+    
+    report_printf("\n=== Sanitize Result for %s ===\n", target->path);
+    report_printf("Method: %s via %s (requested %s), %llu-byte chunks\n", wipe_method_name(result->method),
+           result->engine ? result->engine : "none", wipe_method_name(options->method), result->chunk_size);
+    if (result->tail_bytes) {
+        report_printf("Unaligned end: %llu bytes past the last whole granule zeroed with BLKZEROOUT\n",
+               result->tail_bytes);
+    }
+    report_printf("Sanitized: %llu of %llu bytes in %.2f s (%.1f MB/s)\n",
+           result->bytes, target->size, result->seconds, mb_per_second);
+    if (result->error) {
+        report_printf("❌ Sanitize FAILED at offset %llu: %s\n", result->error_offset, strerror(result->error));
+        return;
+    }
+    report_printf("✓ Sanitize completed\n");
+    if (target->is_block && (result->method == WIPE_METHOD_DISCARD || result->method == WIPE_METHOD_SECURE_DISCARD ||
+                             result->method == WIPE_METHOD_UNMAP)) {
+        report_printf("Note: discarded blocks are not guaranteed to read back as zeroes, --verify checks them\n");
+    }
+}
+
+#define VERIFY_REPORT_RANGES 32
+
+static void report_verify_result(const struct wipe_target* target, const struct wipe_options* options,
+                                 const struct wipe_result* result, const struct verify_result* verify) {
+    double mb_per_second = result->seconds > 0 ? result->bytes / result->seconds / 1e6 : 0.0;
+    unsigned long long blocks = (target->size + target->logical_block_size - 1) / target->logical_block_size;
+    double coverage = verify->units ? 100.0 * verify->units_read / verify->units : 100.0;
+    if (verify->sampled) {
+        blocks = (result->bytes + target->logical_block_size - 1) / target->logical_block_size;
+    }
+    
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "verify");
+        record_string(&rec, "path", target->path);
+        record_string(&rec, "status", result->error ? "error" : verify->mismatched_blocks ? "mismatch" : "ok");
+        if (result->error) {
+            record_string(&rec, "message", strerror(result->error));
+            record_uint(&rec, "error_offset", result->error_offset);
+        }
+        record_string(&rec, "pattern", wipe_pattern_name(options->pattern));
+        record_uint(&rec, "size_bytes", target->size);
+        record_uint(&rec, "bytes_read", result->bytes);
+        record_key(&rec, "seconds");
+        buffer_printf(&rec.buf, "%.3f", result->seconds);
+        record_key(&rec, "mb_per_second");
+        buffer_printf(&rec.buf, "%.1f", mb_per_second);
+        record_string(&rec, "engine", result->engine);
+        record_bool(&rec, "direct", target->direct);
+        record_int(&rec, "block_size", target->logical_block_size);
+        record_uint(&rec, "mismatched_blocks", verify->mismatched_blocks);
+        record_bool(&rec, "sampled", verify->sampled);
+        if (verify->sampled) {
+            record_key(&rec, "confidence");
+            buffer_printf(&rec.buf, "%g", options->sample_confidence);
+            record_key(&rec, "tolerance");
+            buffer_printf(&rec.buf, "%g", options->sample_tolerance);
+            record_uint(&rec, "unit_size", verify->unit_size);
+            record_uint(&rec, "units", verify->units);
+            record_uint(&rec, "random_units", verify->random_units);
+            record_uint(&rec, "units_read", verify->units_read);
+            record_key(&rec, "coverage");
+            buffer_printf(&rec.buf, "%.4f", coverage);
+            record_uint(&rec, "expanded_units", verify->expanded_units);
+            record_int(&rec, "expanded_regions", verify->expanded_regions);
+        }
+        // [first LBA, block count] pairs
+        record_key(&rec, "mismatch_ranges");
+        buffer_printf(&rec.buf, "[");
+        for (int i = 0; i < verify->range_count; i++) {
+            buffer_printf(&rec.buf, "%s[%llu,%llu]", i ? "," : "", verify->ranges[i].start, verify->ranges[i].count);
+        }
+        buffer_printf(&rec.buf, "]");
+        record_emit(&rec);
+        return;
+    }
+    
+    report_printf("\n=== Verification of %s ===\n", target->path);
+    report_printf("Engine: %s%s, queue depth %d\n", result->engine ? result->engine : "none",
+           target->direct ? " + O_DIRECT" : "", options->queue_depth);
+    report_printf("Read: %llu of %llu bytes in %.2f s (%.1f MB/s)\n",
+           result->bytes, target->size, result->seconds, mb_per_second);
+    if (verify->sampled) {
+        report_printf("Sampled: %llu random units of %llu KiB plus the first and last %llu MiB, "
+                      "%llu of %llu units read (%.3f%% coverage)\n",
+                      verify->random_units, verify->unit_size / 1024, VERIFY_SAMPLE_REGION / (1024 * 1024),
+                      verify->units_read, verify->units, coverage);
+        if (verify->expanded_regions) {
+            report_printf("Re-read %llu units around %d mismatching region%s\n", verify->expanded_units,
+                          verify->expanded_regions, verify->expanded_regions == 1 ? "" : "s");
+        }
+    }
+    if (result->error) {
+        report_printf("❌ Verification FAILED at offset %llu: %s\n", result->error_offset, strerror(result->error));
+    }
+    if (verify->mismatched_blocks == 0) {
+        if (!result->error) {
+            report_printf("✓ All %llu %sblocks (%d bytes) hold the %s pattern\n",
+                   blocks, verify->sampled ? "sampled " : "", target->logical_block_size,
+                   wipe_pattern_name(options->pattern));
+            if (verify->sampled) {
+                report_printf("Confidence: %g%% that no more than %g%% of the units differ from the pattern\n",
+                              options->sample_confidence, options->sample_tolerance);
+            }
+        }
+        return;
+    }
+    report_printf("❌ %llu of %llu %sblocks (%d bytes) do not hold the %s pattern:\n",
+           verify->mismatched_blocks, blocks, verify->sampled ? "sampled " : "", target->logical_block_size,
+           wipe_pattern_name(options->pattern));
+    for (int i = 0; i < verify->range_count && i < VERIFY_REPORT_RANGES; i++) {
+        const struct lba_range *range = &verify->ranges[i];
+        if (range->count == 1) {
+            report_printf("  LBA %llu\n", range->start);
+        } else {
+            report_printf("  LBA %llu-%llu (%llu blocks)\n", range->start, range->start + range->count - 1, range->count);
+        }
+    }
+    if (verify->range_count > VERIFY_REPORT_RANGES) {
+        report_printf("  ... and %d more ranges\n", verify->range_count - VERIFY_REPORT_RANGES);
+    }
+}
+
+static void report_open_error(const char* path, int ret) {
+    if (ret == -EBUSY) {
+        report_printf("Cannot wipe %s: device is in use (mounted or held by another driver)\n", path);
+    } else if (ret == -ENOTSUP) {
+        report_printf("Cannot wipe %s: only block devices and regular files can be wiped\n", path);
+    } else {
+        report_printf("Cannot open %s: %s\n", path, strerror(-ret));
+    }
+}
+
+// Overwrite and/or read back one target; reports go through report_printf.
+// Returns the process exit status for this target.
+static int wipe_run_target(const char* path, const struct device_profile* profile,
+                           const struct wipe_options* shared_options, int wipe, int verify) {
+    struct wipe_target target;
+    struct wipe_result result;
+    unsigned long long resumed_from = 0;
+    // Resuming from the journal may bring back the seed of the interrupted run
+    struct wipe_options run_options = *shared_options;
+    const struct wipe_options *options = &run_options;
+    if (wipe) {
+        int ret = wipe_open_target(path, profile, 1, &target);
+        if (ret < 0) {
+            report_open_error(path, ret);
+            return 1;
+        }
+        if (options->method != WIPE_METHOD_OVERWRITE) {
+            wipe_sanitize_run(&target, profile, options, &result);
+            report_sanitize_result(&target, options, &result);
+        } else {
+            struct wipe_journal journal;
+            wipe_journal_open(&journal, &target, profile, &run_options);
+            wipe_target_run(&target, options, &result, NULL, &journal);
+            wipe_journal_close(&journal, !result.error);
+            report_wipe_result(&target, options, &result);
+            resumed_from = result.resumed_from;
+        }
+        close(target.fd);
+        if (result.error) {
+            return 1;
+        }
+    }
+    if (!verify) {
+        return 0;
+    }
+    
+    int ret = wipe_open_target(path, profile, 0, &target);
+    if (ret < 0) {
+        report_open_error(path, ret);
+        return 1;
+    }
+    struct verify_result check;
+    memset(&check, 0, sizeof(check));
+    // A sampled verify reads where an interrupted wipe picked up again in full
+    check.focus = resumed_from;
+    check.scratch = (unsigned char*)malloc(VERIFY_CHUNK_SIZE);
+    if (!check.scratch) {
+        memset(&result, 0, sizeof(result));
+        result.error = ENOMEM;
+    } else {
+        wipe_target_run(&target, options, &result, &check, NULL);
+    }
+    verify_merge_ranges(&check);
+    report_verify_result(&target, options, &result, &check);
+    int status = result.error || check.mismatched_blocks ? 1 : 0;
+    free(check.ranges);
+    free(check.scratch);
+    close(target.fd);
+    return status;
+}
+
+// Device path of a target argument and, for block devices, its /sys/block name
+static int wipe_resolve_target(const char* target_arg, char* path, size_t path_size, char* name, size_t name_size) {
+    struct stat st;
+    if (target_arg[0] == '/') {
+        snprintf(path, path_size, "%s", target_arg);
+    } else {
+        snprintf(path, path_size, "/dev/%s", target_arg);
+    }
+    name[0] = '\0';
+    if (stat(path, &st) != 0) {
+        return -errno;
+    }
+    if (S_ISBLK(st.st_mode) && wipe_block_name(st.st_rdev, name, name_size) != 0) {
+        snprintf(name, name_size, "%s", strrchr(path, '/') + 1);
+    }
+    return 0;
+}
+
+// The random pattern needs its seed before any target is touched
+static int wipe_prepare_pattern(struct wipe_options* options, int wipe) {
+    pattern_dispatch_init();
+    if (options->pattern != WIPE_PATTERN_RANDOM) {
+        return 0;
+    }
+    if (!wipe && !options->seed_given) {
+        printf("Verifying a random pattern needs the --seed of the wipe\n");
+        return -1;
+    }
+    int ret = wipe_options_seed(options);
+    if (ret < 0) {
+        printf("Cannot seed the random pattern: %s\n", strerror(-ret));
+        return -1;
+    }
+    return 0;
+}
+
+// --wipe / --verify: identify the target like a normal device report, then
+// overwrite it and/or read it back. Returns the process exit status.
+static int wipe_command(const char* target_arg, struct wipe_options* options, int wipe, int verify) {
+    char path[512];
+    char name[256];
+    
+    if (wipe_prepare_pattern(options, wipe) != 0) {
+        return 1;
+    }
+    int ret = wipe_resolve_target(target_arg, path, sizeof(path), name, sizeof(name));
+    if (ret < 0) {
+        printf("Cannot access %s: %s\n", path, strerror(-ret));
+        return 1;
+    }
+    
+    struct device_profile *profile = NULL;
+    if (name[0]) {
+        profile = (struct device_profile*)malloc(sizeof(struct device_profile));
+        if (profile) {
+            probe_device_profile(name, profile);
+            if (output_format != OUTPUT_TEXT) {
+                emit_device_record(profile);
+            } else {
+                report_device_profile(profile);
             }
-            
-            // Product ID
-            snprintf(vendor_path, sizeof(vendor_path), "%s/idProduct", usb_device_path);
-            fp = fopen(vendor_path, "r");
-            if (fp) {
-                if (fgets(buffer, sizeof(buffer), fp)) {
-                    buffer[strcspn(buffer, "\n")] = 0;
-                    printf("Product ID: %s\n", buffer);
-                }
-                fclose(fp);
+            inventory_cache_save();
+        }
+    }
+    struct wipe_telemetry_set telemetry;
+    if (wipe_telemetry_start(&telemetry, 1, options->status_interval, options->metrics_path) != 0) {
+        free(profile);
+        printf("Out of memory\n");
+        return 1;
+    }
+    wipe_telemetry_target(&telemetry, 0, path, name);
+    wipe_telemetry_run(&telemetry);
+    wipe_telemetry_current = &telemetry.targets[0];
+    int status = wipe_run_target(path, profile, options, wipe, verify);
+    wipe_telemetry_current = NULL;
+    wipe_telemetry_stop(&telemetry);
+    free(profile);
+    return status;
+}
+
+// ---------------------------------------------------------------------------
+// Multi-target wipe scheduler
+// ---------------------------------------------------------------------------
+
+// Targets behind the same bottleneck (USB host controller, PCIe root port,
+// storage controller) share its bandwidth. Each such group gets as many concurrent
+// streams as its estimated bandwidth holds; idle workers steal targets from
+// other groups that still have room.
+
+#define WIPE_MAX_TARGETS 256
+
+enum wipe_group_kind {
+    GROUP_STANDALONE,                   // file or unknown topology, nothing shared
+    GROUP_USB_BUS,
+    GROUP_PCIE_ROOT_PORT,
+    GROUP_CONTROLLER
+};
+
+struct wipe_job {
+    char path[512];
+    char name[256];
+    struct device_profile *profile;
+    unsigned long long size;
+    double device_mb_s;                 // estimated throughput of the target alone, 0 if unknown
+    int group;
+    int status;
+    double seconds;
+    struct report_buffer report;
+};
+
+struct wipe_group {
+    char key[512];                      // shared upstream device, relative to the sysfs root
+    enum wipe_group_kind kind;
+    double bandwidth_mb_s;              // estimated shared bandwidth, 0 if unknown
+    int limit;                          // concurrent streams
+    int active;
+    int *pending;                       // job indices, largest first
+    int pending_count;
+    int next;
+    unsigned long long pending_bytes;
+};
+
+struct wipe_schedule {
+    struct wipe_job *jobs;
+    int job_count;
+    struct wipe_group *groups;
+    int group_count;
+    const struct wipe_options *options;
+    int wipe;
+    int verify;
+    struct wipe_telemetry_set telemetry;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+};
+
+struct wipe_worker {
+    struct wipe_schedule *schedule;
+    int home;                           // group served first
+};
+
+static int is_pci_address(const char* name) {
+    unsigned int domain, bus, slot, function;
+    char extra;
+    return strlen(name) == 12 &&
+           sscanf(name, "%4x:%2x:%2x.%1x%c", &domain, &bus, &slot, &function, &extra) == 4;
+}
+
+// Usable payload bandwidth of a USB link from its "speed" attribute (Mbit/s)
+static double usb_link_mb_s(const struct usb_device_record* usb) {
+    if (!(usb->present & USB_ATTR_SPEED)) {
+        return 0.0;
+    }
+    double mbit = atof(usb->speed);
+    // Bulk transfers reach roughly 55% of the signalling rate on USB 2.0,
+    // 65% on SuperSpeed after encoding and protocol overhead
+    return mbit * (mbit > 480 ? 0.65 : 0.55) / 8.0;
+}
+
+// Bandwidth of a PCIe link from current_link_speed ("8.0 GT/s PCIe") and width
+static double pcie_link_mb_s(int dir_fd) {
+    char speed[64];
+    if (sysfs_read_attr(dir_fd, "current_link_speed", speed, sizeof(speed)) < 0) {
+        return 0.0;
+    }
+    double gt = atof(speed);
+    long long width = sysfs_read_number(dir_fd, "current_link_width");
+    if (gt <= 0 || width <= 0) {
+        return 0.0;
+    }
+    // 8b/10b encoding up to 5 GT/s, 128b/130b from 8 GT/s on
+    double lane = gt >= 8.0 ? gt * 1000.0 / 8.0 * 128.0 / 130.0 : gt * 1000.0 / 10.0;
+    return lane * (double)width;
+}
+
+// Work out which group a probed target belongs to and estimate the bandwidth
+// of that group and of the target itself
+static void wipe_job_topology(const struct wipe_job* job, struct wipe_group* group, double* device_mb_s) {
+    const struct device_profile *profile = job->profile;
+    memset(group, 0, sizeof(*group));
+    group->kind = GROUP_STANDALONE;
+    snprintf(group->key, sizeof(group->key), "%s", job->path);
+    *device_mb_s = 0.0;
+    if (!profile || !profile->link_valid) {
+        return;
+    }
+    
+    const struct usb_topology *topology = profile->usb_bus_id[0] ? usb_topology_get() : NULL;
+    int usb_index = topology ? usb_topology_find(topology, profile->usb_bus_id) : -1;
+    if (usb_index >= 0) {
+        // Every device below one root hub (usbN) shares the host controller
+        // and the hubs chained in between; the slowest link on the way up
+        // bounds the group
+        const struct usb_device_record *usb = &topology->devices[usb_index];
+        const struct usb_device_record *root = usb;
+        *device_mb_s = usb_link_mb_s(usb);
+        for (int parent = usb->parent; parent >= 0; parent = topology->devices[parent].parent) {
+            root = &topology->devices[parent];
+            double hub_mb_s = usb_link_mb_s(root);
+            if (hub_mb_s > 0 && (group->bandwidth_mb_s == 0.0 || hub_mb_s < group->bandwidth_mb_s)) {
+                group->bandwidth_mb_s = hub_mb_s;
             }
-            
-            // Manufacturer
-            snprintf(vendor_path, sizeof(vendor_path), "%s/manufacturer", usb_device_path);
-            fp = fopen(vendor_path, "r");
-            if (fp) {
-                if (fgets(buffer, sizeof(buffer), fp)) {
-                    buffer[strcspn(buffer, "\n")] = 0;
-                    printf("Manufacturer: %s\n", buffer);
-                }
-                fclose(fp);
+        }
+        snprintf(group->key, sizeof(group->key), "%s", root->path);
+        group->kind = GROUP_USB_BUS;
+        // Flash sticks rarely write as fast as their link: assume typical
+        // sustained write speeds so a hub runs a few of them side by side
+        if (profile->removable == 1 && profile->rotational != 1) {
+            double flash_mb_s = *device_mb_s > 60.0 ? 150.0 : 15.0;
+            if (*device_mb_s == 0.0 || *device_mb_s > flash_mb_s) {
+                *device_mb_s = flash_mb_s;
             }
-            
-            // Product
-            snprintf(vendor_path, sizeof(vendor_path), "%s/product", usb_device_path);
-            fp = fopen(vendor_path, "r");
-            if (fp) {
-                if (fgets(buffer, sizeof(buffer), fp)) {
-                    buffer[strcspn(buffer, "\n")] = 0;
-                    printf("Product: %s\n", buffer);
+        }
+        return;
+    }
+    
+    // Walk ../devices/pci0000:00/<root port>/.../<function>/... and remember
+    // the first and the last PCI function on the way
+    char link[512];
+    char root_port[512] = "";
+    char function[512] = "";
+    char walked[512] = "devices";
+    char *save_ptr = NULL;
+    snprintf(link, sizeof(link), "%s", profile->sysfs_link);
+    for (char *part = strtok_r(link, "/", &save_ptr); part; part = strtok_r(NULL, "/", &save_ptr)) {
+        if (strcmp(part, "..") == 0 || (strcmp(part, "devices") == 0 && strcmp(walked, "devices") == 0)) {
+            continue;
+        }
+        size_t used = strlen(walked);
+        snprintf(walked + used, sizeof(walked) - used, "/%s", part);
+        if (is_pci_address(part)) {
+            if (!root_port[0]) {
+                snprintf(root_port, sizeof(root_port), "%s", walked);
+            }
+            snprintf(function, sizeof(function), "%s", walked);
+        }
+    }
+    if (!function[0]) {
+        return;
+    }
+    
+    int function_fd = sysfs_open_dir(function);
+    double function_mb_s = function_fd >= 0 ? pcie_link_mb_s(function_fd) : 0.0;
+    if (function_fd >= 0) {
+        close(function_fd);
+    }
+    if (profile->interface == IFACE_NVME) {
+        int port_fd = sysfs_open_dir(root_port);
+        group->bandwidth_mb_s = port_fd >= 0 ? pcie_link_mb_s(port_fd) : 0.0;
+        if (port_fd >= 0) {
+            close(port_fd);
+        }
+        group->kind = GROUP_PCIE_ROOT_PORT;
+        snprintf(group->key, sizeof(group->key), "%s", root_port);
+        *device_mb_s = function_mb_s;
+    } else {
+        // SATA/SAS ports and virtio queues share the controller's link
+        group->bandwidth_mb_s = function_mb_s;
+        group->kind = GROUP_CONTROLLER;
+        snprintf(group->key, sizeof(group->key), "%s", function);
+        *device_mb_s = profile->interface == IFACE_SATA ? 550.0 : 0.0;
+    }
+    // Spinning disks are limited by the platters, not the link
+    if (profile->rotational == 1 && (*device_mb_s == 0.0 || *device_mb_s > 250.0)) {
+        *device_mb_s = 250.0;
+    }
+}
+
+static int wipe_job_compare_size(const void* a, const void* b, void* arg) {
+    const struct wipe_job *jobs = (const struct wipe_job*)arg;
+    unsigned long long x = jobs[*(const int*)a].size;
+    unsigned long long y = jobs[*(const int*)b].size;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+// Group the jobs and size each group's stream limit; group_streams > 0 overrides it
+static int wipe_schedule_build(struct wipe_schedule* schedule, int group_streams) {
+    schedule->groups = (struct wipe_group*)calloc(schedule->job_count, sizeof(struct wipe_group));
+    if (!schedule->groups) {
+        return -1;
+    }
+    for (int i = 0; i < schedule->job_count; i++) {
+        struct wipe_job *job = &schedule->jobs[i];
+        struct wipe_group found;
+        wipe_job_topology(job, &found, &job->device_mb_s);
+        
+        int g = 0;
+        while (g < schedule->group_count && strcmp(schedule->groups[g].key, found.key) != 0) {
+            g++;
+        }
+        if (g == schedule->group_count) {
+            schedule->groups[g] = found;
+            schedule->groups[g].pending = (int*)calloc(schedule->job_count, sizeof(int));
+            if (!schedule->groups[g].pending) {
+                return -1;
+            }
+            schedule->group_count++;
+        }
+        struct wipe_group *group = &schedule->groups[g];
+        // Members reach the shared device over different paths: keep the slowest
+        if (found.bandwidth_mb_s > 0 &&
+            (group->bandwidth_mb_s == 0.0 || found.bandwidth_mb_s < group->bandwidth_mb_s)) {
+            group->bandwidth_mb_s = found.bandwidth_mb_s;
+        }
+        group->pending[group->pending_count++] = i;
+        group->pending_bytes += job->size;
+        job->group = g;
+    }
+    
+    for (int g = 0; g < schedule->group_count; g++) {
+        struct wipe_group *group = &schedule->groups[g];
+        // Largest targets first so the group does not end on a long tail
+        qsort_r(group->pending, group->pending_count, sizeof(int), wipe_job_compare_size, schedule->jobs);
+        
+        double device_mb_s = schedule->jobs[group->pending[0]].device_mb_s;
+        if (group_streams > 0) {
+            group->limit = group_streams;
+        } else if (group->bandwidth_mb_s > 0 && device_mb_s > 0) {
+            group->limit = (int)(group->bandwidth_mb_s / device_mb_s + 0.5);
+        } else {
+            group->limit = group->pending_count;
+        }
+        if (group->limit < 1) {
+            group->limit = 1;
+        }
+        if (group->limit > group->pending_count) {
+            group->limit = group->pending_count;
+        }
+    }
+    return 0;
+}
+
+// Next job for a worker: its home group first, otherwise steal from the group
+// with the most bytes left that is below its stream limit. -1 when nothing is
+// runnable right now, -2 when every job has been handed out.
+static int wipe_schedule_take(struct wipe_schedule* schedule, int home) {
+    int best = -1;
+    int any_pending = 0;
+    for (int g = 0; g < schedule->group_count; g++) {
+        struct wipe_group *group = &schedule->groups[g];
+        if (group->next >= group->pending_count) {
+            continue;
+        }
+        any_pending = 1;
+        if (group->active >= group->limit) {
+            continue;
+        }
+        if (g == home) {
+            best = g;
+            break;
+        }
+        if (best < 0 || group->pending_bytes > schedule->groups[best].pending_bytes) {
+            best = g;
+        }
+    }
+    if (best < 0) {
+        return any_pending ? -1 : -2;
+    }
+    struct wipe_group *group = &schedule->groups[best];
+    int job = group->pending[group->next++];
+    group->active++;
+    group->pending_bytes -= schedule->jobs[job].size;
+    return job;
+}
+
+static void* wipe_schedule_worker(void* arg) {
+    struct wipe_worker *worker = (struct wipe_worker*)arg;
+    struct wipe_schedule *schedule = worker->schedule;
+    
+    pthread_mutex_lock(&schedule->lock);
+    while (1) {
+        int index = wipe_schedule_take(schedule, worker->home);
+        if (index == -2) {
+            break;
+        }
+        if (index == -1) {
+            pthread_cond_wait(&schedule->changed, &schedule->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&schedule->lock);
+        
+        struct wipe_job *job = &schedule->jobs[index];
+        double start = monotonic_seconds();
+        current_report = &job->report;
+        wipe_telemetry_current = schedule->telemetry.targets ? &schedule->telemetry.targets[index] : NULL;
+        job->status = wipe_run_target(job->path, job->profile, schedule->options,
+                                      schedule->wipe, schedule->verify);
+        wipe_telemetry_current = NULL;
+        current_report = NULL;
+        job->seconds = monotonic_seconds() - start;
+        
+        pthread_mutex_lock(&schedule->lock);
+        schedule->groups[job->group].active--;
+        if (job->report.len > 0) {
+            fwrite(job->report.data, 1, job->report.len, stdout);
+            fflush(stdout);
+        }
+        pthread_cond_broadcast(&schedule->changed);
+    }
+    pthread_mutex_unlock(&schedule->lock);
+    return NULL;
+}
+
+static const char* wipe_group_kind_name(enum wipe_group_kind kind) {
+    switch (kind) {
+        case GROUP_USB_BUS: return "usb-bus";
+        case GROUP_PCIE_ROOT_PORT: return "pcie-root-port";
+        case GROUP_CONTROLLER: return "controller";
+        default: return "standalone";
+    }
+}
+
+static void report_wipe_plan(const struct wipe_schedule* schedule, int streams) {
+    if (output_format != OUTPUT_TEXT) {
+        for (int g = 0; g < schedule->group_count; g++) {
+            const struct wipe_group *group = &schedule->groups[g];
+            struct record rec;
+            record_begin(&rec, "wipe_group");
+            record_string(&rec, "kind", wipe_group_kind_name(group->kind));
+            record_string(&rec, "key", group->key);
+            record_int(&rec, "bandwidth_mb_s", (long long)group->bandwidth_mb_s);
+            record_int(&rec, "streams", group->limit);
+            record_key(&rec, "targets");
+            buffer_printf(&rec.buf, "[");
+            for (int i = 0; i < group->pending_count; i++) {
+                buffer_printf(&rec.buf, "%s", i ? "," : "");
+                record_put_string(&rec, schedule->jobs[group->pending[i]].path);
+            }
+            buffer_printf(&rec.buf, "]");
+            record_emit(&rec);
+        }
+        return;
+    }
+    
+    printf("=== Wipe Plan: %d targets in %d groups, %d concurrent streams ===\n",
+           schedule->job_count, schedule->group_count, streams);
+    for (int g = 0; g < schedule->group_count; g++) {
+        const struct wipe_group *group = &schedule->groups[g];
+        if (group->kind == GROUP_STANDALONE) {
+            printf("Group %d: %s %s\n", g + 1, wipe_group_kind_name(group->kind), group->key);
+        } else {
+            printf("Group %d: %s %s/%s\n", g + 1, wipe_group_kind_name(group->kind), sysfs_root, group->key);
+        }
+        if (group->bandwidth_mb_s > 0) {
+            printf("  Shared bandwidth: ~%.0f MB/s, %d concurrent stream%s\n",
+                   group->bandwidth_mb_s, group->limit, group->limit == 1 ? "" : "s");
+        } else {
+            printf("  Shared bandwidth: unknown, %d concurrent stream%s\n",
+                   group->limit, group->limit == 1 ? "" : "s");
+        }
+        for (int i = 0; i < group->pending_count; i++) {
+            const struct wipe_job *job = &schedule->jobs[group->pending[i]];
+            printf("  %-24s %8.2f GB", job->path, job->size / (1024.0 * 1024.0 * 1024.0));
+            if (job->device_mb_s > 0) {
+                printf("  (~%.0f MB/s alone)", job->device_mb_s);
+            }
+            printf("\n");
+        }
+    }
+}
+
+// --wipe with several targets: probe all of them, group them by shared
+// upstream bandwidth and run the group-limited streams on a worker pool.
+// streams caps the pool (0 = the sum of the group limits).
+static int wipe_schedule_command(const char** targets, int count, struct wipe_options* options,
+                                 int wipe, int verify, int streams, int group_streams) {
+    if (wipe_prepare_pattern(options, wipe) != 0) {
+        return 1;
+    }
+    struct wipe_schedule schedule;
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.options = options;
+    schedule.wipe = wipe;
+    schedule.verify = verify;
+    schedule.jobs = (struct wipe_job*)calloc(count, sizeof(struct wipe_job));
+    if (!schedule.jobs) {
+        printf("Out of memory while planning the wipe\n");
+        return 1;
+    }
+    schedule.job_count = count;
+    
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++) {
+        struct wipe_job *job = &schedule.jobs[i];
+        int ret = wipe_resolve_target(targets[i], job->path, sizeof(job->path), job->name, sizeof(job->name));
+        if (ret < 0) {
+            printf("Cannot access %s: %s\n", job->path, strerror(-ret));
+            status = 1;
+            break;
+        }
+        struct stat st;
+        if (stat(job->path, &st) == 0 && S_ISREG(st.st_mode)) {
+            job->size = (unsigned long long)st.st_size;
+        }
+        if (job->name[0]) {
+            job->profile = (struct device_profile*)malloc(sizeof(struct device_profile));
+            if (job->profile) {
+                probe_device_profile(job->name, job->profile);
+                if (job->profile->sectors >= 0) {
+                    job->size = (unsigned long long)job->profile->sectors * 512;
                 }
-                fclose(fp);
             }
-            
-            // Speed
-            snprintf(vendor_path, sizeof(vendor_path), "%s/speed", usb_device_path);
-            fp = fopen(vendor_path, "r");
-            if (fp) {
-                if (fgets(buffer, sizeof(buffer), fp)) {
-                    buffer[strcspn(buffer, "\n")] = 0;
-                    printf("Speed: %s Mbps\n", buffer);
+        }
+    }
+    if (status == 0) {
+        inventory_cache_save();
+        if (wipe_schedule_build(&schedule, group_streams) != 0) {
+            printf("Out of memory while planning the wipe\n");
+            status = 1;
+        }
+    }
+    
+    if (status == 0) {
+        int total = 0;
+        for (int g = 0; g < schedule.group_count; g++) {
+            total += schedule.groups[g].limit;
+        }
+        if (streams <= 0 || streams > total) {
+            streams = total;
+        }
+        report_wipe_plan(&schedule, streams);
+        
+        // Status lines of all targets come from one reporter thread
+        if (wipe_telemetry_start(&schedule.telemetry, count, options->status_interval, options->metrics_path) == 0) {
+            for (int i = 0; i < count; i++) {
+                wipe_telemetry_target(&schedule.telemetry, i, schedule.jobs[i].path, schedule.jobs[i].name);
+            }
+            wipe_telemetry_run(&schedule.telemetry);
+        }
+        pthread_mutex_init(&schedule.lock, NULL);
+        pthread_cond_init(&schedule.changed, NULL);
+        pthread_t *threads = (pthread_t*)calloc(streams, sizeof(pthread_t));
+        struct wipe_worker *workers = (struct wipe_worker*)calloc(streams, sizeof(struct wipe_worker));
+        int started = 0;
+        double start = monotonic_seconds();
+        int *homes = (int*)calloc(schedule.group_count, sizeof(int));
+        if (threads && workers && homes) {
+            // Spread home groups round-robin, at most a group's limit each;
+            // with fewer streams than that the rest is reached by stealing
+            int g = 0;
+            for (int i = 0; i < streams; i++) {
+                while (homes[g] >= schedule.groups[g].limit) {
+                    g = (g + 1) % schedule.group_count;
+                }
+                homes[g]++;
+                workers[i].schedule = &schedule;
+                workers[i].home = g;
+                g = (g + 1) % schedule.group_count;
+                if (pthread_create(&threads[started], NULL, wipe_schedule_worker, &workers[i]) == 0) {
+                    started++;
                 }
-                fclose(fp);
             }
-            
-            // Analyze if it's a mobile device
-            analyze_mobile_device_type(usb_device_path);
         }
+        free(homes);
+        if (started == 0) {
+            struct wipe_worker worker = { &schedule, 0 };
+            wipe_schedule_worker(&worker);
+        }
+        for (int i = 0; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        double seconds = monotonic_seconds() - start;
+        wipe_telemetry_stop(&schedule.telemetry);
+        free(threads);
+        free(workers);
+        pthread_cond_destroy(&schedule.changed);
+        pthread_mutex_destroy(&schedule.lock);
         
-        closedir(usb_dir);
+        int failed = 0;
+        unsigned long long bytes = 0;
+        for (int i = 0; i < count; i++) {
+            failed += schedule.jobs[i].status != 0;
+            bytes += schedule.jobs[i].size;
+        }
+        double mb_per_second = seconds > 0 ? bytes / seconds / 1e6 : 0.0;
+        if (output_format != OUTPUT_TEXT) {
+            struct record rec;
+            record_begin(&rec, "summary");
+            record_string(&rec, "scope", "wipe");
+            record_int(&rec, "count", count);
+            record_int(&rec, "failed", failed);
+            record_key(&rec, "seconds");
+            buffer_printf(&rec.buf, "%.3f", seconds);
+            record_key(&rec, "mb_per_second");
+            buffer_printf(&rec.buf, "%.1f", mb_per_second);
+            record_emit(&rec);
+        } else {
+            printf("\n=== Wipe Summary ===\n");
+            for (int i = 0; i < count; i++) {
+                printf("  %-24s %s (%.1f s)\n", schedule.jobs[i].path,
+                       schedule.jobs[i].status ? "❌ FAILED" : "✓ OK", schedule.jobs[i].seconds);
+            }
+            printf("%d of %d targets completed in %.1f s (%.1f MB/s per pass across the station)\n",
+                   count - failed, count, seconds, mb_per_second);
+        }
+        status = failed ? 1 : 0;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        free(schedule.jobs[i].profile);
+        free(schedule.jobs[i].report.data);
+    }
+    for (int g = 0; g < schedule.group_count; g++) {
+        free(schedule.groups[g].pending);
+    }
+    free(schedule.groups);
+    free(schedule.jobs);
+    return status;
+}
+#endif
+
+#ifdef __linux__
+// ---------------------------------------------------------------------------
+// Scan benchmark (--bench-scan)
+// ---------------------------------------------------------------------------
+//
+// Builds a synthetic sysfs and /dev tree with N devices in a temporary
+// directory: SATA disks behind AHCI, USB sticks and phones behind a tree of
+// hubs, and NVMe namespaces on their own root ports, linked the way the kernel
+// links /sys/block and /sys/bus/usb/devices. A stub smartctl script stands in
+// for the external tool. The block and USB scans then run
+// against the tree with their output discarded, and wall time, system calls
+// and heap allocations are reported per device.
+
+#define BENCH_MAX_DEVICES   4096
+
+// Heap bytes in use (mallinfo2), sampled around each scan. The allocator
+// itself is left alone, so this is the heap a scan keeps, not its churn.
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+#define BENCH_HEAP_BYTES 1
+static long long bench_heap_in_use(void) {
+    struct mallinfo2 info = mallinfo2();
+    return (long long)(info.uordblks + info.hblkhd);
+}
+#endif
+
+struct bench_sample {
+    double seconds;
+    long long syscalls;                 // -1 when neither counter is available
+    long long heap_bytes;               // growth of the heap in use
+    int heap_valid;                     // 0 without mallinfo2
+};
+
+struct bench_result {
+    const char *scan;
+    int devices;
+    int runs;
+    double median_seconds;
+    double min_seconds;
+    double syscalls;                    // per scan
+    double heap_bytes;                  // per scan
+    int heap_valid;                     // 0 without mallinfo2
+    const char *syscall_source;         // "perf" (every system call) or "proc-io" (read/write only)
+};
+
+static int bench_write_file(const char* root, const char* path, const char* content) {
+    char full[1024];
+    snprintf(full, sizeof(full), "%s/%s", root, path);
+    char *slash = strrchr(full, '/');
+    *slash = '\0';
+    if (make_directories(full) != 0) {
+        return -1;
+    }
+    *slash = '/';
+    FILE *fp = fopen(full, "w");
+    if (!fp) {
+        return -1;
+    }
+    fprintf(fp, "%s\n", content);
+    fclose(fp);
+    return 0;
+}
+
+static int bench_symlink(const char* root, const char* path, const char* target) {
+    char full[1024];
+    snprintf(full, sizeof(full), "%s/%s", root, path);
+    char *slash = strrchr(full, '/');
+    *slash = '\0';
+    if (make_directories(full) != 0) {
+        return -1;
+    }
+    *slash = '/';
+    return symlink(target, full);
+}
+
+// sd naming of the kernel: sda..sdz, sdaa..sdzz, sdaaa...
+static void bench_disk_name(int index, char* name, size_t size) {
+    char suffix[8];
+    int len = 0;
+    for (index++; index > 0 && len < (int)sizeof(suffix) - 1; index = (index - 1) / 26) {
+        suffix[len++] = (char)('a' + (index - 1) % 26);
+    }
+    char *out = name;
+    out += snprintf(name, size, "sd");
+    while (len > 0 && (size_t)(out - name) < size - 1) {
+        *out++ = suffix[--len];
+    }
+    *out = '\0';
+}
+
+// Queue and identity attributes of one block device directory
+static int bench_block_attributes(const char* root, const char* block_dir, const char* scsi_dir,
+                                  const char* model, int rotational, int removable, long long sectors) {
+    char path[768];
+    char value[64];
+    int err = 0;
+    snprintf(value, sizeof(value), "%lld", sectors);
+    snprintf(path, sizeof(path), "%s/size", block_dir);
+    err |= bench_write_file(root, path, value);
+    snprintf(path, sizeof(path), "%s/removable", block_dir);
+    err |= bench_write_file(root, path, removable ? "1" : "0");
+    snprintf(path, sizeof(path), "%s/ro", block_dir);
+    err |= bench_write_file(root, path, "0");
+    snprintf(path, sizeof(path), "%s/queue/rotational", block_dir);
+    err |= bench_write_file(root, path, rotational ? "1" : "0");
+    snprintf(path, sizeof(path), "%s/queue/physical_block_size", block_dir);
+    err |= bench_write_file(root, path, "4096");
+    snprintf(path, sizeof(path), "%s/queue/logical_block_size", block_dir);
+    err |= bench_write_file(root, path, "512");
+    snprintf(path, sizeof(path), "%s/queue/discard_max_bytes", block_dir);
+    err |= bench_write_file(root, path, rotational ? "0" : "2147450880");
+    snprintf(path, sizeof(path), "%s/queue/discard_granularity", block_dir);
+    err |= bench_write_file(root, path, rotational ? "0" : "4096");
+    snprintf(path, sizeof(path), "%s/queue/write_zeroes_max_bytes", block_dir);
+    err |= bench_write_file(root, path, "0");
+    snprintf(path, sizeof(path), "%s/model", scsi_dir);
+    err |= bench_write_file(root, path, model);
+    snprintf(path, sizeof(path), "%s/vendor", scsi_dir);
+    err |= bench_write_file(root, path, "ATA");
+    snprintf(path, sizeof(path), "%s/type", scsi_dir);
+    err |= bench_write_file(root, path, "0");
+    return err ? -1 : 0;
+}
+
+// USB device directory with the attributes the USB scans read
+// <device>:1.<number> with its class triple, linked from /sys/bus/usb/devices
+static int bench_usb_interface(const char* root, const char* dir, const char* name, int number,
+                               const char* interface_class, const char* subclass, const char* protocol,
+                               const char* label) {
+    char path[768];
+    char value[16];
+    int err = 0;
+    snprintf(path, sizeof(path), "%s/%s:1.%d/bInterfaceNumber", dir, name, number);
+    snprintf(value, sizeof(value), "%02x", number);
+    err |= bench_write_file(root, path, value);
+    snprintf(path, sizeof(path), "%s/%s:1.%d/bInterfaceClass", dir, name, number);
+    err |= bench_write_file(root, path, interface_class);
+    snprintf(path, sizeof(path), "%s/%s:1.%d/bInterfaceSubClass", dir, name, number);
+    err |= bench_write_file(root, path, subclass);
+    snprintf(path, sizeof(path), "%s/%s:1.%d/bInterfaceProtocol", dir, name, number);
+    err |= bench_write_file(root, path, protocol);
+    if (label) {
+        snprintf(path, sizeof(path), "%s/%s:1.%d/interface", dir, name, number);
+        err |= bench_write_file(root, path, label);
+    }
+    snprintf(path, sizeof(path), "bus/usb/devices/%s:1.%d", name, number);
+    char target[768];
+    snprintf(target, sizeof(target), "../../../%s/%s:1.%d", dir, name, number);
+    err |= bench_symlink(root, path, target);
+    return err ? -1 : 0;
+}
+
+static int bench_usb_device(const char* root, const char* dir, const char* name, const char* vendor_id,
+                            const char* product_id, const char* manufacturer, const char* product,
+                            const char* device_class, const char* speed, int serial) {
+    char path[768];
+    char value[32];
+    int err = 0;
+    snprintf(path, sizeof(path), "%s/idVendor", dir);
+    err |= bench_write_file(root, path, vendor_id);
+    snprintf(path, sizeof(path), "%s/idProduct", dir);
+    err |= bench_write_file(root, path, product_id);
+    snprintf(path, sizeof(path), "%s/manufacturer", dir);
+    err |= bench_write_file(root, path, manufacturer);
+    snprintf(path, sizeof(path), "%s/product", dir);
+    err |= bench_write_file(root, path, product);
+    snprintf(path, sizeof(path), "%s/bDeviceClass", dir);
+    err |= bench_write_file(root, path, device_class);
+    snprintf(path, sizeof(path), "%s/speed", dir);
+    err |= bench_write_file(root, path, speed);
+    snprintf(path, sizeof(path), "%s/version", dir);
+    err |= bench_write_file(root, path, strcmp(speed, "5000") == 0 ? " 3.20" : " 2.00");
+    snprintf(value, sizeof(value), "BENCH%08d", serial);
+    snprintf(path, sizeof(path), "%s/serial", dir);
+    err |= bench_write_file(root, path, value);
+    snprintf(value, sizeof(value), "%d", serial / 100 + 1);
+    snprintf(path, sizeof(path), "%s/busnum", dir);
+    err |= bench_write_file(root, path, value);
+    snprintf(value, sizeof(value), "%d", serial % 100 + 2);
+    snprintf(path, sizeof(path), "%s/devnum", dir);
+    err |= bench_write_file(root, path, value);
+    // /sys/bus/usb/devices/<name> -> ../../../devices/...
+    snprintf(path, sizeof(path), "bus/usb/devices/%s", name);
+    char target[768];
+    snprintf(target, sizeof(target), "../../../%s", dir);
+    err |= bench_symlink(root, path, target);
+    return err ? -1 : 0;
+}
+
+// Six of ten devices are SATA disks, three sit on USB (every third of those a
+// phone without storage) and one is an NVMe namespace
+static int bench_build_tree(const char* root, int count) {
+    char sysfs[600];
+    snprintf(sysfs, sizeof(sysfs), "%s/sys", root);
+    int err = 0;
+    int disks = 0;
+    int usb_ports = 0;
+    int nvme = 0;
+    
+    err |= bench_usb_device(sysfs, "devices/pci0000:00/0000:00:14.0/usb1", "usb1", "1d6b", "0002",
+                            "Linux Foundation", "xHCI Host Controller", "09", "480", 0);
+    for (int i = 0; i < count && !err; i++) {
+        char name[24];
+        char block_dir[768];
+        char scsi_dir[640];
+        char path[1024];
+        char target[1024];
+        char model[64];
+        char device_link[32] = "../..";
+        int kind = i % 10;
         
-        if (usb_count == 0) {
-            printf("No USB devices found.\n");
+        if (kind < 6) {
+            bench_disk_name(disks++, name, sizeof(name));
+            snprintf(scsi_dir, sizeof(scsi_dir), "devices/pci0000:00/0000:00:17.0/ata%d/host%d/target%d:0:0/%d:0:0:0",
+                     i + 1, i, i, i);
+            snprintf(model, sizeof(model), "BENCH HDD %dTB", 4 + i % 16);
+            snprintf(block_dir, sizeof(block_dir), "%s/block/%s", scsi_dir, name);
+            err |= bench_block_attributes(sysfs, block_dir, scsi_dir, model, kind < 4, 0, 7814037168LL);
+        } else if (kind < 9) {
+            // Seven ports per hub, hubs hang off the root hub in order
+            int port = usb_ports++;
+            int hub = port / 7 + 1;
+            char hub_dir[256];
+            char usb_name[64];
+            char usb_dir[512];
+            snprintf(hub_dir, sizeof(hub_dir), "devices/pci0000:00/0000:00:14.0/usb1/1-%d", hub);
+            if (port % 7 == 0) {
+                snprintf(usb_name, sizeof(usb_name), "1-%d", hub);
+                err |= bench_usb_device(sysfs, hub_dir, usb_name, "05e3", "0610", "GenesysLogic",
+                                        "USB2.1 Hub", "09", "480", 0);
+            }
+            snprintf(usb_name, sizeof(usb_name), "1-%d.%d", hub, port % 7 + 1);
+            snprintf(usb_dir, sizeof(usb_dir), "%s/%s", hub_dir, usb_name);
+            if (kind == 8) {
+                err |= bench_usb_device(sysfs, usb_dir, usb_name, "18d1", "4ee1", "Google", "Pixel 7",
+                                        "00", "480", i);
+                err |= bench_usb_interface(sysfs, usb_dir, usb_name, 0, "06", "01", "01", "MTP");
+                err |= bench_usb_interface(sysfs, usb_dir, usb_name, 1, "ff", "42", "01", "ADB Interface");
+                continue;
+            }
+            err |= bench_usb_device(sysfs, usb_dir, usb_name, "0781", "5583", "SanDisk", "Ultra Fit",
+                                    "00", "5000", i);
+            err |= bench_usb_interface(sysfs, usb_dir, usb_name, 0, "08", "06", "50", NULL);
+            bench_disk_name(disks++, name, sizeof(name));
+            snprintf(scsi_dir, sizeof(scsi_dir), "%s/%s:1.0/host%d/target%d:0:0/%d:0:0:0",
+                     usb_dir, usb_name, i, i, i);
+            snprintf(block_dir, sizeof(block_dir), "%s/block/%s", scsi_dir, name);
+            err |= bench_block_attributes(sysfs, block_dir, scsi_dir, "Ultra Fit", 0, 1, 60063744LL);
         } else {
-            printf("\nTotal USB devices analyzed: %d\n", usb_count);
+            // One namespace per controller, each controller on its own root port
+            int ctrl = nvme++;
+            snprintf(name, sizeof(name), "nvme%dn1", ctrl);
+            snprintf(scsi_dir, sizeof(scsi_dir), "devices/pci0000:00/0000:00:%02x.%d/0000:%02x:00.0/nvme/nvme%d",
+                     ctrl / 8 % 32, ctrl % 8, ctrl % 250 + 1, ctrl);
+            snprintf(block_dir, sizeof(block_dir), "%s/%s", scsi_dir, name);
+            snprintf(device_link, sizeof(device_link), "../../nvme%d", ctrl);
+            err |= bench_block_attributes(sysfs, block_dir, scsi_dir, "BENCH NVMe 2TB", 0, 0, 3907029168LL);
+            snprintf(path, sizeof(path), "%s/nsid", block_dir);
+            err |= bench_write_file(sysfs, path, "1");
+            snprintf(path, sizeof(path), "%s/firmware_rev", scsi_dir);
+            err |= bench_write_file(sysfs, path, "1B2QGXA7");
         }
-    } else {
-        printf("Cannot access USB device information\n");
+        // /sys/block/<name> -> ../devices/..., <block dir>/device -> the SCSI device or NVMe controller
+        snprintf(path, sizeof(path), "block/%s", name);
+        snprintf(target, sizeof(target), "../%s", block_dir);
+        err |= bench_symlink(sysfs, path, target);
+        snprintf(path, sizeof(path), "%s/device", block_dir);
+        err |= bench_symlink(sysfs, path, device_link);
+        
+        // Regular files as device nodes: the probes open them and their ioctls fail
+        snprintf(path, sizeof(path), "dev/%s", name);
+        err |= bench_write_file(root, path, "");
+    }
+    
+    const char *stubs[][2] = {
+        { "bin/smartctl", "#!/bin/sh\necho 'SMART overall-health self-assessment test result: PASSED'" },
+    };
+    for (size_t i = 0; i < sizeof(stubs) / sizeof(stubs[0]) && !err; i++) {
+        char path[700];
+        err |= bench_write_file(root, stubs[i][0], stubs[i][1]);
+        snprintf(path, sizeof(path), "%s/%s", root, stubs[i][0]);
+        err |= chmod(path, 0755);
     }
+    return err ? -1 : 0;
 }
 
-// Parse and display NVMe security features and reserved spaces
-void show_nvme_security_features(const char* device) {
-    char device_path[256];
-    snprintf(device_path, sizeof(device_path), "/dev/%s", device);
-    printf("\n=== NVMe Security Features & Reserved Spaces ===\n");
-    
-    // Check if nvme-cli is available
-    if (system("which nvme > /dev/null 2>&1") != 0) {
-        printf("nvme-cli tool not found. Install with: sudo pacman -S nvme-cli\n");
-        printf("Falling back to basic NVMe analysis...\n\n");
-        
-        // Try to get basic info from sysfs
-        char sysfs_path[512];
-        snprintf(sysfs_path, sizeof(sysfs_path), "/sys/block/%s/device", device);
-        
-        // Check NVMe version
-        char version_path[512];
-        snprintf(version_path, sizeof(version_path), "%s/firmware_rev", sysfs_path);
-        FILE *fw_file = fopen(version_path, "r");
-        if (fw_file) {
-            char fw_rev[64];
-            if (fgets(fw_rev, sizeof(fw_rev), fw_file)) {
-                fw_rev[strcspn(fw_rev, "\n")] = 0;
-                printf("Firmware Revision: %s\n", fw_rev);
-            }
-            fclose(fw_file);
-        }
-        
-        // Check model number
-        snprintf(version_path, sizeof(version_path), "%s/model", sysfs_path);
-        fw_file = fopen(version_path, "r");
-        if (fw_file) {
-            char model[128];
-            if (fgets(model, sizeof(model), fw_file)) {
-                model[strcspn(model, "\n")] = 0;
-                printf("Model: %s\n", model);
+static int bench_remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+// Counter of every system call of the process and the children it starts,
+// through the raw_syscalls:sys_enter tracepoint; -1 without tracefs or rights
+static int bench_open_syscall_counter(void) {
+    const char *id_paths[] = {
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+    };
+    long long id = -1;
+    for (size_t i = 0; i < sizeof(id_paths) / sizeof(id_paths[0]) && id < 0; i++) {
+        FILE *fp = fopen(id_paths[i], "r");
+        if (fp) {
+            if (fscanf(fp, "%lld", &id) != 1) {
+                id = -1;
             }
-            fclose(fw_file);
+            fclose(fp);
         }
-        
-        printf("For detailed NVMe security features, install nvme-cli package.\n");
-        return;
+    }
+    if (id < 0) {
+        return -1;
+    }
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_TRACEPOINT;
+    attr.size = sizeof(attr);
+    attr.config = (unsigned long long)id;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Read and write system calls of this process (/proc/self/io), the fallback
+static long long bench_io_syscalls(void) {
+    FILE *fp = fopen("/proc/self/io", "r");
+    if (!fp) {
+        return -1;
+    }
+    char line[128];
+    long long total = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        long long value;
+        if (sscanf(line, "syscr: %lld", &value) == 1 || sscanf(line, "syscw: %lld", &value) == 1) {
+            total += value;
+        }
+    }
+    fclose(fp);
+    return total;
+}
+
+// Run one scan with stdout sent to /dev/null. The syscall counter inherits
+// into the started tools, and PERF_EVENT_IOC_RESET does not clear what exited
+// children added, so the count is read before and after instead.
+static void bench_measure(void (*scan)(void), int perf_fd, struct bench_sample* sample) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (saved >= 0 && null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
     }
     
-    // Show controller info
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd), "nvme id-ctrl %s 2>/dev/null", device_path);
-    FILE *nvme_output = popen(cmd, "r");
-    if (nvme_output) {
-        char line[512];
-        int found_info = 0;
-        printf("NVMe Controller Information:\n");
-        while (fgets(line, sizeof(line), nvme_output)) {
-            if (strstr(line, "oacs") || strstr(line, "fuses") || strstr(line, "Format NVM") || 
-                strstr(line, "Crypto Erase") || strstr(line, "Sanitize") || strstr(line, "firmware")) {
-                printf("  %s", line);
-                found_info = 1;
-            }
-        }
-        pclose(nvme_output);
-        if (!found_info) {
-            printf("  Standard NVMe controller detected\n");
+    long long io_before = perf_fd < 0 ? bench_io_syscalls() : 0;
+    long long perf_before = -1;
+    if (perf_fd >= 0 && read(perf_fd, &perf_before, sizeof(perf_before)) != (ssize_t)sizeof(perf_before)) {
+        perf_before = -1;
+    }
+    if (perf_fd >= 0) {
+        ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#ifdef BENCH_HEAP_BYTES
+    long long heap_before = bench_heap_in_use();
+#endif
+    double start = monotonic_seconds();
+    scan();
+    fflush(stdout);
+    sample->seconds = monotonic_seconds() - start;
+#ifdef BENCH_HEAP_BYTES
+    sample->heap_bytes = bench_heap_in_use() - heap_before;
+    sample->heap_valid = 1;
+#else
+    sample->heap_bytes = 0;
+    sample->heap_valid = 0;
+#endif
+    sample->syscalls = -1;
+    if (perf_fd >= 0) {
+        ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (perf_before >= 0 && read(perf_fd, &count, sizeof(count)) == (ssize_t)sizeof(count)) {
+            sample->syscalls = count - perf_before;
         }
-    } else {
-        printf("Unable to read NVMe controller information.\n");
+    } else if (io_before >= 0) {
+        sample->syscalls = bench_io_syscalls() - io_before;
     }
     
-    // List namespaces
-    printf("\nNVMe Namespaces:\n");
-    snprintf(cmd, sizeof(cmd), "nvme list-ns %s 2>/dev/null", device_path);
-    nvme_output = popen(cmd, "r");
-    if (nvme_output) {
-        char line[512];
-        int found = 0;
-        while (fgets(line, sizeof(line), nvme_output)) {
-            printf("  %s", line);
-            found = 1;
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+}
+
+static int bench_compare_seconds(const void* a, const void* b) {
+    double x = ((const struct bench_sample*)a)->seconds;
+    double y = ((const struct bench_sample*)b)->seconds;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_run_scan(const char* name, void (*scan)(void), int devices, int runs, int perf_fd,
+                           struct bench_result* result) {
+    struct bench_sample samples[32];
+    if (runs > (int)(sizeof(samples) / sizeof(samples[0]))) {
+        runs = (int)(sizeof(samples) / sizeof(samples[0]));
+    }
+    // The first scan fills the dentry and page caches and is not counted
+    bench_measure(scan, perf_fd, &samples[0]);
+    double syscalls = 0;
+    double heap_bytes = 0;
+    for (int i = 0; i < runs; i++) {
+        bench_measure(scan, perf_fd, &samples[i]);
+        syscalls += (double)samples[i].syscalls;
+        heap_bytes += (double)samples[i].heap_bytes;
+    }
+    qsort(samples, runs, sizeof(samples[0]), bench_compare_seconds);
+    result->scan = name;
+    result->devices = devices;
+    result->runs = runs;
+    result->median_seconds = samples[runs / 2].seconds;
+    result->min_seconds = samples[0].seconds;
+    result->syscalls = samples[0].syscalls < 0 ? -1 : syscalls / runs;
+    result->heap_bytes = heap_bytes / runs;
+    result->heap_valid = samples[0].heap_valid;
+    result->syscall_source = perf_fd >= 0 ? "perf" : "proc-io";
+}
+
+static void report_bench_result(const struct bench_result* result) {
+    double per_device = result->devices > 0 ? 1.0 / result->devices : 0.0;
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "bench");
+        record_string(&rec, "scan", result->scan);
+        record_int(&rec, "devices", result->devices);
+        record_int(&rec, "runs", result->runs);
+        record_key(&rec, "median_ms");
+        buffer_printf(&rec.buf, "%.3f", result->median_seconds * 1e3);
+        record_key(&rec, "min_ms");
+        buffer_printf(&rec.buf, "%.3f", result->min_seconds * 1e3);
+        record_key(&rec, "us_per_device");
+        buffer_printf(&rec.buf, "%.1f", result->median_seconds * 1e6 * per_device);
+        if (result->syscalls >= 0) {
+            record_key(&rec, "syscalls_per_device");
+            buffer_printf(&rec.buf, "%.1f", result->syscalls * per_device);
+            record_string(&rec, "syscall_source", result->syscall_source);
         }
-        pclose(nvme_output);
-        if (!found) {
-            printf("  No additional namespaces found\n");
+        if (result->heap_valid) {
+            record_key(&rec, "heap_bytes_per_device");
+            buffer_printf(&rec.buf, "%.1f", result->heap_bytes * per_device);
         }
+        record_emit(&rec);
+        return;
+    }
+    char syscalls[32] = "n/a";
+    char heap_bytes[32] = "n/a";
+    if (result->syscalls >= 0) {
+        snprintf(syscalls, sizeof(syscalls), "%.1f", result->syscalls * per_device);
+    }
+    if (result->heap_valid) {
+        snprintf(heap_bytes, sizeof(heap_bytes), "%.1f", result->heap_bytes * per_device);
     }
+    printf("%-6s %8d %5d %11.2f %11.1f %15s %14s\n", result->scan, result->devices, result->runs,
+           result->median_seconds * 1e3, result->median_seconds * 1e6 * per_device, syscalls, heap_bytes);
+}
+
+// Every run pays for its own USB topology snapshot
+static void bench_scan_block(void) {
+    usb_topology_invalidate();
+    list_available_devices();
+}
+
+static void bench_scan_usb(void) {
+    usb_topology_invalidate();
+    list_all_usb_devices();
+}
+
+// --bench-scan 10,100,1000: build a tree per size and time both scans on it
+static int bench_scan_command(const char* sizes) {
+    char saved_sysfs_root[sizeof(sysfs_root)];
+    char saved_dev_root[sizeof(dev_root)];
+    const char *saved_path = getenv("PATH");
+    char *path_copy = saved_path ? strdup(saved_path) : NULL;
+    memcpy(saved_sysfs_root, sysfs_root, sizeof(sysfs_root));
+    memcpy(saved_dev_root, dev_root, sizeof(dev_root));
     
-    // Get namespace information
-    printf("\nNamespace Details:\n");
-    snprintf(cmd, sizeof(cmd), "nvme id-ns %s 2>/dev/null", device_path);
-    nvme_output = popen(cmd, "r");
-    if (nvme_output) {
-        char line[512];
-        while (fgets(line, sizeof(line), nvme_output)) {
-            if (strstr(line, "nsze") || strstr(line, "ncap") || strstr(line, "nuse") || 
-                strstr(line, "lbaf") || strstr(line, "ms") || strstr(line, "pi")) {
-                printf("  %s", line);
-            }
-        }
-        pclose(nvme_output);
+    int perf_fd = bench_open_syscall_counter();
+    if (output_format == OUTPUT_TEXT) {
+        printf("=== Scan Benchmark ===\n");
+        printf("System calls: %s\n", perf_fd >= 0 ? "all (raw_syscalls tracepoint, including started tools)" :
+               "read/write only (/proc/self/io; tracefs or perf access unavailable)");
+        printf("%-6s %8s %5s %11s %11s %15s %14s\n", "Scan", "Devices", "Runs", "Median ms", "us/device",
+               "Syscalls/device", "Heap B/device");
     }
     
-    // Check for firmware partitions/logs
-    printf("\nFirmware Log Analysis:\n");
-    snprintf(cmd, sizeof(cmd), "nvme get-log %s --log-id=0x03 --log-len=512 2>/dev/null", device_path);
-    nvme_output = popen(cmd, "r");
-    if (nvme_output) {
-        char line[512];
-        int found_fw = 0;
-        while (fgets(line, sizeof(line), nvme_output)) {
-            if (strstr(line, "firmware") || strstr(line, "reserved") || strstr(line, "Firmware")) {
-                printf("  %s", line);
-                found_fw = 1;
-            }
+    int status = 0;
+    const char *cursor = sizes;
+    while (*cursor && status == 0) {
+        char *end = NULL;
+        long count = strtol(cursor, &end, 10);
+        if (end == cursor || count < 1 || count > BENCH_MAX_DEVICES || (*end != ',' && *end != '\0')) {
+            printf("Invalid benchmark size in %s (1-%d devices)\n", sizes, BENCH_MAX_DEVICES);
+            status = 1;
+            break;
         }
-        pclose(nvme_output);
-        if (!found_fw) {
-            printf("  No explicit firmware log entries found\n");
+        cursor = *end == ',' ? end + 1 : end;
+        
+        const char *tmp = getenv("TMPDIR");
+        char root[160];
+        snprintf(root, sizeof(root), "%s/sdw-bench-XXXXXX", tmp && tmp[0] ? tmp : "/tmp");
+        if (!mkdtemp(root)) {
+            printf("Cannot create a benchmark tree: %s\n", strerror(errno));
+            status = 1;
+            break;
+        }
+        if (bench_build_tree(root, (int)count) != 0) {
+            printf("Cannot build the synthetic tree in %s: %s\n", root, strerror(errno));
+            status = 1;
+        } else {
+            char path[2048];
+            snprintf(sysfs_root, sizeof(sysfs_root), "%s/sys", root);
+            snprintf(dev_root, sizeof(dev_root), "%s/dev", root);
+            snprintf(path, sizeof(path), "%s/bin:%s", root, path_copy ? path_copy : "/usr/bin:/bin");
+            setenv("PATH", path, 1);
+            
+            // Small trees scan in microseconds, give them more runs
+            int runs = count >= 500 ? 3 : count >= 100 ? 5 : 15;
+            struct bench_result result;
+            bench_run_scan("block", bench_scan_block, (int)count, runs, perf_fd, &result);
+            report_bench_result(&result);
+            bench_run_scan("usb", bench_scan_usb, (int)count, runs, perf_fd, &result);
+            report_bench_result(&result);
         }
+        nftw(root, bench_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
     }
     
-    // Check for security capabilities
-    printf("\nSecurity Capabilities:\n");
-    snprintf(cmd, sizeof(cmd), "nvme id-ctrl %s 2>/dev/null | grep -i 'security\\|sanitize\\|crypto\\|format'", device_path);
-    nvme_output = popen(cmd, "r");
-    if (nvme_output) {
-        char line[512];
-        int found_sec = 0;
-        while (fgets(line, sizeof(line), nvme_output)) {
-            printf("  %s", line);
-            found_sec = 1;
-        }
-        pclose(nvme_output);
-        if (!found_sec) {
-            printf("  Standard security features available\n");
+    memcpy(sysfs_root, saved_sysfs_root, sizeof(sysfs_root));
+    memcpy(dev_root, saved_dev_root, sizeof(dev_root));
+    if (path_copy) {
+        setenv("PATH", path_copy, 1);
+        free(path_copy);
+    }
+    if (perf_fd >= 0) {
+        close(perf_fd);
+    }
+    return status;
+}
+#endif
+
+#ifdef __linux__
+// ---------------------------------------------------------------------------
+// Wipe benchmark (--bench)
+// ---------------------------------------------------------------------------
+//
+// First the pattern generators and compare kernels run on their own over a
+// cache-resident buffer, then the wipe and verify passes run against a tmpfs
+// file, a sparse file and a loop device. Request size, queue depth, thread
+// count and pattern are swept one at a time around a baseline, so a drop can
+// be pinned on the CPU side or on the I/O side.
+
+#define BENCH_DEFAULT_WIPE_SIZE     (128ULL * 1024 * 1024)
+#define BENCH_DEFAULT_DIR           "/var/tmp"
+#define BENCH_KERNEL_BUFFER         (64 * 1024)
+#define BENCH_KERNEL_SECONDS        0.25
+#define BENCH_LATENCY_SAMPLES       32768
+#define BENCH_MAX_THREADS           8
+
+#ifndef TMPFS_MAGIC
+#define TMPFS_MAGIC 0x01021994
+#endif
+
+enum bench_target_kind {
+    BENCH_TARGET_TMPFS,
+    BENCH_TARGET_SPARSE,
+    BENCH_TARGET_LOOP
+};
+
+static const char *bench_target_names[] = { "tmpfs", "sparse", "loop" };
+
+struct bench_wipe_case {
+    size_t request_size;
+    int queue_depth;
+    int threads;
+    enum wipe_pattern pattern;
+};
+
+// The baseline first, then one parameter changed at a time
+static const struct bench_wipe_case bench_wipe_cases[] = {
+    { 1024 * 1024, 32, 1, WIPE_PATTERN_ZERO },
+    { 64 * 1024, 32, 1, WIPE_PATTERN_ZERO },
+    { 256 * 1024, 32, 1, WIPE_PATTERN_ZERO },
+    { 4 * 1024 * 1024, 32, 1, WIPE_PATTERN_ZERO },
+    { 1024 * 1024, 1, 1, WIPE_PATTERN_ZERO },
+    { 1024 * 1024, 4, 1, WIPE_PATTERN_ZERO },
+    { 1024 * 1024, 128, 1, WIPE_PATTERN_ZERO },
+    { 1024 * 1024, 32, 2, WIPE_PATTERN_ZERO },
+    { 1024 * 1024, 32, 4, WIPE_PATTERN_ZERO },
+    { 1024 * 1024, 32, 1, WIPE_PATTERN_ONES },
+    { 1024 * 1024, 32, 1, WIPE_PATTERN_RANDOM },
+};
+
+// One target of a case: a file, or a loop device backed by one
+struct bench_wipe_worker {
+    pthread_t thread;
+    char file[512];
+    char path[512];                     // what the pass opens
+    int loop_fd;
+    const struct wipe_options *options;
+    int verify;
+    struct wipe_result result;
+    struct verify_result check;
+    struct latency_log latency;
+    int open_error;
+};
+
+// CPU cycle counter of this process and its threads. Kernel cycles are left
+// out when perf_event_paranoid only allows user space counting; -1 when the
+// machine has no cycle counter (most VMs)
+static int bench_open_cycle_counter(int* user_only) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    *user_only = 0;
+    int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        *user_only = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd;
+}
+
+static void bench_counter_start(int fd) {
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static long long bench_counter_stop(int fd) {
+    long long count = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) {
+            count = -1;
         }
     }
-    
-    printf("\nNote: Some reserved areas may not be visible without vendor-specific tools.\n");
+    return count;
 }
 
-// Parse and display SATA SSD security features and reserved spaces
-void show_sata_security_features(const char* device) {
-    char device_path[256];
-    snprintf(device_path, sizeof(device_path), "/dev/%s", device);
-    printf("\n=== SATA SSD Security Features & Reserved Spaces ===\n");
-    
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd), "hdparm -I %s 2>/dev/null", device_path);
-    FILE *hdparm_output = popen(cmd, "r");
-    if (hdparm_output) {
-        char line[512];
-        while (fgets(line, sizeof(line), hdparm_output)) {
-            if (strstr(line, "firmware") || strstr(line, "Security") || 
-                strstr(line, "HPA") || strstr(line, "DCO") || strstr(line, "reserved")) {
-                printf("%s", line);
-            }
-        }
-        pclose(hdparm_output);
-    } else {
-        printf("hdparm not available or device not supported.\n");
+// User plus system CPU time of every thread of the process
+static double bench_cpu_seconds(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
     }
-    
-    // Show HPA/DCO info
-    snprintf(cmd, sizeof(cmd), "hdparm -N %s 2>/dev/null", device_path);
-    hdparm_output = popen(cmd, "r");
-    if (hdparm_output) {
-        char line[256];
-        while (fgets(line, sizeof(line), hdparm_output)) {
-            printf("%s", line);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// --------------------------------------------------------------------------
+// Kernels
+
+// A generator and a comparer, with the signature of the ChaCha block kernels
+struct bench_kernel {
+    const char *name;
+    void (*generate)(const struct pattern_key*, uint64_t, unsigned char*, size_t);
+    size_t (*compare)(const unsigned char*, const unsigned char*, size_t);
+    size_t (*compare_fill)(const unsigned char*, unsigned char, size_t);
+};
+
+static void bench_generate_repeat(const struct pattern_key* key, uint64_t counter, unsigned char* out, size_t blocks) {
+    struct wipe_options options;
+    (void)key;
+    wipe_options_init(&options);
+    options.pattern = WIPE_PATTERN_REPEAT;
+    parse_repeat_pattern("55aa33cc", &options);
+    wipe_fill_pattern(&options, counter * CHACHA_BLOCK_SIZE, out, blocks * CHACHA_BLOCK_SIZE);
+}
+
+static int bench_kernel_list(struct bench_kernel* kernels, int max) {
+    int count = 0;
+    struct bench_kernel all[] = {
+        { "chacha8-scalar", chacha_blocks_scalar, NULL, NULL },
+#ifdef PATTERN_HAVE_X86_SIMD
+        { "chacha8-avx2", __builtin_cpu_supports("avx2") ? chacha_blocks_avx2 : NULL, NULL, NULL },
+        { "chacha8-avx512", __builtin_cpu_supports("avx512f") ? chacha_blocks_avx512 : NULL, NULL, NULL },
+#endif
+        { "repeat-fill", bench_generate_repeat, NULL, NULL },
+        { "compare-bytes-scalar", NULL, compare_bytes_scalar, NULL },
+        { "compare-fill-scalar", NULL, NULL, compare_fill_scalar },
+#ifdef PATTERN_HAVE_X86_SIMD
+        { "compare-bytes-avx2", NULL, __builtin_cpu_supports("avx2") ? compare_bytes_avx2 : NULL, NULL },
+        { "compare-fill-avx2", NULL, NULL, __builtin_cpu_supports("avx2") ? compare_fill_avx2 : NULL },
+#endif
+    };
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]) && count < max; i++) {
+        if (all[i].generate || all[i].compare || all[i].compare_fill) {
+            kernels[count++] = all[i];
         }
-        pclose(hdparm_output);
     }
-    
-    snprintf(cmd, sizeof(cmd), "hdparm --dco-identify %s 2>/dev/null", device_path);
-    hdparm_output = popen(cmd, "r");
-    if (hdparm_output) {
-        char line[256];
-        while (fgets(line, sizeof(line), hdparm_output)) {
-            printf("%s", line);
+    return count;
+}
+
+static void report_bench_kernel(const char* name, double bytes, double seconds, long long cycles) {
+    double gb_s = seconds > 0 ? bytes / seconds / 1e9 : 0.0;
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "bench_kernel");
+        record_string(&rec, "kernel", name);
+        record_key(&rec, "gb_per_second");
+        buffer_printf(&rec.buf, "%.3f", gb_s);
+        record_key(&rec, "ns_per_byte");
+        buffer_printf(&rec.buf, "%.4f", bytes > 0 ? seconds * 1e9 / bytes : 0.0);
+        if (cycles >= 0) {
+            record_key(&rec, "cycles_per_byte");
+            buffer_printf(&rec.buf, "%.4f", cycles / bytes);
         }
-        pclose(hdparm_output);
+        record_emit(&rec);
+        return;
     }
-    printf("Note: For more details, use vendor-specific tools or consult SSD documentation.\n");
+    char cycles_text[32] = "n/a";
+    if (cycles >= 0) {
+        snprintf(cycles_text, sizeof(cycles_text), "%.3f", cycles / bytes);
+    }
+    printf("%-22s %8.2f %9.4f %9s\n", name, gb_s, seconds * 1e9 / bytes, cycles_text);
 }
 
-// Detect firmware reserved spaces for SSDs (NVMe and SATA)
-void check_ssd_firmware_reserved(const char* device) {
-    char device_path[256];
-    snprintf(device_path, sizeof(device_path), "/dev/%s", device);
-    printf("\n=== SSD Firmware Reserved Space Analysis ===\n");
+// Each kernel runs for BENCH_KERNEL_SECONDS over a buffer that stays in L2
+static int bench_kernels(int cycle_fd) {
+    unsigned char *buf = NULL;
+    unsigned char *copy = NULL;
+    if (posix_memalign((void**)&buf, 64, BENCH_KERNEL_BUFFER) != 0 ||
+        posix_memalign((void**)&copy, 64, BENCH_KERNEL_BUFFER) != 0) {
+        free(buf);
+        printf("Out of memory\n");
+        return 1;
+    }
+    struct pattern_key key;
+    memset(&key, 0x5a, sizeof(key));
+    pattern_fill(&key, 0, buf, BENCH_KERNEL_BUFFER);
+    memcpy(copy, buf, BENCH_KERNEL_BUFFER);
     
-    // NVMe SSDs
-    if (strncmp(device, "nvme", 4) == 0) {
-        // Check if nvme-cli is available
-        if (system("which nvme > /dev/null 2>&1") != 0) {
-            printf("nvme-cli tool not found. Install with: sudo pacman -S nvme-cli\n");
-            printf("Performing basic NVMe analysis...\n\n");
-            
-            // Get device size from sysfs
-            char size_path[256];
-            snprintf(size_path, sizeof(size_path), "/sys/block/%s/size", device);
-            FILE *size_file = fopen(size_path, "r");
-            if (size_file) {
-                unsigned long long sectors;
-                if (fscanf(size_file, "%llu", &sectors) == 1) {
-                    double size_gb = (sectors * 512.0) / (1024.0 * 1024.0 * 1024.0);
-                    printf("Total Capacity: %.2f GB (%llu sectors)\n", size_gb, sectors);
-                }
-                fclose(size_file);
-            }
-            
-            printf("Note: For detailed firmware space analysis, install nvme-cli\n");
-            return;
+    struct bench_kernel kernels[16];
+    int count = bench_kernel_list(kernels, 16);
+    if (output_format == OUTPUT_TEXT) {
+        printf("=== Pattern Kernels (%d KiB buffer) ===\n", BENCH_KERNEL_BUFFER / 1024);
+        printf("%-22s %8s %9s %9s\n", "Kernel", "GB/s", "ns/B", "Cycles/B");
+    }
+    size_t sink = 0;
+    for (int k = 0; k < count && !wipe_interrupted; k++) {
+        const struct bench_kernel *kernel = &kernels[k];
+        unsigned char *zero = copy;
+        if (kernel->compare_fill) {
+            memset(zero, 0, BENCH_KERNEL_BUFFER);
         }
-        
-        printf("Analyzing NVMe device with nvme-cli...\n");
-        
-        // List NVMe namespaces with detailed info
-        char cmd[512];
-        snprintf(cmd, sizeof(cmd), "nvme list-ns %s 2>/dev/null", device_path);
-        FILE *nvme_output = popen(cmd, "r");
-        if (nvme_output) {
-            char line[512];
-            int found = 0;
-            printf("Available Namespaces:\n");
-            while (fgets(line, sizeof(line), nvme_output)) {
-                printf("  %s", line);
-                found = 1;
-            }
-            pclose(nvme_output);
-            if (!found) {
-                printf("  Default namespace (1) active\n");
+        double bytes = 0;
+        uint64_t counter = 0;
+        bench_counter_start(cycle_fd);
+        double start = monotonic_seconds();
+        double elapsed = 0;
+        do {
+            if (kernel->generate) {
+                kernel->generate(&key, counter, buf, BENCH_KERNEL_BUFFER / CHACHA_BLOCK_SIZE);
+                counter += BENCH_KERNEL_BUFFER / CHACHA_BLOCK_SIZE;
+                sink += buf[counter % BENCH_KERNEL_BUFFER];
+            } else if (kernel->compare) {
+                sink += kernel->compare(buf, copy, BENCH_KERNEL_BUFFER);
+            } else {
+                sink += kernel->compare_fill(zero, 0, BENCH_KERNEL_BUFFER);
             }
+            bytes += BENCH_KERNEL_BUFFER;
+            elapsed = monotonic_seconds() - start;
+        } while (elapsed < BENCH_KERNEL_SECONDS);
+        long long cycles = bench_counter_stop(cycle_fd);
+        report_bench_kernel(kernel->name, bytes, elapsed, cycles);
+        // Generators overwrite buf, the compare kernels need it equal to copy again
+        if (kernel->generate || kernel->compare_fill) {
+            pattern_fill(&key, 0, buf, BENCH_KERNEL_BUFFER);
+            memcpy(copy, buf, BENCH_KERNEL_BUFFER);
         }
-        
-        // Get capacity information
-        printf("\nCapacity Analysis:\n");
-        snprintf(cmd, sizeof(cmd), "nvme id-ns %s 2>/dev/null", device_path);
-        nvme_output = popen(cmd, "r");
-        if (nvme_output) {
-            char line[512];
-            while (fgets(line, sizeof(line), nvme_output)) {
-                if (strstr(line, "nsze") || strstr(line, "ncap") || strstr(line, "nuse")) {
-                    printf("  %s", line);
-                }
-            }
-            pclose(nvme_output);
+    }
+    // Keeps the compiler from dropping the comparisons
+    if (sink == 1) {
+        printf("\n");
+    }
+    free(buf);
+    free(copy);
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// Wipe and verify passes
+
+// Attach file to a free loop device with direct I/O, detached again when the
+// returned descriptor is closed
+static int bench_loop_attach(const char* file, char* path, size_t size) {
+    int control = open("/dev/loop-control", O_RDWR | O_CLOEXEC);
+    if (control < 0) {
+        return -errno;
+    }
+    int backing = open(file, O_RDWR | O_CLOEXEC);
+    if (backing < 0) {
+        int err = errno;
+        close(control);
+        return -err;
+    }
+    int fd = -1;
+    int err = 0;
+    // Another process can take the free device between the two calls
+    for (int attempt = 0; attempt < 8 && fd < 0; attempt++) {
+        int number = ioctl(control, LOOP_CTL_GET_FREE);
+        if (number < 0) {
+            err = errno;
+            break;
         }
-        
-        // Check for over-provisioning and firmware areas
-        printf("\nFirmware and Reserved Areas:\n");
-        snprintf(cmd, sizeof(cmd), "nvme id-ctrl %s 2>/dev/null", device_path);
-        nvme_output = popen(cmd, "r");
-        if (nvme_output) {
-            char line[512];
-            int found_fw = 0;
-            while (fgets(line, sizeof(line), nvme_output)) {
-                if (strstr(line, "firmware") || strstr(line, "Firmware") || 
-                    strstr(line, "reserved") || strstr(line, "vendor")) {
-                    printf("  %s", line);
-                    found_fw = 1;
-                }
-            }
-            pclose(nvme_output);
-            if (!found_fw) {
-                printf("  No explicit firmware reserved areas reported\n");
-            }
+        snprintf(path, size, "/dev/loop%d", number);
+        fd = open(path, O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            err = errno;
+            break;
         }
-        
-        printf("\nNote: NVMe over-provisioning and firmware areas may not be directly visible\n");
-        printf("      Some reserved areas require vendor-specific tools to analyze\n");
-        
-    } else {
-        // SATA SSDs
-        printf("Analyzing SATA SSD...\n");
-        
-        // Check if hdparm is available
-        if (system("which hdparm > /dev/null 2>&1") != 0) {
-            printf("hdparm tool not found. Install with: sudo pacman -S hdparm\n");
-            printf("Limited SATA analysis available...\n");
-        } else {
-            char cmd[512];
-            snprintf(cmd, sizeof(cmd), "hdparm -I %s 2>/dev/null | grep -i 'firmware\\|reserved\\|vendor'", device_path);
-            FILE *hdparm_output = popen(cmd, "r");
-            if (hdparm_output) {
-                char line[256];
-                int found_fw = 0;
-                printf("Firmware Information:\n");
-                while (fgets(line, sizeof(line), hdparm_output)) {
-                    printf("  %s", line);
-                    found_fw = 1;
-                }
-                pclose(hdparm_output);
-                if (!found_fw) {
-                    printf("  No explicit firmware reserved info found\n");
-                }
+        if (ioctl(fd, LOOP_SET_FD, backing) != 0) {
+            err = errno;
+            close(fd);
+            fd = -1;
+            if (err != EBUSY) {
+                break;
             }
         }
-        
-        printf("Note: SATA SSD firmware areas require vendor-specific tools for detailed analysis\n");
     }
+    close(backing);
+    close(control);
+    if (fd < 0) {
+        return -err;
+    }
+    struct loop_info64 info;
+    memset(&info, 0, sizeof(info));
+    info.lo_flags = LO_FLAGS_AUTOCLEAR;
+    ioctl(fd, LOOP_SET_STATUS64, &info);
+    ioctl(fd, LOOP_SET_DIRECT_IO, 1UL);
+    return fd;
 }
 
-void get_device_info_linux(const char* device) {
-    char path[512];
-    FILE *fp;
-    char buffer[256];
-    
-    printf("=== Storage Device Information for /dev/%s ===\n", device);
-    
-    // Check if device is rotational (HDD vs SSD)
-    snprintf(path, sizeof(path), "/sys/block/%s/queue/rotational", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            printf("Device Type: %s\n", (buffer[0] == '1') ? "HDD (Rotational)" : "SSD/Flash (Non-rotational)");
-        }
-        fclose(fp);
+static void* bench_wipe_worker_main(void* arg) {
+    struct bench_wipe_worker *worker = (struct bench_wipe_worker*)arg;
+    struct wipe_target target;
+    memset(&worker->result, 0, sizeof(worker->result));
+    int ret = wipe_open_target(worker->path, NULL, !worker->verify, &target);
+    if (ret < 0) {
+        worker->open_error = -ret;
+        return NULL;
     }
-    
-    // Get device model
-    snprintf(path, sizeof(path), "/sys/block/%s/device/model", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0; // Remove newline
-            printf("Model: %s\n", buffer);
+    wipe_latency_log = &worker->latency;
+    wipe_target_run(&target, worker->options, &worker->result, worker->verify ? &worker->check : NULL, NULL);
+    wipe_latency_log = NULL;
+    close(target.fd);
+    return NULL;
+}
+
+static int bench_compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+struct bench_wipe_row {
+    const char *target;
+    const char *pass;
+    const struct bench_wipe_case *params;
+    unsigned long long bytes;
+    double seconds;
+    double cpu_seconds;
+    long long cycles;
+    double p50;
+    double p99;
+    const char *engine;
+};
+
+static void report_bench_wipe(const struct bench_wipe_row* row) {
+    double gb_s = row->seconds > 0 ? row->bytes / row->seconds / 1e9 : 0.0;
+    double cpu_ns = row->bytes ? row->cpu_seconds * 1e9 / row->bytes : 0.0;
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "bench_wipe");
+        record_string(&rec, "target", row->target);
+        record_string(&rec, "pass", row->pass);
+        record_uint(&rec, "request_size", row->params->request_size);
+        record_int(&rec, "queue_depth", row->params->queue_depth);
+        record_int(&rec, "threads", row->params->threads);
+        record_string(&rec, "pattern", wipe_pattern_name(row->params->pattern));
+        record_string(&rec, "engine", row->engine);
+        record_uint(&rec, "bytes", row->bytes);
+        record_key(&rec, "seconds");
+        buffer_printf(&rec.buf, "%.4f", row->seconds);
+        record_key(&rec, "gb_per_second");
+        buffer_printf(&rec.buf, "%.3f", gb_s);
+        record_key(&rec, "cpu_ns_per_byte");
+        buffer_printf(&rec.buf, "%.4f", cpu_ns);
+        if (row->cycles >= 0 && row->bytes) {
+            record_key(&rec, "cycles_per_byte");
+            buffer_printf(&rec.buf, "%.4f", (double)row->cycles / row->bytes);
         }
-        fclose(fp);
+        record_key(&rec, "p50_us");
+        buffer_printf(&rec.buf, "%.1f", row->p50 * 1e6);
+        record_key(&rec, "p99_us");
+        buffer_printf(&rec.buf, "%.1f", row->p99 * 1e6);
+        record_emit(&rec);
+        return;
     }
-    
-    // Get device vendor
-    snprintf(path, sizeof(path), "/sys/block/%s/device/vendor", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            buffer[strcspn(buffer, "\n")] = 0;
-            printf("Vendor: %s\n", buffer);
-        }
-        fclose(fp);
+    char request[16];
+    char cycles[32] = "n/a";
+    if (row->params->request_size >= 1024 * 1024) {
+        snprintf(request, sizeof(request), "%zuM", row->params->request_size >> 20);
+    } else {
+        snprintf(request, sizeof(request), "%zuK", row->params->request_size >> 10);
     }
-    
-    // Get device size
-    snprintf(path, sizeof(path), "/sys/block/%s/size", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        unsigned long long sectors;
-        if (fscanf(fp, "%llu", &sectors) == 1) {
-            double size_gb = (sectors * 512.0) / (1024.0 * 1024.0 * 1024.0);
-            printf("Size: %.2f GB\n", size_gb);
-        }
-        fclose(fp);
+    if (row->cycles >= 0 && row->bytes) {
+        snprintf(cycles, sizeof(cycles), "%.3f", (double)row->cycles / row->bytes);
     }
-    
-    // Get physical block size
-    snprintf(path, sizeof(path), "/sys/block/%s/queue/physical_block_size", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        int block_size;
-        if (fscanf(fp, "%d", &block_size) == 1) {
-            printf("Physical Block Size: %d bytes\n", block_size);
-        }
-        fclose(fp);
+    printf("%-6s %-6s %7s %4d %3d %-7s %7.2f %8.3f %8s %9.1f %9.1f %s\n", row->target, row->pass, request,
+           row->params->queue_depth, row->params->threads, wipe_pattern_name(row->params->pattern),
+           gb_s, cpu_ns, cycles, row->p50 * 1e6, row->p99 * 1e6, row->engine);
+}
+
+static void report_bench_skip(const char* target, const char* reason) {
+    if (output_format != OUTPUT_TEXT) {
+        struct record rec;
+        record_begin(&rec, "bench_wipe");
+        record_string(&rec, "target", target);
+        record_string(&rec, "skipped", reason);
+        record_emit(&rec);
+        return;
     }
-    
-    // Get logical block size
-    snprintf(path, sizeof(path), "/sys/block/%s/queue/logical_block_size", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        int block_size;
-        if (fscanf(fp, "%d", &block_size) == 1) {
-            printf("Logical Block Size: %d bytes\n", block_size);
-        }
-        fclose(fp);
+    printf("%-6s skipped: %s\n", target, reason);
+}
+
+// Run the workers of one pass in parallel and report the combined numbers
+static int bench_wipe_pass(struct bench_wipe_worker* workers, int threads, int verify,
+                           const char* target_name, const struct bench_wipe_case* params, int cycle_fd) {
+    for (int i = 0; i < threads; i++) {
+        workers[i].verify = verify;
+        workers[i].open_error = 0;
+        workers[i].latency.count = 0;
+        workers[i].latency.seen = 0;
+        memset(&workers[i].check, 0, sizeof(workers[i].check));
+        workers[i].check.scratch = verify ? (unsigned char*)malloc(VERIFY_CHUNK_SIZE) : NULL;
     }
-    
-    // Check for NVMe and interface type
-    snprintf(path, sizeof(path), "/sys/block/%s", device);
-    char link_target[512];
-    ssize_t len = readlink(path, link_target, sizeof(link_target) - 1);
-    if (len != -1) {
-        link_target[len] = '\0';
-        if (strstr(link_target, "nvme")) {
-            printf("Interface: NVMe\n");
-        } else if (strstr(link_target, "ata")) {
-            printf("Interface: SATA\n");
-        } else if (strstr(link_target, "usb")) {
-            printf("Interface: USB\n");
-            printf("🔌 USB Device Detected - Performing detailed analysis...\n");
-        } else if (strstr(link_target, "mmc")) {
-            printf("Interface: MMC/SD\n");
-        } else if (strstr(link_target, "virtio")) {
-            printf("Interface: VirtIO (Virtual)\n");
+    double cpu = bench_cpu_seconds();
+    bench_counter_start(cycle_fd);
+    double start = monotonic_seconds();
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started].thread, NULL, bench_wipe_worker_main, &workers[started]) != 0) {
+            break;
         }
     }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
     
-    // Check removable status
-    snprintf(path, sizeof(path), "/sys/block/%s/removable", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            printf("Removable: %s\n", (buffer[0] == '1') ? "Yes" : "No");
+    struct bench_wipe_row row;
+    memset(&row, 0, sizeof(row));
+    row.seconds = monotonic_seconds() - start;
+    row.cycles = bench_counter_stop(cycle_fd);
+    row.cpu_seconds = bench_cpu_seconds() - cpu;
+    row.target = target_name;
+    row.pass = verify ? "verify" : "wipe";
+    row.params = params;
+    row.engine = "none";
+    
+    int status = started < threads ? 1 : 0;
+    size_t samples = 0;
+    for (int i = 0; i < started; i++) {
+        struct bench_wipe_worker *worker = &workers[i];
+        if (wipe_interrupted) {
+            status = 1;
+        } else if (worker->open_error || worker->result.error || worker->check.mismatched_blocks ||
+                   (verify && !worker->check.scratch)) {
+            printf("%s %s of %s failed: %s\n", target_name, row.pass, worker->path,
+                   worker->check.mismatched_blocks ? "pattern mismatch" :
+                   strerror(worker->open_error ? worker->open_error : worker->result.error ? worker->result.error : ENOMEM));
+            status = 1;
+        }
+        row.bytes += worker->result.bytes;
+        if (worker->result.engine) {
+            row.engine = worker->result.engine;
         }
-        fclose(fp);
+        samples += worker->latency.count;
     }
-    
-    // Check read-only status
-    snprintf(path, sizeof(path), "/sys/block/%s/ro", device);
-    fp = fopen(path, "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            printf("Read-Only: %s\n", (buffer[0] == '1') ? "Yes" : "No");
+    // Percentiles over the samples of every thread together
+    double *all = (double*)malloc((samples ? samples : 1) * sizeof(double));
+    if (all && samples) {
+        size_t n = 0;
+        for (int i = 0; i < started; i++) {
+            memcpy(all + n, workers[i].latency.samples, workers[i].latency.count * sizeof(double));
+            n += workers[i].latency.count;
         }
-        fclose(fp);
+        qsort(all, samples, sizeof(double), bench_compare_double);
+        row.p50 = all[samples / 2];
+        row.p99 = all[samples * 99 / 100 < samples ? samples * 99 / 100 : samples - 1];
     }
-    
-    // If it's a USB device, perform detailed USB analysis
-    if (len != -1 && strstr(link_target, "usb")) {
-        analyze_usb_device_details(device);
+    free(all);
+    for (int i = 0; i < threads; i++) {
+        free(workers[i].check.ranges);
+        free(workers[i].check.scratch);
     }
-    
-    // Add HPA/DCO, SMART, and firmware reserved checks
-    printf("\n");
-    check_hpa_dco_linux(device);
-    check_smart_info_linux(device);
-    check_ssd_firmware_reserved(device);
-    
-    // Show advanced security features and reserved spaces
-    if (strncmp(device, "nvme", 4) == 0) {
-        show_nvme_security_features(device);
-    } else {
-        show_sata_security_features(device);
+    if (status == 0) {
+        report_bench_wipe(&row);
     }
+    return status;
 }
 
-void get_device_info_windows() {
-#ifdef _WIN32
-    printf("=== Storage Device Information (Windows) ===\n");
-    
-    // Simple approach using basic Windows APIs
-    printf("Detecting storage devices...\n");
-    
-    // Try to get basic drive information
-    for (char drive = 'C'; drive <= 'Z'; drive++) {
-        char drive_path[4] = {drive, ':', '\\', '\0'};
-        UINT drive_type = GetDriveTypeA(drive_path);
-        
-        if (drive_type != DRIVE_NO_ROOT_DIR) {
-            printf("\nDrive %c:\\\n", drive);
-            
-            switch (drive_type) {
-                case DRIVE_FIXED:
-                    printf("  Type: Fixed Drive (HDD/SSD)\n");
-                    break;
-                case DRIVE_REMOVABLE:
-                    printf("  Type: Removable Drive\n");
-                    break;
-                case DRIVE_CDROM:
-                    printf("  Type: CD-ROM/DVD\n");
-                    break;
-                case DRIVE_RAMDISK:
-                    printf("  Type: RAM Disk\n");
-                    break;
-                case DRIVE_REMOTE:
-                    printf("  Type: Network Drive\n");
-                    break;
-                default:
-                    printf("  Type: Unknown\n");
-            }
-            
-            // Get disk space information
-            ULARGE_INTEGER free_bytes, total_bytes;
-            if (GetDiskFreeSpaceExA(drive_path, &free_bytes, &total_bytes, NULL)) {
-                double total_gb = total_bytes.QuadPart / (1024.0 * 1024.0 * 1024.0);
-                double free_gb = free_bytes.QuadPart / (1024.0 * 1024.0 * 1024.0);
-                printf("  Size: %.2f GB (%.2f GB free)\n", total_gb, free_gb);
+// Fresh sparse files, and loop devices on them, for every thread of a case
+static int bench_prepare_targets(struct bench_wipe_worker* workers, int threads, enum bench_target_kind kind,
+                                 const char* dir, unsigned long long size) {
+    for (int i = 0; i < threads; i++) {
+        struct bench_wipe_worker *worker = &workers[i];
+        snprintf(worker->file, sizeof(worker->file), "%.480s/target%d", dir, i);
+        snprintf(worker->path, sizeof(worker->path), "%s", worker->file);
+        int fd = open(worker->file, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            return -errno;
+        }
+        int ret = ftruncate(fd, (off_t)size) == 0 ? 0 : -errno;
+        close(fd);
+        if (ret < 0) {
+            return ret;
+        }
+        if (kind == BENCH_TARGET_LOOP) {
+            worker->loop_fd = bench_loop_attach(worker->file, worker->path, sizeof(worker->path));
+            if (worker->loop_fd < 0) {
+                return worker->loop_fd;
             }
         }
     }
-    
-    printf("\nNote: For detailed hardware information on Windows, run 'wmic diskdrive list full' in Command Prompt\n");
-#else
-    printf("Windows-specific function called on non-Windows platform\n");
-#endif
+    return 0;
 }
 
-void list_available_devices() {
-#ifdef _WIN32
-    get_device_info_windows();
-#else
-    printf("=== Available Storage Devices ===\n");
-    DIR *dir = opendir("/sys/block");
-    if (dir) {
-        struct dirent *entry;
-        int device_count = 0;
-        
-        while ((entry = readdir(dir)) != NULL) {
-            // Skip . and .. and loop devices, ram devices
-            if (entry->d_name[0] == '.' || strncmp(entry->d_name, "loop", 4) == 0 || 
-                strncmp(entry->d_name, "ram", 3) == 0 || strncmp(entry->d_name, "dm-", 3) == 0) {
-                continue;
-            }
-            
-            // Check if it's a real block device
-            char path[256];
-            snprintf(path, sizeof(path), "/sys/block/%s/size", entry->d_name);
-            if (access(path, R_OK) == 0) {
-                printf("Device: %s", entry->d_name);
-                
-                // Quick check for USB devices
-                char usb_path[512];
-                snprintf(usb_path, sizeof(usb_path), "/sys/block/%s", entry->d_name);
-                char link_target[512];
-                ssize_t len = readlink(usb_path, link_target, sizeof(link_target) - 1);
-                if (len != -1) {
-                    link_target[len] = '\0';
-                    if (strstr(link_target, "usb")) {
-                        printf(" [USB Device]");
-                    }
-                }
-                printf("\n");
-                
-                get_device_info_linux(entry->d_name);
-                printf("\n");
-                device_count++;
+static void bench_release_targets(struct bench_wipe_worker* workers, int threads) {
+    for (int i = 0; i < threads; i++) {
+        if (workers[i].loop_fd >= 0) {
+            ioctl(workers[i].loop_fd, LOOP_CLR_FD, 0);
+            close(workers[i].loop_fd);
+            workers[i].loop_fd = -1;
+        }
+        if (workers[i].file[0]) {
+            unlink(workers[i].file);
+            workers[i].file[0] = '\0';
+        }
+    }
+}
+
+static int bench_wipe_target(enum bench_target_kind kind, const char* base, unsigned long long size, int cycle_fd) {
+    const char *name = bench_target_names[kind];
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%.200s/sdw-bench-XXXXXX", base);
+    struct statfs fs;
+    if (kind == BENCH_TARGET_TMPFS && (statfs(base, &fs) != 0 || fs.f_type != TMPFS_MAGIC)) {
+        report_bench_skip(name, "/dev/shm is not a tmpfs mount");
+        return 0;
+    }
+    if (!mkdtemp(dir)) {
+        report_bench_skip(name, strerror(errno));
+        return 0;
+    }
+    
+    struct bench_wipe_worker workers[BENCH_MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    for (int i = 0; i < BENCH_MAX_THREADS; i++) {
+        workers[i].loop_fd = -1;
+        workers[i].latency.capacity = BENCH_LATENCY_SAMPLES;
+        workers[i].latency.samples = (double*)malloc(BENCH_LATENCY_SAMPLES * sizeof(double));
+    }
+    
+    int status = 0;
+    for (size_t c = 0; c < sizeof(bench_wipe_cases) / sizeof(bench_wipe_cases[0]) && !wipe_interrupted; c++) {
+        const struct bench_wipe_case *params = &bench_wipe_cases[c];
+        struct wipe_options options;
+        wipe_options_init(&options);
+        options.queue_depth = params->queue_depth;
+        options.request_size = params->request_size;
+        options.pattern = params->pattern;
+        if (options.pattern == WIPE_PATTERN_RANDOM && wipe_options_seed(&options) != 0) {
+            memset(&options.seed, 0x5a, sizeof(options.seed));
+        }
+        for (int i = 0; i < params->threads; i++) {
+            workers[i].options = &options;
+            if (!workers[i].latency.samples) {
+                status = 1;
             }
         }
-        closedir(dir);
-        
-        if (device_count == 0) {
-            printf("No storage devices found. Try running with sudo for better detection.\n");
-        } else {
-            printf("Total devices found: %d\n", device_count);
+        // Every thread wipes its own share, in whole MiB
+        unsigned long long share = size / params->threads / (1024 * 1024) * (1024 * 1024);
+        int ret = status ? -ENOMEM : bench_prepare_targets(workers, params->threads, kind, dir, share ? share : 1024 * 1024);
+        if (ret < 0) {
+            bench_release_targets(workers, params->threads);
+            report_bench_skip(name, strerror(-ret));
+            // No loop devices (no root, or in a container) is not a failure of the benchmark
+            status = kind == BENCH_TARGET_LOOP ? status : 1;
+            break;
         }
-        
-        printf("\nTip: If you plug in a USB device, run this program again to detect it.\n");
-        printf("     USB devices typically appear as sdb, sdc, etc. or as sd* devices.\n");
-    } else {
-        printf("Cannot access /sys/block directory\n");
+        status |= bench_wipe_pass(workers, params->threads, 0, name, params, cycle_fd);
+        if (!wipe_interrupted) {
+            status |= bench_wipe_pass(workers, params->threads, 1, name, params, cycle_fd);
+        }
+        bench_release_targets(workers, params->threads);
     }
-#endif
+    for (int i = 0; i < BENCH_MAX_THREADS; i++) {
+        free(workers[i].latency.samples);
+    }
+    rmdir(dir);
+    return status;
+}
+
+// --bench: kernels first, then the I/O sweep unless the size is 0
+static int bench_wipe_command(unsigned long long size, const char* dir) {
+    int user_only = 0;
+    int cycle_fd = bench_open_cycle_counter(&user_only);
+    pattern_dispatch_init();
+    wipe_install_signal_handlers();
+    if (output_format == OUTPUT_TEXT) {
+        printf("Cycle counter: %s\n", cycle_fd < 0 ? "unavailable (ns/B from CPU time only)" :
+               user_only ? "user space only (perf_event_paranoid)" : "user and kernel");
+        printf("\n");
+    }
+    int status = bench_kernels(cycle_fd);
+    if (size > 0) {
+        if (output_format == OUTPUT_TEXT) {
+            printf("\n=== Wipe Throughput (%llu MiB per pass, backing files in %s) ===\n", size >> 20, dir);
+            printf("%-6s %-6s %7s %4s %3s %-7s %7s %8s %8s %9s %9s %s\n", "Target", "Pass", "Request", "QD",
+                   "Thr", "Pattern", "GB/s", "CPU ns/B", "Cycles/B", "p50 us", "p99 us", "Engine");
+        }
+        status |= bench_wipe_target(BENCH_TARGET_TMPFS, "/dev/shm", size, cycle_fd);
+        status |= bench_wipe_target(BENCH_TARGET_SPARSE, dir, size, cycle_fd);
+        status |= bench_wipe_target(BENCH_TARGET_LOOP, dir, size, cycle_fd);
+    }
+    if (cycle_fd >= 0) {
+        close(cycle_fd);
+    }
+    if (wipe_interrupted) {
+        printf("Benchmark interrupted\n");
+        return 1;
+    }
+    return status;
 }
+#endif
 
 void print_usage(const char* program_name) {
     printf("Usage: %s [device_name] [options]\n\n", program_name);
@@ -1236,12 +8862,47 @@ void print_usage(const char* program_name) {
     printf("  device_name    Specific device to analyze (Linux only, e.g., sda, nvme0n1)\n");
     printf("  -w, --watch    Monitor for new USB devices (Linux only)\n");
     printf("  -u, --usb      List all USB devices including mobile phones\n");
+    printf("  -j, --jobs N   Probe N devices in parallel (0 = one worker per device)\n");
+    printf("  --replay-uevents FILE  Run the monitor on uevents recorded in FILE\n");
+    printf("  --format F     Scan output: text (default), ndjson or binary records\n");
+    printf("  --sysfs-root D Read device attributes from D instead of /sys\n");
+    printf("  --usb-ids FILE USB vendor/product names from FILE (default: <state dir>/usb.ids, then hwdata)\n");
+    printf("  --trace FILE   Write the time spent in every probe stage to FILE (Chrome trace / Perfetto JSON)\n");
+    printf("  --bench-scan N,...  Time the block and USB scans on synthetic trees of N devices\n");
+    printf("  --bench        Time the pattern kernels and the wipe/verify passes on tmpfs, sparse and loop targets\n");
+    printf("  --bench-size S Bytes per benchmark pass (default 128M, 0 = kernels only)\n");
+    printf("  --bench-dir D  Directory of the sparse and loop backing files (default /var/tmp)\n");
+    printf("  --wipe         Overwrite the given device or file (Linux, io_uring + O_DIRECT)\n");
+    printf("  --sanitize M   Wipe with device commands instead of writes: auto, secure-discard, discard,\n");
+    printf("                 zeroout, or write-same / unmap on SCSI disks\n");
+    printf("  --confirm T    Required with --wipe, must repeat the target exactly (once per target)\n");
+    printf("  --streams N    With several targets: at most N wipes at once (default: per-group limits)\n");
+    printf("  --group-streams N  Concurrent wipes per USB hub / PCIe root port / controller\n");
+    printf("  --queue-depth N   Writes kept in flight while wiping (default 32)\n");
+    printf("  --request-size S  Bytes per write, K/M suffixes allowed (default 1M)\n");
+    printf("  --verify       Read the target back and check it holds the pattern (after --wipe)\n");
+    printf("  --verify-sample C  Verify a random sample instead, sized for C%% confidence (e.g. 99.9)\n");
+    printf("  --sample-tolerance P  Percent of the target a sampled verify may miss (default 0.01)\n");
+    printf("  --pattern P    Wipe pattern: zero (default), ones, random or hex:BYTES\n");
+    printf("  --checkpoint-interval S  Seconds between resume checkpoints of a wipe (default 30, 0 = off)\n");
+    printf("  --status-interval S  Seconds between wipe status lines (default 5, 0 = off)\n");
+    printf("  --metrics FILE Keep wipe metrics in FILE as a node_exporter textfile (.prom)\n");
+    printf("  --seed HEX     Seed of the random pattern (default: fresh from /dev/urandom)\n");
+    printf("  --refresh      Ignore the inventory cache and re-probe identify data\n");
+    printf("  --state-dir D  Directory of the inventory cache (default /var/lib/secure-data-wiping)\n");
     printf("  -h, --help     Show this help message\n\n");
     printf("Examples:\n");
     printf("  %s              # Show all storage devices\n", program_name);
     printf("  %s sda          # Show info for /dev/sda (Linux)\n", program_name);
     printf("  %s nvme0n1      # Show info for /dev/nvme0n1 (Linux)\n", program_name);
     printf("  %s --usb        # List all USB devices including mobile phones\n", program_name);
+    printf("  %s --jobs 8     # Scan all devices with 8 parallel probes (Linux)\n", program_name);
+    printf("  %s --format ndjson  # One JSON record per device for fleet collectors\n", program_name);
+    printf("  %s sdb --wipe --confirm sdb  # Overwrite /dev/sdb with zeros (Linux)\n", program_name);
+    printf("  %s sdb --verify --pattern ones   # Check /dev/sdb holds only 0xff bytes\n", program_name);
+    printf("  %s sdb --verify-sample 99.9      # Spot-check /dev/sdb in minutes instead of hours\n", program_name);
+    printf("  %s sdb --sanitize auto --verify --confirm sdb  # Secure discard or zero-out, then read back\n", program_name);
+    printf("  %s sdb sdc --wipe --confirm sdb --confirm sdc  # Wipe both, scheduled by topology\n", program_name);
     printf("  %s --watch      # Monitor for USB device changes (Linux)\n\n", program_name);
     printf("Supported Information:\n");
     printf("  - Device Type (HDD/SSD/NVMe)\n");
@@ -1256,81 +8917,869 @@ void print_usage(const char* program_name) {
     printf("  - DCO (Device Configuration Overlay) Detection\n");
     printf("  - Security Features Analysis\n");
     printf("  - SMART Health Status\n");
-    printf("\nNote: HPA/DCO detection requires root privileges and hdparm/smartctl tools.\n");
+    printf("\nNote: HPA/DCO detection requires root privileges (ATA pass-through via SG_IO).\n");
+    printf("      SMART is read natively from ATA/NVMe drives, smartctl is used for others.\n");
     printf("      Mobile device analysis may require ADB for Android devices.\n");
 }
 
-void monitor_usb_devices() {
-#ifndef _WIN32
+#ifdef __linux__
+#define MONITOR_UEVENT_RCVBUF   (4 * 1024 * 1024)
+
+// One kernel uevent, parsed from a NETLINK_KOBJECT_UEVENT message or a replay file
+struct uevent {
+    char action[16];
+    char subsystem[32];
+    char devtype[32];
+    char devname[256];
+    char devpath[512];
+};
+
+static void uevent_set_property(struct uevent* event, const char* property) {
+    const char *value = strchr(property, '=');
+    if (!value) {
+        return;
+    }
+    size_t key_len = value - property;
+    value++;
+    
+    if (key_len == 6 && strncmp(property, "ACTION", 6) == 0) {
+        snprintf(event->action, sizeof(event->action), "%s", value);
+    } else if (key_len == 9 && strncmp(property, "SUBSYSTEM", 9) == 0) {
+        snprintf(event->subsystem, sizeof(event->subsystem), "%s", value);
+    } else if (key_len == 7 && strncmp(property, "DEVTYPE", 7) == 0) {
+        snprintf(event->devtype, sizeof(event->devtype), "%s", value);
+    } else if (key_len == 7 && strncmp(property, "DEVNAME", 7) == 0) {
+        // DEVNAME may be given relative to /dev or as a full path
+        if (strncmp(value, "/dev/", 5) == 0) {
+            value += 5;
+        }
+        snprintf(event->devname, sizeof(event->devname), "%s", value);
+    } else if (key_len == 7 && strncmp(property, "DEVPATH", 7) == 0) {
+        snprintf(event->devpath, sizeof(event->devpath), "%s", value);
+    }
+}
+
+// Kernel uevents are "action@devpath" followed by NUL separated KEY=VALUE pairs
+static int parse_uevent(const char* buffer, size_t len, struct uevent* event) {
+    memset(event, 0, sizeof(*event));
+    if (len == 0 || !memchr(buffer, '@', strnlen(buffer, len))) {
+        return -1;
+    }
+    
+    size_t pos = strnlen(buffer, len) + 1;
+    while (pos < len) {
+        const char *property = buffer + pos;
+        size_t property_len = strnlen(property, len - pos);
+        if (property_len < len - pos) {
+            uevent_set_property(event, property);
+        }
+        pos += property_len + 1;
+    }
+    return (event->action[0] && event->subsystem[0]) ? 0 : -1;
+}
+
+// Only whole disks and USB devices (not partitions or interfaces) matter
+static int uevent_is_relevant(const struct uevent* event) {
+    if (strcmp(event->action, "add") != 0 && strcmp(event->action, "remove") != 0 &&
+        strcmp(event->action, "change") != 0) {
+        return 0;
+    }
+    if (strcmp(event->subsystem, "block") == 0) {
+        return strcmp(event->devtype, "disk") == 0;
+    }
+    if (strcmp(event->subsystem, "usb") == 0) {
+        return strcmp(event->devtype, "usb_device") == 0;
+    }
+    return 0;
+}
+
+// Devices known to the monitor, kept up to date from uevents so that a
+// hotplug event only probes the device it is about
+struct monitor_inventory {
+    struct device_profile **devices;
+    int count;
+    int cap;
+};
+
+static int monitor_find(const struct monitor_inventory* inv, const char* name) {
+    for (int i = 0; i < inv->count; i++) {
+        if (strcmp(inv->devices[i]->name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static struct device_profile* monitor_probe(const char* name) {
+    struct device_profile *profile = (struct device_profile*)malloc(sizeof(struct device_profile));
+    if (profile) {
+        probe_device_profile(name, profile);
+    }
+    return profile;
+}
+
+static void monitor_insert(struct monitor_inventory* inv, struct device_profile* profile) {
+    if (inv->count == inv->cap) {
+        int new_cap = inv->cap ? inv->cap * 2 : 16;
+        struct device_profile **grown = (struct device_profile**)realloc(inv->devices, new_cap * sizeof(*grown));
+        if (!grown) {
+            free(profile);
+            return;
+        }
+        inv->devices = grown;
+        inv->cap = new_cap;
+    }
+    inv->devices[inv->count++] = profile;
+}
+
+static void monitor_inventory_init(struct monitor_inventory* inv) {
+    char (*devices)[256] = NULL;
+    memset(inv, 0, sizeof(*inv));
+    
+    int device_count = collect_block_devices(&devices);
+    for (int i = 0; i < device_count; i++) {
+        struct device_profile *profile = monitor_probe(devices[i]);
+        if (profile) {
+            monitor_insert(inv, profile);
+        }
+    }
+    free(devices);
+    inventory_cache_save();
+}
+
+static void monitor_inventory_free(struct monitor_inventory* inv) {
+    for (int i = 0; i < inv->count; i++) {
+        free(inv->devices[i]);
+    }
+    free(inv->devices);
+    memset(inv, 0, sizeof(*inv));
+}
+
+// One line summary of a device for delta records
+static void print_device_summary(const struct device_profile* profile) {
+    const char *serial = profile->nvme_ctrl.valid ? profile->nvme_ctrl.serial :
+                         profile->ata.valid ? profile->ata.serial : "";
+    static const char *interface_names[] = { "unknown", "NVMe", "SATA", "USB", "MMC/SD", "VirtIO" };
+    
+    printf("model=\"%s\"", profile->model);
+    if (serial[0]) {
+        printf(" serial=\"%s\"", serial);
+    }
+    if (profile->sectors >= 0) {
+        printf(" size=%.2fGB", (profile->sectors * 512.0) / (1024.0 * 1024.0 * 1024.0));
+    }
+    printf(" interface=%s removable=%d ro=%d\n", interface_names[profile->interface],
+           profile->removable, profile->read_only);
+}
+
+// Print the attributes that differ between two probes of the same device;
+// with print 0 they are only counted
+static int print_profile_changes(const struct device_profile* old_profile, const struct device_profile* new_profile,
+                                 int print) {
+    int changes = 0;
+    if (old_profile->sectors != new_profile->sectors) {
+        if (print) {
+            printf("  size: %lld -> %lld sectors\n", old_profile->sectors, new_profile->sectors);
+        }
+        changes++;
+    }
+    if (old_profile->read_only != new_profile->read_only) {
+        if (print) {
+            printf("  read-only: %d -> %d\n", old_profile->read_only, new_profile->read_only);
+        }
+        changes++;
+    }
+    if (old_profile->removable != new_profile->removable) {
+        if (print) {
+            printf("  removable: %d -> %d\n", old_profile->removable, new_profile->removable);
+        }
+        changes++;
+    }
+    if (strcmp(old_profile->model, new_profile->model) != 0) {
+        if (print) {
+            printf("  model: \"%s\" -> \"%s\"\n", old_profile->model, new_profile->model);
+        }
+        changes++;
+    }
+    if (old_profile->smart.passed != new_profile->smart.passed) {
+        if (print) {
+            printf("  SMART assessment: %d -> %d\n", old_profile->smart.passed, new_profile->smart.passed);
+        }
+        changes++;
+    }
+    return changes;
+}
+
+static void monitor_handle_block_event(struct monitor_inventory* inv, const struct uevent* event) {
+    const char *name = event->devname;
+    if (!name[0]) {
+        // Fall back to the last DEVPATH component
+        const char *slash = strrchr(event->devpath, '/');
+        name = slash ? slash + 1 : event->devpath;
+    }
+    if (!name[0]) {
+        return;
+    }
+    int index = monitor_find(inv, name);
+    
+    if (strcmp(event->action, "remove") == 0) {
+        if (index < 0) {
+            return;
+        }
+        printf("\n[delta] remove %s ", name);
+        print_device_summary(inv->devices[index]);
+        free(inv->devices[index]);
+        inv->devices[index] = inv->devices[--inv->count];
+        return;
+    }
+    
+    int blocks_fd = sysfs_open_dir("block");
+    int scannable = blocks_fd >= 0 && is_scannable_block_device(blocks_fd, name);
+    if (blocks_fd >= 0) {
+        close(blocks_fd);
+    }
+    if (!scannable) {
+        return;
+    }
+    struct device_profile *profile = monitor_probe(name);
+    if (!profile) {
+        return;
+    }
+    
+    if (index < 0) {
+        printf("\n[delta] add %s ", name);
+        print_device_summary(profile);
+        printf("\n");
+        report_device_profile(profile);
+        monitor_insert(inv, profile);
+    } else {
+        printf("\n[delta] change %s ", name);
+        print_device_summary(profile);
+        if (print_profile_changes(inv->devices[index], profile, 1) == 0) {
+            printf("  no attribute changes\n");
+        }
+        free(inv->devices[index]);
+        inv->devices[index] = profile;
+    }
+    inventory_cache_save();
+}
+
+// The uevent socket overflowed and events were lost: probe every device
+// again and report what differs from the inventory
+static void monitor_resync(struct monitor_inventory* inv) {
+    printf("\n[resync] uevents were lost (socket buffer overflow), rescanning all devices\n");
+    usb_topology_invalidate();
+    struct monitor_inventory current;
+    monitor_inventory_init(&current);
+    
+    for (int i = 0; i < inv->count; i++) {
+        if (monitor_find(&current, inv->devices[i]->name) < 0) {
+            printf("\n[delta] remove %s ", inv->devices[i]->name);
+            print_device_summary(inv->devices[i]);
+        }
+    }
+    for (int i = 0; i < current.count; i++) {
+        const struct device_profile *profile = current.devices[i];
+        int index = monitor_find(inv, profile->name);
+        if (index < 0) {
+            printf("\n[delta] add %s ", profile->name);
+            print_device_summary(profile);
+            printf("\n");
+            report_device_profile(profile);
+        } else if (print_profile_changes(inv->devices[index], profile, 0) > 0) {
+            printf("\n[delta] change %s ", profile->name);
+            print_device_summary(profile);
+            print_profile_changes(inv->devices[index], profile, 1);
+        }
+    }
+    monitor_inventory_free(inv);
+    *inv = current;
+    printf("\nTracking %d storage devices\n", inv->count);
+    printf("\nContinuing to monitor...\n");
+    fflush(stdout);
+}
+
+static void monitor_handle_uevent(struct monitor_inventory* inv, const struct uevent* event) {
+    // The bus just changed, probes below must not see the old snapshot
+    usb_topology_invalidate();
+    if (strcmp(event->subsystem, "block") == 0) {
+        monitor_handle_block_event(inv, event);
+    } else {
+        // USB devices without storage (phones, hubs) only get a delta line;
+        // their block devices arrive as separate block events
+        printf("\n[delta] %s usb %s\n", event->action, event->devpath);
+        if (strcmp(event->action, "remove") != 0) {
+            const struct usb_topology *topology = usb_topology_get();
+            const char *slash = strrchr(event->devpath, '/');
+            int index = topology ? usb_topology_find(topology, slash ? slash + 1 : event->devpath) : -1;
+            if (index >= 0) {
+                printf("  id=%s:%s\n", topology->devices[index].vendor_id, topology->devices[index].product_id);
+            }
+        }
+    }
+    printf("\nContinuing to monitor...\n");
+    fflush(stdout);
+}
+
+// Feed uevents recorded as KEY=VALUE lines (blank line between events, e.g.
+// the output of "udevadm monitor --kernel --property") through the monitor
+static void replay_uevents(struct monitor_inventory* inv, const char* replay_path) {
+    FILE *fp = fopen(replay_path, "r");
+    if (!fp) {
+        printf("Cannot open uevent replay file %s\n", replay_path);
+        return;
+    }
+    
+    char line[1024];
+    struct uevent event;
+    int have_properties = 0;
+    memset(&event, 0, sizeof(event));
+    
+    while (1) {
+        int at_end = fgets(line, sizeof(line), fp) == NULL;
+        if (!at_end) {
+            line[strcspn(line, "\r\n")] = 0;
+        }
+        if (at_end || line[0] == '\0') {
+            if (have_properties && uevent_is_relevant(&event)) {
+                monitor_handle_uevent(inv, &event);
+            }
+            memset(&event, 0, sizeof(event));
+            have_properties = 0;
+            if (at_end) {
+                break;
+            }
+            continue;
+        }
+        if (strchr(line, '=')) {
+            uevent_set_property(&event, line);
+            have_properties = 1;
+        }
+    }
+    fclose(fp);
+}
+#endif
+
+void monitor_usb_devices(const char* replay_path) {
+#ifdef __linux__
     printf("=== USB Device Monitor ===\n");
+    
+    struct monitor_inventory inv;
+    monitor_inventory_init(&inv);
+    printf("Tracking %d storage devices\n", inv.count);
+    
+    if (replay_path) {
+        printf("Replaying uevents from %s\n", replay_path);
+        replay_uevents(&inv, replay_path);
+        monitor_inventory_free(&inv);
+        return;
+    }
+    
     printf("Monitoring for USB storage device changes... (Press Ctrl+C to stop)\n\n");
+    fflush(stdout);
     
-    // Store initial device list
-    system("ls /sys/block/ > /tmp/initial_devices.txt 2>/dev/null");
+    int uevent_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (uevent_fd < 0) {
+        printf("Cannot open uevent socket: %s\n", strerror(errno));
+        monitor_inventory_free(&inv);
+        return;
+    }
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid = 0;
+    addr.nl_groups = 1; // kernel uevents
+    if (bind(uevent_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("Cannot bind uevent socket: %s\n", strerror(errno));
+        close(uevent_fd);
+        monitor_inventory_free(&inv);
+        return;
+    }
+    // Probing blocks the loop; a burst of hotplugs (a hub full of sticks)
+    // must fit into the socket buffer meanwhile. SO_RCVBUFFORCE needs
+    // CAP_NET_ADMIN and goes past rmem_max.
+    int rcvbuf = MONITOR_UEVENT_RCVBUF;
+    if (setsockopt(uevent_fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        setsockopt(uevent_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
     
-    while (1) {
-        sleep(2); // Check every 2 seconds
-        
-        // Get current device list
-        system("ls /sys/block/ > /tmp/current_devices.txt 2>/dev/null");
-        
-        // Compare with initial list
-        int result = system("diff /tmp/initial_devices.txt /tmp/current_devices.txt > /dev/null 2>&1");
+    // Ctrl+C is delivered through a signalfd so the loop can exit cleanly
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    int signal_fd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+    
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        printf("Cannot create epoll instance: %s\n", strerror(errno));
+        close(uevent_fd);
+        if (signal_fd >= 0) {
+            close(signal_fd);
+        }
+        monitor_inventory_free(&inv);
+        return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = uevent_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, uevent_fd, &ev);
+    if (signal_fd >= 0) {
+        ev.data.fd = signal_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev);
+    }
+    
+    int running = 1;
+    while (running) {
+        // Block until the kernel reports something
+        struct epoll_event events[4];
+        int ready = epoll_wait(epoll_fd, events, 4, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
         
-        if (result != 0) {
-            printf("\n*** Device change detected! ***\n");
-            system("ls /sys/block/");
-            printf("\nUpdated device list:\n");
-            list_available_devices();
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.fd == signal_fd) {
+                // Consume the signal so it is not delivered once unblocked
+                struct signalfd_siginfo info;
+                while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+                }
+                running = 0;
+                continue;
+            }
             
-            // Update initial list
-            system("cp /tmp/current_devices.txt /tmp/initial_devices.txt");
-            printf("\nContinuing to monitor...\n");
+            char buffer[8192];
+            while (1) {
+                ssize_t len = recv(uevent_fd, buffer, sizeof(buffer) - 1, 0);
+                if (len < 0 && errno == ENOBUFS) {
+                    // The error is reported once; later events are queued again
+                    monitor_resync(&inv);
+                    continue;
+                }
+                if (len < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (len <= 0) {
+                    break;
+                }
+                buffer[len] = '\0';
+                struct uevent event;
+                if (parse_uevent(buffer, (size_t)len, &event) == 0 && uevent_is_relevant(&event)) {
+                    monitor_handle_uevent(&inv, &event);
+                }
+            }
         }
     }
+    
+    printf("\nStopping USB device monitor.\n");
+    inventory_cache_save();
+    close(epoll_fd);
+    close(uevent_fd);
+    if (signal_fd >= 0) {
+        close(signal_fd);
+    }
+    pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+    monitor_inventory_free(&inv);
 #else
-    printf("USB monitoring not supported on Windows platform.\n");
+    (void)replay_path;
+    printf("USB monitoring not supported on this platform.\n");
     printf("Use Device Manager to monitor USB device changes.\n");
 #endif
 }
 
-int main(int argc, char* argv[]) {
+static void print_banner(void) {
     printf("Hardware Storage Device Detection Tool\n");
     printf("=====================================\n\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* device = NULL;
+    int show_usb = 0;
+    int watch = 0;
+    int refresh = 0;
+    const char* replay_path = NULL;
+    const char* bench_sizes = NULL;
+    int bench = 0;
+    int wipe = 0;
+    int verify = 0;
+    int wipe_streams = 0;
+    int group_streams = 0;
+    // Positional targets and --confirm values, for wiping several devices at once
+    const char** targets = (const char**)calloc(argc, sizeof(const char*));
+    const char** confirms = (const char**)calloc(argc, sizeof(const char*));
+    int target_count = 0;
+    int confirm_count = 0;
+    if (!targets || !confirms) {
+        printf("Out of memory\n");
+        return 1;
+    }
+#ifdef __linux__
+    struct wipe_options wipe_options;
+    wipe_options_init(&wipe_options);
+    unsigned long long bench_size = BENCH_DEFAULT_WIPE_SIZE;
+    const char* bench_dir = BENCH_DEFAULT_DIR;
+#endif
     
-    // Check for help flags
-    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
-        print_usage(argv[0]);
-        return 0;
+    for (int i = 1; i < argc; i++) {
+        // Check for help flags
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_banner();
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "-u") == 0 || strcmp(argv[i], "--usb") == 0) {
+            show_usb = 1;
+        } else if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--watch") == 0) {
+            watch = 1;
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            long jobs = strtol(argv[++i], &end, 10);
+            if (*argv[i] == '\0' || *end != '\0' || jobs < 0 || jobs > 1024) {
+                printf("Invalid job count: %s\n", argv[i]);
+                return 1;
+            }
+            scan_jobs = (int)jobs;
+        } else if (strcmp(argv[i], "--replay-uevents") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            replay_path = argv[++i];
+            watch = 1;
+        } else if (strcmp(argv[i], "--format") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            i++;
+            if (strcmp(argv[i], "text") == 0) {
+                output_format = OUTPUT_TEXT;
+            } else if (strcmp(argv[i], "ndjson") == 0) {
+                output_format = OUTPUT_NDJSON;
+            } else if (strcmp(argv[i], "binary") == 0) {
+                output_format = OUTPUT_BINARY;
+            } else {
+                printf("Invalid output format: %s (expected text, ndjson or binary)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--wipe") == 0) {
+            wipe = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if (strcmp(argv[i], "--confirm") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            confirms[confirm_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--streams") == 0 || strcmp(argv[i], "--group-streams") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            const char *option = argv[i];
+            long streams = strtol(argv[++i], &end, 10);
+            if (*argv[i] == '\0' || *end != '\0' || streams < 1 || streams > 1024) {
+                printf("Invalid stream count for %s: %s\n", option, argv[i]);
+                return 1;
+            }
+            if (strcmp(option, "--streams") == 0) {
+                wipe_streams = (int)streams;
+            } else {
+                group_streams = (int)streams;
+            }
+#ifdef __linux__
+        } else if (strcmp(argv[i], "--queue-depth") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            long depth = strtol(argv[++i], &end, 10);
+            if (*argv[i] == '\0' || *end != '\0' || depth < 1 || depth > WIPE_MAX_QUEUE_DEPTH) {
+                printf("Invalid queue depth: %s (1-%d)\n", argv[i], WIPE_MAX_QUEUE_DEPTH);
+                return 1;
+            }
+            wipe_options.queue_depth = (int)depth;
+        } else if (strcmp(argv[i], "--request-size") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            unsigned long long size = 0;
+            if (parse_size_arg(argv[++i], &size) != 0 || size == 0 || size > WIPE_MAX_REQUEST_SIZE) {
+                printf("Invalid request size: %s (up to 64M)\n", argv[i]);
+                return 1;
+            }
+            wipe_options.request_size = size;
+        } else if (strcmp(argv[i], "--pattern") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            i++;
+            if (strcmp(argv[i], "zero") == 0) {
+                wipe_options.pattern = WIPE_PATTERN_ZERO;
+            } else if (strcmp(argv[i], "ones") == 0) {
+                wipe_options.pattern = WIPE_PATTERN_ONES;
+            } else if (strcmp(argv[i], "random") == 0) {
+                wipe_options.pattern = WIPE_PATTERN_RANDOM;
+            } else if (strncmp(argv[i], "hex:", 4) == 0 && parse_repeat_pattern(argv[i] + 4, &wipe_options) == 0) {
+                wipe_options.pattern = WIPE_PATTERN_REPEAT;
+            } else {
+                printf("Invalid pattern: %s (expected zero, ones, random or hex:BYTES)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            if (pattern_key_parse(argv[++i], &wipe_options.seed) != 0) {
+                printf("Invalid seed: %s (1-64 hex digits)\n", argv[i]);
+                return 1;
+            }
+            wipe_options.seed_given = 1;
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            long interval = strtol(argv[++i], &end, 10);
+            if (*argv[i] == '\0' || *end != '\0' || interval < 0 || interval > 86400) {
+                printf("Invalid checkpoint interval: %s (0-86400 seconds)\n", argv[i]);
+                return 1;
+            }
+            wipe_options.checkpoint_interval = (int)interval;
+        } else if (strcmp(argv[i], "--status-interval") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            long interval = strtol(argv[++i], &end, 10);
+            if (*argv[i] == '\0' || *end != '\0' || interval < 0 || interval > 86400) {
+                printf("Invalid status interval: %s (0-86400 seconds)\n", argv[i]);
+                return 1;
+            }
+            wipe_options.status_interval = (int)interval;
+        } else if (strcmp(argv[i], "--verify-sample") == 0 || strcmp(argv[i], "--sample-tolerance") == 0) {
+            char *end = NULL;
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            const char *option = argv[i];
+            double percent = strtod(argv[++i], &end);
+            if (*argv[i] == '\0' || (*end != '\0' && strcmp(end, "%") != 0) || !(percent > 0 && percent < 100)) {
+                printf("Invalid percentage for %s: %s (between 0 and 100, exclusive)\n", option, argv[i]);
+                return 1;
+            }
+            if (strcmp(option, "--verify-sample") == 0) {
+                wipe_options.sample_confidence = percent;
+                verify = 1;
+            } else {
+                wipe_options.sample_tolerance = percent;
+            }
+        } else if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            wipe_options.metrics_path = argv[++i];
+        } else if (strcmp(argv[i], "--sanitize") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            i++;
+            if (strcmp(argv[i], "auto") == 0) {
+                wipe_options.method = WIPE_METHOD_AUTO;
+            } else if (strcmp(argv[i], "secure-discard") == 0) {
+                wipe_options.method = WIPE_METHOD_SECURE_DISCARD;
+            } else if (strcmp(argv[i], "discard") == 0) {
+                wipe_options.method = WIPE_METHOD_DISCARD;
+            } else if (strcmp(argv[i], "zeroout") == 0) {
+                wipe_options.method = WIPE_METHOD_ZEROOUT;
+            } else if (strcmp(argv[i], "write-same") == 0) {
+                wipe_options.method = WIPE_METHOD_WRITE_SAME;
+                scsi_probe_usb = 1;
+            } else if (strcmp(argv[i], "unmap") == 0) {
+                wipe_options.method = WIPE_METHOD_UNMAP;
+                scsi_probe_usb = 1;
+            } else {
+                printf("Invalid sanitize method: %s (expected auto, secure-discard, discard, zeroout, "
+                       "write-same or unmap)\n", argv[i]);
+                return 1;
+            }
+            wipe = 1;
+        } else if (strcmp(argv[i], "--bench-size") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            if (parse_size_arg(argv[++i], &bench_size) != 0) {
+                printf("Invalid benchmark size: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bench-dir") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            bench_dir = argv[++i];
+#endif
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+#ifndef _WIN32
+            trace_start(argv[++i]);
+#else
+            i++;
+#endif
+        } else if (strcmp(argv[i], "--sysfs-root") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            snprintf(sysfs_root, sizeof(sysfs_root), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "--usb-ids") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            snprintf(usb_ids_path, sizeof(usb_ids_path), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "--bench-scan") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            bench_sizes = argv[++i];
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = 1;
+        } else if (strcmp(argv[i], "--refresh") == 0) {
+            refresh = 1;
+        } else if (strcmp(argv[i], "--state-dir") == 0) {
+            if (i + 1 >= argc) {
+                printf("Missing value for %s\n", argv[i]);
+                return 1;
+            }
+            snprintf(state_dir, sizeof(state_dir), "%s", argv[++i]);
+        } else if (argv[i][0] == '-') {
+            printf("Unknown option: %s\n\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            device = argv[i];
+            targets[target_count++] = argv[i];
+        }
+    }
+    
+    // Structured output goes to collectors, keep the stream free of banners and notes
+    int structured = output_format != OUTPUT_TEXT && !watch;
+    if (structured) {
+#ifndef _WIN32
+        gethostname(record_host, sizeof(record_host) - 1);
+#endif
+    } else {
+        output_format = OUTPUT_TEXT;
+        print_banner();
+    }
+    
+    if (bench_sizes || bench) {
+#ifdef __linux__
+        return bench_sizes ? bench_scan_command(bench_sizes) : bench_wipe_command(bench_size, bench_dir);
+#else
+        printf("Benchmarks are only supported on Linux\n");
+        return 1;
+#endif
     }
     
     // Check for USB devices flag
-    if (argc > 1 && (strcmp(argv[1], "-u") == 0 || strcmp(argv[1], "--usb") == 0)) {
+    if (show_usb) {
         list_all_usb_devices();
         return 0;
     }
     
+#ifndef _WIN32
+    inventory_cache_open(refresh);
+#endif
+    
+    // Overwriting is destructive, the target has to be named twice
+    if (wipe || verify) {
+#ifdef __linux__
+        if (!device) {
+            printf("%s needs a target device or file\n", wipe ? "--wipe" : "--verify");
+            return 1;
+        }
+        // Sanitizing leaves zeroes behind, which is what --verify then checks
+        if (wipe_options.method != WIPE_METHOD_OVERWRITE && wipe_options.pattern != WIPE_PATTERN_ZERO) {
+            printf("--pattern does not apply to --sanitize, the device is left holding zeroes\n");
+            return 1;
+        }
+        for (int t = 0; wipe && t < target_count; t++) {
+            int confirmed = 0;
+            for (int c = 0; c < confirm_count; c++) {
+                confirmed |= strcmp(confirms[c], targets[t]) == 0;
+            }
+            if (!confirmed) {
+                printf("Refusing to wipe %s: repeat the target with --confirm %s to destroy all data on it\n",
+                       targets[t], targets[t]);
+                return 1;
+            }
+        }
+        wipe_install_signal_handlers();
+        if (target_count > 1) {
+            return wipe_schedule_command(targets, target_count, &wipe_options, wipe, verify,
+                                         wipe_streams, group_streams);
+        }
+        return wipe_command(device, &wipe_options, wipe, verify);
+#else
+        printf("Wiping is only supported on Linux\n");
+        return 1;
+#endif
+    }
+    
     // Check for watch/monitor flag
-    if (argc > 1 && (strcmp(argv[1], "-w") == 0 || strcmp(argv[1], "--watch") == 0)) {
-        monitor_usb_devices();
+    if (watch) {
+        monitor_usb_devices(replay_path);
         return 0;
     }
     
 #ifdef _WIN32
     list_available_devices();
 #else
-    if (argc > 1) {
+    if (device) {
         // If device specified, show info for that device only
-        get_device_info_linux(argv[1]);
+        get_device_info_linux(device);
+        inventory_cache_save();
     } else {
         // Show all available devices
         list_available_devices();
+        inventory_cache_save();
         // Also show USB devices summary
-        printf("\n");
+        if (!structured) {
+            printf("\n");
+        }
         list_all_usb_devices();
     }
 #endif
     
+    if (structured) {
+        return 0;
+    }
     printf("\nNote: Some information may require elevated privileges (sudo) to access.\n");
     printf("      USB devices will be automatically detected when plugged in.\n");
     printf("      Use --usb option to see detailed USB device analysis.\n");